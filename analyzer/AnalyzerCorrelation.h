@@ -0,0 +1,275 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+#ifndef ANALYZER_CORRELATION_H
+#define ANALYZER_CORRELATION_H
+/**
+* @file
+*
+* @class AnalyzerCorrelation
+*
+* @brief Autocorrelation functions and integrated correlation times of the chain
+* conformation and of the height of selected monomers.
+*
+* @details Every call of execute() adds one sample of
+* - the end-to-end vector between the first and the last monomer,
+* - the squared radius of gyration of all monomers,
+* - the z coordinate of every selected monomer
+* to a MultiTauCorrelator each, so the analyzer can run for the whole simulation in
+* memory growing with the logarithm of the number of samples. In cleanup() the
+* normalized autocorrelation functions are written with the lag in mcs, and the
+* integrated correlation times in mcs are written to the comment of the file and to
+* stdout. They give the relaxation time and the decorrelation interval between two
+* force probes.
+*
+* The samples are assumed to be taken at a constant interval, which is taken from the
+* ages of the first and the last sample.
+*
+* @tparam IngredientsType
+**/
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/analyzer/AbstractAnalyzer.h>
+#include <LeMonADE/utility/ResultFormattingTools.h>
+
+#include "MultiTauCorrelator.h"
+
+
+template<class IngredientsType>
+class AnalyzerCorrelation: public AbstractAnalyzer
+{
+public:
+
+    AnalyzerCorrelation(const IngredientsType& ing_, std::vector<uint32_t> monomers_, uint64_t begCal_=0, const std::string& filename_="correlation.dat");
+
+    virtual void initialize();
+    virtual bool execute();
+    virtual void cleanup();
+
+    //! output file of the results, correlation.dat by default
+    void setFilename(const std::string& filename_){ filename=filename_; }
+    const std::string& getFilename() const { return filename; }
+
+    //! correlator of the end-to-end vector
+    const MultiTauCorrelator& getEndToEndCorrelator() const { return endToEnd; }
+    //! correlator of the squared radius of gyration
+    const MultiTauCorrelator& getGyrationCorrelator() const { return gyration; }
+    //! correlator of the z coordinate of selected monomer i
+    const MultiTauCorrelator& getHeightCorrelator(uint32_t i) const { return heights.at(i); }
+
+    //! number of mcs between two samples
+    double getSampleInterval() const;
+
+    //! write the current correlation functions to the output file
+    void writeResults() const;
+
+    //! integrated correlation times of all observables in mcs in one line
+    std::string getIntegratedTimes() const;
+
+private:
+
+    //! holds a reference of the complete system
+    const IngredientsType& ingredients;
+
+    //! number of mcs after which sampling begins
+    uint64_t beginCalculation;
+
+    //! container for monomer idx whose z is correlated
+    std::vector<uint32_t> idXSelectedMonomers;
+
+    std::string filename;
+
+    MultiTauCorrelator endToEnd;
+    MultiTauCorrelator gyration;
+    std::vector<MultiTauCorrelator> heights;
+
+    //! ages of the first and the last sample
+    uint64_t firstAge, lastAge;
+};
+
+
+/**
+* @param ing_ system to be analyzed
+* @param monomers_ indices of the monomers whose z is correlated
+* @param begCal_ age of the system at which sampling begins
+* @param filename_ output file
+*/
+template<class IngredientsType>
+AnalyzerCorrelation<IngredientsType>::AnalyzerCorrelation(const IngredientsType& ing_, std::vector<uint32_t> monomers_, uint64_t begCal_, const std::string& filename_)
+:ingredients(ing_),beginCalculation(begCal_),idXSelectedMonomers(monomers_),filename(filename_),
+ endToEnd(3),gyration(1),firstAge(0),lastAge(0)
+{}
+
+template<class IngredientsType>
+void AnalyzerCorrelation<IngredientsType>::initialize()
+{
+    if(ingredients.getMolecules().size() < 2){
+        throw std::runtime_error("AnalyzerCorrelation: the system needs at least two monomers");
+    }
+    for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+        if(idXSelectedMonomers[i] >= ingredients.getMolecules().size()){
+            throw std::runtime_error("AnalyzerCorrelation: selected monomer is not part of the system");
+        }
+    }
+
+    endToEnd.clear();
+    gyration.clear();
+    heights.assign(idXSelectedMonomers.size(),MultiTauCorrelator(1));
+}
+
+/**
+* @brief add one sample of every observable
+*/
+template<class IngredientsType>
+bool AnalyzerCorrelation<IngredientsType>::execute()
+{
+    const typename IngredientsType::molecules_type& molecules(ingredients.getMolecules());
+    if(molecules.getAge() < beginCalculation){
+        return true;
+    }
+
+    if(endToEnd.getNumberOfSamples() == 0){
+        firstAge=molecules.getAge();
+    }
+    lastAge=molecules.getAge();
+
+    const VectorInt3 ree(molecules[molecules.size()-1]-molecules[0]);
+    const double reeValues[3]={double(ree.getX()),double(ree.getY()),double(ree.getZ())};
+    endToEnd.addSample(reeValues);
+
+    double centerX(0.0), centerY(0.0), centerZ(0.0);
+    for(uint32_t n=0; n<molecules.size(); n++){
+        centerX+=molecules[n].getX();
+        centerY+=molecules[n].getY();
+        centerZ+=molecules[n].getZ();
+    }
+    centerX/=double(molecules.size());
+    centerY/=double(molecules.size());
+    centerZ/=double(molecules.size());
+
+    double rg2(0.0);
+    for(uint32_t n=0; n<molecules.size(); n++){
+        const double dx(molecules[n].getX()-centerX);
+        const double dy(molecules[n].getY()-centerY);
+        const double dz(molecules[n].getZ()-centerZ);
+        rg2+=dx*dx+dy*dy+dz*dz;
+    }
+    gyration.addSample(rg2/double(molecules.size()));
+
+    for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+        heights[i].addSample(double(molecules[idXSelectedMonomers[i]].getZ()));
+    }
+
+    return true;
+}
+
+template<class IngredientsType>
+void AnalyzerCorrelation<IngredientsType>::cleanup()
+{
+    writeResults();
+    std::cout << "AnalyzerCorrelation: integrated correlation times in mcs: " << getIntegratedTimes() << std::endl;
+}
+
+/**
+* @return mcs between two samples, 1 if there are less than two samples
+*/
+template<class IngredientsType>
+double AnalyzerCorrelation<IngredientsType>::getSampleInterval() const
+{
+    if(endToEnd.getNumberOfSamples() < 2){
+        return 1.0;
+    }
+    return double(lastAge-firstAge)/double(endToEnd.getNumberOfSamples()-1);
+}
+
+/**
+* @details All correlators see the same samples, so they share the lags. The columns
+* are the lag in mcs, the autocorrelation of the end-to-end vector, of the squared
+* radius of gyration and of the z coordinate of every selected monomer. The file is
+* written to a temporary file first and renamed afterwards.
+*/
+template<class IngredientsType>
+void AnalyzerCorrelation<IngredientsType>::writeResults() const
+{
+    const double interval(getSampleInterval());
+
+    std::vector<uint64_t> lags;
+    std::vector<double> correlation;
+    std::vector<std::vector<double> > tmpResults(3+heights.size(),std::vector<double>());
+
+    endToEnd.getCorrelation(lags,correlation);
+    for(uint32_t n=0; n<lags.size(); n++){
+        tmpResults[0].push_back(interval*double(lags[n]));
+    }
+    tmpResults[1]=correlation;
+    gyration.getCorrelation(lags,correlation);
+    tmpResults[2]=correlation;
+    for(uint32_t i=0; i<heights.size(); i++){
+        heights[i].getCorrelation(lags,correlation);
+        tmpResults[3+i]=correlation;
+    }
+
+    std::stringstream comment;
+    comment << "# Analyzer correlation" << std::endl
+            << "# number of samples= " << endToEnd.getNumberOfSamples() << std::endl
+            << "# mcs per sample= " << interval << std::endl
+            << "# integrated correlation times in mcs: " << getIntegratedTimes() << std::endl
+            << "# tau = (1/2 + sum of C over the lags >= 1 sample) * mcs per sample, summed up to the first lag >= 5 tau, 0 without fluctuations" << std::endl
+            << "# lag\tC_Ree\tC_Rg2";
+    for(uint32_t i=0; i<heights.size(); i++){
+        comment << "\tC_z(" << idXSelectedMonomers[i] << ")";
+    }
+
+    ResultFormattingTools::writeResultFile(filename+".tmp", ingredients, tmpResults, comment.str());
+    std::rename((filename+".tmp").c_str(), filename.c_str());
+}
+
+/**
+* @return integrated correlation times of all observables in mcs in one line
+*/
+template<class IngredientsType>
+std::string AnalyzerCorrelation<IngredientsType>::getIntegratedTimes() const
+{
+    const double interval(getSampleInterval());
+    std::stringstream times;
+    times << "tau_Ree= " << interval*endToEnd.getIntegratedTime()
+          << " tau_Rg2= " << interval*gyration.getIntegratedTime();
+    for(uint32_t i=0; i<heights.size(); i++){
+        times << " tau_z(" << idXSelectedMonomers[i] << ")= " << interval*heights[i].getIntegratedTime();
+    }
+    return times.str();
+}
+
+#endif //ANALYZER_CORRELATION_H
@@ -37,24 +37,90 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 * 
 * @details Calculate the force acting on a set of monomers in a predefined environment (ingredients) 
 * using FeatureMoleculesIO and FeatureExcludedVolume.
-* Moves are checked in z direction
+* Moves are checked in z direction, with setProbeAllAxes() in x and y as well. All six
+* directions are probed in one pass per monomer then, and the counters and log(n-/n+)
+* of x and y are reported next to the ones of z.
+* The jumps are probed using one of the PROBE_TYPEs:
+* PROBE_LATTICE (default) reads the lattice of ingredients through a ForceProbeView with the
+* ForceProbeKernel and needs no copy of the system,
+* PROBE_INCREMENTAL_COPY runs MoveLocalSc on forceIngredients and only updates the lattice
+* sites of monomers which moved since the last call,
+* PROBE_FULL_COPY runs MoveLocalSc on a complete copy of the system for every call.
+*
+* With selectAllMonomers() every monomer of the system is probed, e.g. for the tension
+* profile along a chain. The selection is set up in initialize(). If all monomers are
+* selected, PROBE_LATTICE probes them in one pass of a ForceProbeBatch instead of one
+* by one.
+*
+* With setProfile() the jumps up and down are also binned by the z layer of the monomer
+* and by its distance to the lower and the upper wall, which gives the force as a
+* function of the position in the slit from a single run. The bins of all selected
+* monomers are allocated in one flat array in initialize(), so counting allocates
+* nothing. The profile is written to the output file with the ending _profile.dat.
+*
+* The outcome of every probe is also accumulated in a BlockAverageAccumulator per monomer,
+* which gives error bars of log(n-/n+) including the correlations between the probes in
+* constant memory. The results can be written every flushInterval probes, so a killed run
+* keeps its statistics up to the last flush.
 *
 * @tparam IngredientsType
 **/
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 #include <LeMonADE/core/Ingredients.h>
 #include <LeMonADE/analyzer/AbstractAnalyzer.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/utility/ResultFormattingTools.h>
+
+#include "BlockAverageAccumulator.h"
+#include "Checkpoint.h"
+#include "ForceProbeBatch.h"
+#include "ForceProbeKernel.h"
+#include "ForceProbeView.h"
+
+/**
+* @brief Optional measurements of AnalyzerForce, applied with AnalyzerForce::setOptions()
+* by everyone who sets up analyzers on behalf of the user, e.g. ReplicaRunner.
+*/
+struct AnalyzerForceOptions
+{
+    AnalyzerForceOptions():allAxes(false),profile(false){}
 
+    //! probe the jumps in x and y as well, see AnalyzerForce::setProbeAllAxes()
+    bool allAxes;
 
+    //! bin the jumps by z layer and distance to the walls, see AnalyzerForce::setProfile()
+    bool profile;
+};
 
 template<class IngredientsType>
-class AnalyzerForce: public AbstractAnalyzer
+class AnalyzerForce: public AbstractAnalyzer, public AbstractCheckpointable
 {
 public:
     
-    AnalyzerForce(const IngredientsType& ing_, std::vector<uint32_t> monomers_, uint64_t begCal_);
+    enum PROBE_TYPE{
+      PROBE_FULL_COPY=0,
+      PROBE_INCREMENTAL_COPY=1,
+      PROBE_LATTICE=2
+    };
+
+    //! position the jumps are binned by with setProfile()
+    enum PROFILE_TYPE{
+      PROFILE_LAYER=0,
+      PROFILE_LOWER_WALL=1,
+      PROFILE_UPPER_WALL=2
+    };
+
+    AnalyzerForce(const IngredientsType& ing_, std::vector<uint32_t> monomers_, uint64_t begCal_, int probeType_=PROBE_LATTICE);
     
     virtual void initialize();
     virtual bool execute();
@@ -64,13 +130,87 @@ public:
     const std::vector<uint64_t> getCounterPlus() const { return counterPlus; }
     const std::vector<uint64_t> getCounterMinus() const { return counterMinus; }
     const uint64_t getCounterTries() const { return counterTries; }
+    int getProbeType() const { return probeType; }
+    const std::vector<uint32_t>& getSelectedMonomers() const { return idXSelectedMonomers; }
+
+    //! probe the jumps in x and y as well, call before initialize()
+    void setProbeAllAxes(bool allAxes_);
+    bool isProbeAllAxes() const { return allAxes; }
+
+    //! number of jumps of selected monomer i into BondMoveTable::getDirection(d), all six directions with setProbeAllAxes() only
+    uint64_t getCounterDirection(uint32_t i, uint32_t d) const { return counterDirections.at(6*i+d); }
+
+    //! bin the jumps by z layer and distance to the walls, call before initialize()
+    void setProfile(bool profile_){ profile=profile_; }
+    bool isProfile() const { return profile; }
+
+    //! set all optional measurements at once, call before initialize()
+    void setOptions(const AnalyzerForceOptions& options){ setProbeAllAxes(options.allAxes); setProfile(options.profile); }
+
+    //! number of bins per monomer and PROFILE_TYPE, the positions between the walls or the size of the box in z
+    uint32_t getNumberOfProfileBins() const { return nProfileBins; }
+    //! number of probes of selected monomer i in bin of type
+    uint64_t getProfileTries(int type, uint32_t i, uint32_t bin) const { return profileCounters.at(profileIndex(type,i,bin)); }
+    //! number of jumps down of selected monomer i in bin of type
+    uint64_t getProfileCounterMinus(int type, uint32_t i, uint32_t bin) const { return profileCounters.at(profileIndex(type,i,bin)+1); }
+    //! number of jumps up of selected monomer i in bin of type
+    uint64_t getProfileCounterPlus(int type, uint32_t i, uint32_t bin) const { return profileCounters.at(profileIndex(type,i,bin)+2); }
+
+    //! output file of the profile, the output file with the ending _profile.dat
+    std::string getProfileFilename() const;
+
+    //! probe every monomer of the system instead of the selection of the constructor
+    void selectAllMonomers(){ allMonomers=true; }
+    bool isAllMonomers() const { return allMonomers; }
+
+    //! write the results every nProbes probes, 0 writes them in cleanup() only
+    void setFlushInterval(uint32_t nProbes){ flushInterval=nProbes; }
+    uint32_t getFlushInterval() const { return flushInterval; }
+
+    //! true if selected monomer i jumped at least once up and down, otherwise getForce(i) is NaN
+    bool isForceDefined(uint32_t i) const { return counterMinus.at(i) > 0 && counterPlus.at(i) > 0; }
+    //! force estimate log(n-/n+) of selected monomer i, NaN if it is not defined
+    double getForce(uint32_t i) const;
+    //! force estimate log(n-/n+) of selected monomer i along axis 0 (x), 1 (y) or 2 (z), needs setProbeAllAxes()
+    double getForce(uint32_t i, uint32_t axis) const;
+    //! standard error of getForce(i) including correlations between the probes
+    double getForceError(uint32_t i) const;
+    //! standard error of getForce(i) assuming uncorrelated probes
+    double getForceErrorNaive(uint32_t i) const;
+    //! true if the force of selected monomer i is defined and its blocking analysis reached its plateau
+    bool isForceErrorConverged(uint32_t i) const;
+    //! statistics of the probes of selected monomer i, observables are (jump down, jump up)
+    const BlockAverageAccumulator& getProbeStatistics(uint32_t i) const { return probeStatistics.at(i); }
+
+    //! output file of the results, force.dat by default
+    void setFilename(const std::string& filename_){ filename=filename_; }
+    const std::string& getFilename() const { return filename; }
+
+    //! write the current results to the output file
+    void writeResults() const;
+
+    //! add the counters and statistics of an independent run with the same selection, or continue with a recorded one
+    void merge(const AnalyzerForce& other);
+
+    //! keep the outcome of every probe, so merge() can replay them in order, false drops the record
+    void setRecordProbes(bool recordProbes_);
+    bool isRecordProbes() const { return recordProbes; }
+
+    //! append counters and statistics to a checkpoint
+    virtual void saveState(CheckpointWriter& checkpoint) const;
+    //! restore counters and statistics from a checkpoint
+    virtual void loadState(CheckpointReader& checkpoint);
   
 private:
     
     //holds a reference of the complete system
     const IngredientsType& ingredients;
 
-    IngredientsType forceIngredients;
+    //! copy of the system for PROBE_FULL_COPY and PROBE_INCREMENTAL_COPY, not allocated for PROBE_LATTICE
+    std::unique_ptr<IngredientsType> forceIngredients;
+
+    //! read-only view of ingredients for PROBE_LATTICE
+    ForceProbeView<IngredientsType> probeView;
     
     //! bool for initialize call
     bool isInitialized;
@@ -79,12 +219,100 @@ private:
     uint64_t beginCalculation;
 
     //! container for monomer idx to calculate force
-    const std::vector<uint32_t> idXSelectedMonomers;
+    std::vector<uint32_t> idXSelectedMonomers;
+
+    //! probe every monomer of the system, see selectAllMonomers()
+    bool allMonomers;
 
     //counters for jumps up and down for both (all) strands and for every tried jump
     std::vector<uint64_t> counterPlus;
     std::vector<uint64_t> counterMinus;
     uint64_t counterTries;
+
+    //! probe all six directions
+    bool allAxes;
+
+    //! jumps of selected monomer i into direction d at 6*i+d, in the order of BondMoveTable
+    std::vector<uint64_t> counterDirections;
+
+    //! bin the jumps by position
+    bool profile;
+
+    //! number of bins per monomer and PROFILE_TYPE
+    uint32_t nProfileBins;
+
+    //! accessible planes lowerZ <= z < upperZ of the walls and the box, used for the distances to the walls
+    int32_t profileLowerZ, profileUpperZ;
+    bool hasProfileLowerWall, hasProfileUpperWall;
+
+    //! tries, jumps down and jumps up per PROFILE_TYPE, selected monomer and bin, see profileIndex()
+    std::vector<uint64_t> profileCounters;
+
+    //! helper function: index of the tries of selected monomer i in bin of type in profileCounters
+    size_t profileIndex(int type, uint32_t i, uint32_t bin) const { return 3*((size_t(type)*idXSelectedMonomers.size()+i)*nProfileBins+bin); }
+
+    //! type of jump probe using PROBE_TYPE
+    int probeType;
+
+    //! kernel probing the jumps on the lattice of ingredients for PROBE_LATTICE
+    ForceProbeKernel probeKernel;
+
+    //! probe of all monomers in one pass for PROBE_LATTICE and selectAllMonomers()
+    ForceProbeBatch probeBatch;
+
+    //! monomer positions in forceIngredients at the last update
+    std::vector<VectorInt3> lastPositions;
+
+    //! buffer for the indices of monomers which moved since the last update
+    std::vector<uint32_t> movedMonomers;
+
+    //! helper function: copy monomer positions to forceIngredients
+    void updateForceIngredients();
+
+    //! helper function: probe jumps with MoveLocalSc on forceIngredients
+    void probeForceIngredients();
+
+    //! helper function: probe jumps on the lattice of ingredients
+    void probeLattice();
+
+    //! helper function: select all monomers of ingredients if selectAllMonomers() was called
+    void updateAllMonomers();
+
+    //! helper function: count the result of the probes of selected monomer i
+    void countJumps(uint32_t i, bool jumpPlus, bool jumpMinus);
+
+    //! helper function: count the jumps of selected monomer i in all six directions, bit d of jumps for direction d
+    void countDirections(uint32_t i, uint8_t jumps);
+
+    //! helper function: allocate the profile for the box and the walls of ingredients
+    void updateProfile();
+
+    //! helper function: count the result of the probes of selected monomer i in its bins
+    void countProfile(uint32_t i, bool jumpPlus, bool jumpMinus);
+
+    //! helper function: write the profile to getProfileFilename()
+    void writeProfile() const;
+
+    //! helper function: error of the force of selected monomer i from level l
+    double forceErrorAtLevel(uint32_t i, uint32_t l) const;
+
+    //! online statistics of the probes for every selected monomer
+    std::vector<BlockAverageAccumulator> probeStatistics;
+
+    //! keep the outcome of every probe in probeRecord
+    bool recordProbes;
+
+    //! jump down (bit 0) and up (bit 1) of every probe of every selected monomer in probe order, not part of the checkpoint
+    std::vector<uint8_t> probeRecord;
+
+    //! number of probes between two writes of the results
+    uint32_t flushInterval;
+
+    //! output file of the results
+    std::string filename;
+
+    //! helper function: set all eight lattice sites of a monomer cube at position pos
+    void setMonomerCube(const VectorInt3& pos, bool value);
     
 };
 
@@ -95,19 +323,21 @@ private:
 * @param ing_ a reference to the IngredientsType - mainly the system
 * @param monomers_ set of monomers to calculate the force
 * @param begCal_ age for starting to analyze
+* @param probeType_ type of the jump probe using PROBE_TYPE
 */
 template<class IngredientsType>
-AnalyzerForce<IngredientsType>::AnalyzerForce(const IngredientsType& ing_, std::vector<uint32_t> monomers_, uint64_t begCal_)
- :ingredients(ing_),beginCalculation(begCal_),isInitialized(false),
- idXSelectedMonomers(monomers_),counterPlus(monomers_.size()),counterMinus(monomers_.size()),
- counterTries(0)
+AnalyzerForce<IngredientsType>::AnalyzerForce(const IngredientsType& ing_, std::vector<uint32_t> monomers_, uint64_t begCal_, int probeType_)
+ :ingredients(ing_),probeView(ing_),isInitialized(false),beginCalculation(begCal_),
+ idXSelectedMonomers(monomers_),allMonomers(false),counterPlus(monomers_.size()),counterMinus(monomers_.size()),
+ counterTries(0),allAxes(false),profile(false),nProfileBins(0),profileLowerZ(0),profileUpperZ(0),hasProfileLowerWall(false),hasProfileUpperWall(false),probeType(probeType_),
+ probeStatistics(monomers_.size(),BlockAverageAccumulator(2)),recordProbes(false),flushInterval(0),filename("force.dat")
 {}
 
 
 /**
 * The initialize function handles the new systems information.
 * 
-* @details Setup forceIngredients parameters
+* @details Setup forceIngredients parameters if the jumps are probed on a copy of the system
 *
 * @tparam IngredientsType Features used in the system. See Ingredients.
 */
@@ -116,20 +346,31 @@ void AnalyzerForce<IngredientsType>::initialize(){
     if(!isInitialized){
 	    std::cout << "AnalyzerForce: initialise" << std::endl;
 
+        updateAllMonomers();
+        updateProfile();
+
         //setup forceIngredients without walls and with periodic boundary conditions
-	    forceIngredients.modifyMolecules()=ingredients.getMolecules();
+        if(probeType != PROBE_LATTICE){
+	        forceIngredients.reset(new IngredientsType);
+	        forceIngredients->modifyMolecules()=ingredients.getMolecules();
+
+	        forceIngredients->setBoxX(ingredients.getBoxX());
+	        forceIngredients->setBoxY(ingredients.getBoxY());
+	        forceIngredients->setBoxZ(ingredients.getBoxZ());
 
-	    forceIngredients.setBoxX(ingredients.getBoxX());
-	    forceIngredients.setBoxY(ingredients.getBoxY());
-	    forceIngredients.setBoxZ(ingredients.getBoxZ());
+	        forceIngredients->setPeriodicX(true);
+	        forceIngredients->setPeriodicY(true);
+	        forceIngredients->setPeriodicZ(true);
 
-	    forceIngredients.setPeriodicX(true);
-	    forceIngredients.setPeriodicY(true);
-	    forceIngredients.setPeriodicZ(true);
+	        forceIngredients->modifyBondset().addBFMclassicBondset();
 
-	    forceIngredients.modifyBondset().addBFMclassicBondset();
+	        forceIngredients->synchronize();
 
-	    forceIngredients.synchronize();
+	        lastPositions.resize(forceIngredients->getMolecules().size());
+	        for(uint32_t i=0; i<lastPositions.size(); i++){
+	            lastPositions[i]=forceIngredients->getMolecules()[i];
+	        }
+        }
 
         isInitialized=true;
     }
@@ -156,27 +397,335 @@ bool AnalyzerForce<IngredientsType>::execute(){
 	//begin calculation first time at age beginCalculation
 	if(ingredients.getMolecules().getAge() >= beginCalculation)
     {
-        // copy monomer positions to forceIngredients
-        forceIngredients.modifyMolecules()=ingredients.getMolecules();
-        forceIngredients.synchronize();
-        
-        for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
-            //remove constraints on the monomer
-            forceIngredients.modifyMolecules()[idXSelectedMonomers.at(i)].setMovableTag(true);
+        if(probeType==PROBE_LATTICE){
+            probeLattice();
+        }else{
+            probeForceIngredients();
+        }
+        counterTries++;
+
+        if(flushInterval > 0 && (counterTries % flushInterval) == 0){
+            writeResults();
+        }
+    }
+
+    return true;
+}
 
-            MoveLocalSc movePlus;
-            movePlus.init(forceIngredients, idXSelectedMonomers.at(i), VectorInt3(0,0,1));
-            if(movePlus.check(forceIngredients)){
-                counterPlus.at(i)++;
+/**
+* @brief probe the jumps up and down with MoveLocalSc on forceIngredients
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::probeForceIngredients(){
+    // copy monomer positions to forceIngredients
+    updateForceIngredients();
+    
+    for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+        //remove constraints on the monomer
+        forceIngredients->modifyMolecules()[idXSelectedMonomers.at(i)].setMovableTag(true);
+
+        if(allAxes){
+            uint8_t jumps(0);
+            for(uint32_t d=0; d<6; d++){
+                MoveLocalSc move;
+                move.init(*forceIngredients, idXSelectedMonomers.at(i), BondMoveTable::getDirection(d));
+                if(move.check(*forceIngredients)){
+                    jumps|=uint8_t(1u << d);
+                }
             }
+            countJumps(i, (jumps >> 4) & 1, (jumps >> 5) & 1);
+            countDirections(i, jumps);
+            continue;
+        }
+
+        MoveLocalSc movePlus;
+        movePlus.init(*forceIngredients, idXSelectedMonomers.at(i), VectorInt3(0,0,1));
+
+        MoveLocalSc moveMinus;
+        moveMinus.init(*forceIngredients, idXSelectedMonomers.at(i), VectorInt3(0,0,-1));
+
+        countJumps(i, movePlus.check(*forceIngredients), moveMinus.check(*forceIngredients));
+    }
+}
 
-            MoveLocalSc moveMinus;
-            moveMinus.init(forceIngredients, idXSelectedMonomers.at(i), VectorInt3(0,0,-1));
-            if(moveMinus.check(forceIngredients)){
-                counterMinus.at(i)++;
+/**
+* @brief probe the jumps up and down on the lattice of ingredients
+*
+* @details Gives the same counts as probeForceIngredients() without a second copy
+* of the system. See ForceProbeKernel and ForceProbeView.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::probeLattice(){
+    if(allMonomers){
+        probeBatch.probe(probeView, probeKernel);
+        for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+            const uint8_t jumps(probeBatch.getJumps()[i]);
+            countJumps(i, (jumps >> 4) & 1, (jumps >> 5) & 1);
+            if(allAxes){
+                countDirections(i, jumps);
+            }
+        }
+        return;
+    }
+
+    if(allAxes){
+        for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+            const uint8_t jumps(probeKernel.getAllowedJumps(probeView, idXSelectedMonomers.at(i)));
+            countJumps(i, (jumps >> 4) & 1, (jumps >> 5) & 1);
+            countDirections(i, jumps);
+        }
+        return;
+    }
+
+    for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+        countJumps(i,
+                   probeKernel.checkJump(probeView, idXSelectedMonomers.at(i), VectorInt3(0,0,1)),
+                   probeKernel.checkJump(probeView, idXSelectedMonomers.at(i), VectorInt3(0,0,-1)));
+    }
+}
+
+/**
+* @details Called by initialize(), merge() and loadState(). A selection listing all
+* monomers of ingredients in order switches to selectAllMonomers() as well. The
+* selection and the counters are reset only if the selection is not yet the list of
+* all monomers.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::updateAllMonomers(){
+    const uint32_t nMonomers(ingredients.getMolecules().size());
+    bool isComplete(nMonomers > 0 && idXSelectedMonomers.size() == nMonomers);
+    for(uint32_t i=0; isComplete && i<nMonomers; i++){
+        isComplete=(idXSelectedMonomers[i] == i);
+    }
+
+    if(!allMonomers && !isComplete){
+        return;
+    }
+    allMonomers=true;
+
+    if(!isComplete){
+        idXSelectedMonomers.resize(nMonomers);
+        for(uint32_t i=0; i<nMonomers; i++){
+            idXSelectedMonomers[i]=i;
+        }
+        counterPlus.assign(nMonomers,0);
+        counterMinus.assign(nMonomers,0);
+        probeStatistics.assign(nMonomers,BlockAverageAccumulator(2));
+        counterDirections.assign(allAxes ? 6*nMonomers : 0,0);
+    }
+
+    if(probeType==PROBE_LATTICE && (probeBatch.getNumberOfMonomers() != nMonomers || (probeBatch.getDirections()==BondMoveTable::allMoves()) != allAxes)){
+        probeBatch.setup(ingredients.getMolecules(),allAxes);
+    }
+}
+
+/**
+* @details Resets the counters of all directions.
+*
+* @param allAxes_ true to probe the jumps in x and y as well
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::setProbeAllAxes(bool allAxes_){
+    allAxes=allAxes_;
+    counterDirections.assign(allAxes ? 6*idXSelectedMonomers.size() : 0,0);
+}
+
+/**
+* @details The record takes one byte per probe and selected monomer. It is meant for
+* parts of a trajectory evaluated in parallel, see ForceTrajectoryEvaluator.
+*
+* @param recordProbes_ true to record the following probes, false to drop the record
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::setRecordProbes(bool recordProbes_){
+    recordProbes=recordProbes_;
+    if(!recordProbes){
+        std::vector<uint8_t>().swap(probeRecord);
+    }
+}
+
+/**
+* @brief count the result of the probes in all six directions of selected monomer i
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+inline void AnalyzerForce<IngredientsType>::countDirections(uint32_t i, uint8_t jumps){
+    for(uint32_t d=0; d<6; d++){
+        counterDirections[6*i+d]+=(jumps >> d) & 1;
+    }
+}
+
+/**
+* @brief count the result of the probes up and down of selected monomer i
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+inline void AnalyzerForce<IngredientsType>::countJumps(uint32_t i, bool jumpPlus, bool jumpMinus){
+    if(jumpPlus){
+        counterPlus.at(i)++;
+    }
+    if(jumpMinus){
+        counterMinus.at(i)++;
+    }
+
+    const double sample[2]={ jumpMinus ? 1.0 : 0.0, jumpPlus ? 1.0 : 0.0 };
+    probeStatistics.at(i).addSample(sample);
+    if(recordProbes){
+        probeRecord.push_back(uint8_t(jumpMinus) | uint8_t(uint8_t(jumpPlus) << 1));
+    }
+
+    if(profile && nProfileBins > 0){
+        countProfile(i, jumpPlus, jumpMinus);
+    }
+}
+
+/**
+* @details The accessible planes are bounded by walls perpendicular to z in the
+* convention of FeatureSlitConfinement, a normal (0,0,1) bounds the slit from above, and
+* by the box if it is not periodic in z. Between a lower and an upper bound the profile
+* has one bin per position of the monomer cube, profileUpperZ-profileLowerZ-1, otherwise
+* one bin per plane of the box. The counters are kept if the size of the profile did not
+* change.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::updateProfile(){
+    if(!profile){
+        return;
+    }
+
+    hasProfileLowerWall=!ingredients.isPeriodicZ();
+    hasProfileUpperWall=!ingredients.isPeriodicZ();
+    profileLowerZ=0;
+    profileUpperZ=ingredients.getBoxZ();
+
+    const std::vector<Wall> walls(ingredients.getWalls());
+    for(uint32_t w=0; w<walls.size(); w++){
+        const VectorInt3 normal(walls[w].getNormal());
+        if(normal.getX()!=0 || normal.getY()!=0 || normal.getZ()==0){
+            continue;
+        }
+        const int32_t plane(walls[w].getBase().getZ());
+        if(normal.getZ() > 0){
+            profileUpperZ=hasProfileUpperWall ? std::min(profileUpperZ,plane) : plane;
+            hasProfileUpperWall=true;
+        }else{
+            profileLowerZ=hasProfileLowerWall ? std::max(profileLowerZ,plane+1) : plane+1;
+            hasProfileLowerWall=true;
+        }
+    }
+
+    if(hasProfileLowerWall && hasProfileUpperWall){
+        nProfileBins=uint32_t(std::max(profileUpperZ-profileLowerZ-1,0));
+    }else{
+        nProfileBins=ingredients.getBoxZ();
+    }
+    const size_t size(3*3*idXSelectedMonomers.size()*size_t(nProfileBins));
+    if(profileCounters.size() != size){
+        profileCounters.assign(size,0);
+    }
+}
+
+/**
+* @details The layer is the z coordinate of the lower left corner of the monomer cube,
+* counted from profileLowerZ between two walls and folded into the box otherwise. The distance to a wall is the number of free planes between the
+* monomer cube and the wall, 0 for a monomer touching the wall.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+inline void AnalyzerForce<IngredientsType>::countProfile(uint32_t i, bool jumpPlus, bool jumpMinus){
+    const int32_t z(ingredients.getMolecules()[idXSelectedMonomers[i]].getZ());
+    const int32_t nBins(nProfileBins);
+    const bool isSlit(hasProfileLowerWall && hasProfileUpperWall);
+    const int32_t bins[3]={ isSlit ? z-profileLowerZ : ((z % nBins)+nBins) % nBins,
+                            hasProfileLowerWall ? z-profileLowerZ : -1,
+                            hasProfileUpperWall ? profileUpperZ-2-z : -1 };
+
+    for(int type=0; type<3; type++){
+        if(bins[type] < 0 || bins[type] >= nBins){
+            continue;
+        }
+        uint64_t* const counters(&profileCounters[profileIndex(type,i,bins[type])]);
+        counters[0]++;
+        counters[1]+=jumpMinus;
+        counters[2]+=jumpPlus;
+    }
+}
+
+/**
+* updateForceIngredients()
+* 
+* @brief copy the current monomer positions of ingredients to forceIngredients
+*
+* @details In incremental mode the positions of ingredients are compared to the ones of
+* the last update and only the lattice sites of moved monomers are cleared and set again.
+* The complete system is copied and synchronized for PROBE_FULL_COPY or if the number
+* of monomers changed.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::updateForceIngredients(){
+
+    if( probeType==PROBE_FULL_COPY || (forceIngredients->getMolecules().size() != ingredients.getMolecules().size()) ){
+        forceIngredients->modifyMolecules()=ingredients.getMolecules();
+        forceIngredients->synchronize();
+
+        lastPositions.resize(forceIngredients->getMolecules().size());
+        for(uint32_t i=0; i<lastPositions.size(); i++){
+            lastPositions[i]=forceIngredients->getMolecules()[i];
+        }
+        return;
+    }
+
+    forceIngredients->modifyMolecules().setAge(ingredients.getMolecules().getAge());
+
+    // find monomers which moved since the last update
+    movedMonomers.clear();
+    for(uint32_t i=0; i<lastPositions.size(); i++){
+        if(lastPositions[i] != ingredients.getMolecules()[i]){
+            movedMonomers.push_back(i);
+        }
+    }
+
+    // first remove all moved monomers from the lattice to not clear sites of already placed ones
+    for(uint32_t n=0; n<movedMonomers.size(); n++){
+        setMonomerCube(lastPositions[movedMonomers[n]], false);
+    }
+
+    for(uint32_t n=0; n<movedMonomers.size(); n++){
+        uint32_t idx(movedMonomers[n]);
+        const VectorInt3& newPos(ingredients.getMolecules()[idx]);
+
+        setMonomerCube(newPos, true);
+        forceIngredients->modifyMolecules()[idx].setAllCoordinates(newPos.getX(),newPos.getY(),newPos.getZ());
+        lastPositions[idx]=newPos;
+    }
+}
+
+/**
+* @brief set all eight lattice sites of the monomer cube with lower left corner pos
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+inline void AnalyzerForce<IngredientsType>::setMonomerCube(const VectorInt3& pos, bool value){
+    for(int32_t dx=0; dx<2; dx++){
+        for(int32_t dy=0; dy<2; dy++){
+            for(int32_t dz=0; dz<2; dz++){
+                forceIngredients->setLatticeEntry(pos+VectorInt3(dx,dy,dz),value);
             }
         }
-        counterTries++;
     }
 }
 
@@ -190,30 +739,310 @@ bool AnalyzerForce<IngredientsType>::execute(){
 */
 template<class IngredientsType>
 void AnalyzerForce<IngredientsType>::cleanup()
+{
+    writeResults();
+}
+
+/**
+* writeResults()
+* 
+* @brief Writes the current results to the output file, force.dat by default
+*
+* @details The file is written to a temporary file first and renamed afterwards, so
+* an interrupted write never leaves a truncated output file behind.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::writeResults() const
 {
     // print results into a file
-    std::string filename("force.dat");
-    
     //construct a list
-    std::vector<std::vector<double> > tmpResults(4,std::vector<double>());
+    std::vector<std::vector<double> > tmpResults(7,std::vector<double>());
 
     //fill tmpResults
     for(uint64_t i=0; i<idXSelectedMonomers.size(); i++){
         tmpResults[0].push_back(idXSelectedMonomers.at(i));
         tmpResults[1].push_back(counterMinus.at(i));
         tmpResults[2].push_back(counterPlus.at(i));
-        tmpResults[3].push_back(log(double(counterMinus.at(i))/double(counterPlus.at(i))));
+        tmpResults[3].push_back(getForce(i));
+        tmpResults[4].push_back(getForceError(i));
+        tmpResults[5].push_back(getForceErrorNaive(i));
+        tmpResults[6].push_back(isForceErrorConverged(i) ? 1 : 0);
     }
+
+    // counters and force along x and y behind the ones of z
+    if(allAxes){
+        tmpResults.resize(13);
+        for(uint64_t i=0; i<idXSelectedMonomers.size(); i++){
+            for(uint32_t axis=0; axis<2; axis++){
+                tmpResults[7+3*axis].push_back(counterDirections.at(6*i+2*axis+1));
+                tmpResults[8+3*axis].push_back(counterDirections.at(6*i+2*axis));
+                tmpResults[9+3*axis].push_back(getForce(i,axis));
+            }
+        }
+    }
+
     //write comments
     std::stringstream comment;
     comment << "# Analyzer force" << std::endl
             << "# total numer of tries= "<< counterTries<<std::endl
-            << "# idxMonomer\tn-\tn+\tlog(n-/n+)";
+            << "# mcs= "<< ingredients.getMolecules().getAge()<<std::endl
+            << "# err: standard error of log(n-/n+) from blocking analysis, errNaive: without correlations" << std::endl
+            << "# log(n-/n+) and its errors are nan and converged is 0 for monomers without jumps in one direction" << std::endl
+            << "# idxMonomer\tn-\tn+\tlog(n-/n+)\terr\terrNaive\tconverged";
+    if(allAxes){
+        comment << "\tnx-\tnx+\tlog(nx-/nx+)\tny-\tny+\tlog(ny-/ny+)";
+    }
 
     //write file
-    ResultFormattingTools::writeResultFile(filename, this->ingredients, tmpResults, comment.str());
+    ResultFormattingTools::writeResultFile(filename+".tmp", this->ingredients, tmpResults, comment.str());
+    std::rename((filename+".tmp").c_str(), filename.c_str());
+
+    if(profile){
+        writeProfile();
+    }
+}
+
+/**
+* @details force.dat gives force_profile.dat.
+*/
+template<class IngredientsType>
+std::string AnalyzerForce<IngredientsType>::getProfileFilename() const
+{
+    const size_t dot(filename.find_last_of("."));
+    const size_t slash(filename.find_last_of("/"));
+    const std::string base( (dot != std::string::npos && (slash == std::string::npos || dot > slash)) ? filename.substr(0,dot) : filename );
+    return base+"_profile.dat";
+}
+
+/**
+* @details One line per selected monomer and bin which was visited in any PROFILE_TYPE.
+* Empty bins of a type have zero counters, log(n-/n+) is NaN as in getForce() if one of
+* the counters is zero.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::writeProfile() const
+{
+    std::vector<std::vector<double> > tmpResults(14,std::vector<double>());
+
+    for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+        for(uint32_t bin=0; bin<nProfileBins; bin++){
+            if(getProfileTries(PROFILE_LAYER,i,bin)+getProfileTries(PROFILE_LOWER_WALL,i,bin)+getProfileTries(PROFILE_UPPER_WALL,i,bin) == 0){
+                continue;
+            }
+            tmpResults[0].push_back(idXSelectedMonomers[i]);
+            tmpResults[1].push_back(bin);
+            for(int type=0; type<3; type++){
+                const uint64_t nMinus(getProfileCounterMinus(type,i,bin)), nPlus(getProfileCounterPlus(type,i,bin));
+                tmpResults[2+4*type].push_back(getProfileTries(type,i,bin));
+                tmpResults[3+4*type].push_back(nMinus);
+                tmpResults[4+4*type].push_back(nPlus);
+                tmpResults[5+4*type].push_back((nMinus > 0 && nPlus > 0) ? log(double(nMinus)/double(nPlus)) : std::numeric_limits<double>::quiet_NaN());
+            }
+        }
+    }
+
+    std::stringstream comment;
+    comment << "# Analyzer force profile" << std::endl
+            << "# total numer of tries= "<< counterTries<<std::endl
+            << "# mcs= "<< ingredients.getMolecules().getAge()<<std::endl
+            << "# accessible planes " << profileLowerZ << " <= z < " << profileUpperZ
+            << ", lower wall " << (hasProfileLowerWall ? "yes" : "no") << ", upper wall " << (hasProfileUpperWall ? "yes" : "no") << std::endl
+            << "# bin: z layer of the monomer (z), counted from the lowest accessible plane in a slit, free planes to the lower wall (lower) and to the upper wall (upper)" << std::endl
+            << "# log(n-/n+) is nan in bins without jumps in one direction" << std::endl
+            << "# idxMonomer\tbin\ttries(z)\tn-(z)\tn+(z)\tlog(n-/n+)(z)"
+            << "\ttries(lower)\tn-(lower)\tn+(lower)\tlog(n-/n+)(lower)"
+            << "\ttries(upper)\tn-(upper)\tn+(upper)\tlog(n-/n+)(upper)";
+
+    const std::string profileFilename(getProfileFilename());
+    ResultFormattingTools::writeResultFile(profileFilename+".tmp", this->ingredients, tmpResults, comment.str());
+    std::rename((profileFilename+".tmp").c_str(), profileFilename.c_str());
+}
+
+/**
+* @details Without a jump in one of the directions log(n-/n+) would be infinite or
+* undefined, so NaN is returned until both counters are positive.
+*
+* @param i index in the list of selected monomers
+* @return log(n-/n+) or NaN, see isForceDefined()
+*/
+template<class IngredientsType>
+double AnalyzerForce<IngredientsType>::getForce(uint32_t i) const
+{
+    if(!isForceDefined(i)){
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return log(double(counterMinus.at(i))/double(counterPlus.at(i)));
+}
+
+/**
+* @param i index in the list of selected monomers
+* @param axis 0 for x, 1 for y, 2 for z
+* @return log(n-/n+) along axis, NaN without jumps in one of the directions
+*/
+template<class IngredientsType>
+double AnalyzerForce<IngredientsType>::getForce(uint32_t i, uint32_t axis) const
+{
+    if(!allAxes){
+        throw std::runtime_error("AnalyzerForce: the force along all axes needs setProbeAllAxes()");
+    }
+    const uint64_t nMinus(counterDirections.at(6*i+2*axis+1));
+    const uint64_t nPlus(counterDirections.at(6*i+2*axis));
+    if(nMinus == 0 || nPlus == 0){
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return log(double(nMinus)/double(nPlus));
+}
+
+/**
+* @details The error of log(n-/n+) follows from the covariances of the mean jump
+* probabilities p- and p+ by error propagation:
+* err^2 = var(p-)/p-^2 + var(p+)/p+^2 - 2 cov(p-,p+)/(p- p+).
+* The covariances are taken from the larger of the optimal blocking levels of p- and p+.
+* Like the force, the error is NaN if the force is not defined.
+*
+* @param i index in the list of selected monomers
+*/
+template<class IngredientsType>
+double AnalyzerForce<IngredientsType>::getForceError(uint32_t i) const
+{
+    const BlockAverageAccumulator& statistics(probeStatistics.at(i));
+    const uint32_t level(std::max(statistics.getOptimalLevel(0),statistics.getOptimalLevel(1)));
+    return forceErrorAtLevel(i,level);
+}
+
+template<class IngredientsType>
+double AnalyzerForce<IngredientsType>::getForceErrorNaive(uint32_t i) const
+{
+    return forceErrorAtLevel(i,0);
+}
+
+template<class IngredientsType>
+bool AnalyzerForce<IngredientsType>::isForceErrorConverged(uint32_t i) const
+{
+    return isForceDefined(i) && probeStatistics.at(i).isConverged(0) && probeStatistics.at(i).isConverged(1);
+}
+
+template<class IngredientsType>
+double AnalyzerForce<IngredientsType>::forceErrorAtLevel(uint32_t i, uint32_t l) const
+{
+    if(!isForceDefined(i)){
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    const BlockAverageAccumulator& statistics(probeStatistics.at(i));
+    const double pMinus(statistics.getMean(0));
+    const double pPlus(statistics.getMean(1));
+    const double variance( statistics.getCovarianceOfMean(l,0,0)/(pMinus*pMinus)
+                          +statistics.getCovarianceOfMean(l,1,1)/(pPlus*pPlus)
+                          -2.0*statistics.getCovarianceOfMean(l,0,1)/(pMinus*pPlus) );
+    return std::sqrt(std::max(variance,0.0));
 }
 
+/**
+* @details The merged statistics describe all probes of both runs, e.g. of independent
+* replicas of the same system. If other recorded its probes, see setRecordProbes(), they
+* are replayed into the statistics as the continuation of the probes of this analyzer
+* instead. So consecutive parts of one trajectory merged in order give the same
+* blocking analysis as a single analyzer probing all of them, with blocks longer than
+* a part.
+*
+* @param other analyzer with the same selection of monomers
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::merge(const AnalyzerForce& other)
+{
+    updateAllMonomers();
+    updateProfile();
+    if(other.idXSelectedMonomers != idXSelectedMonomers){
+        throw std::runtime_error("AnalyzerForce: cannot merge analyzers of different selections of monomers");
+    }
+    if(other.counterDirections.size() != counterDirections.size()){
+        throw std::runtime_error("AnalyzerForce: cannot merge analyzers probing different directions");
+    }
+    if(other.profileCounters.size() != profileCounters.size()){
+        throw std::runtime_error("AnalyzerForce: cannot merge analyzers with different profiles");
+    }
+    for(uint32_t i=0; i<idXSelectedMonomers.size(); i++){
+        counterPlus[i]+=other.counterPlus[i];
+        counterMinus[i]+=other.counterMinus[i];
+        if(!other.recordProbes){
+            probeStatistics[i].merge(other.probeStatistics[i]);
+        }
+    }
+    if(other.recordProbes){
+        const uint32_t nSelected(idXSelectedMonomers.size());
+        for(size_t n=0; n<other.probeRecord.size(); n++){
+            const uint8_t jumps(other.probeRecord[n]);
+            const double sample[2]={ double(jumps & 1), double((jumps >> 1) & 1) };
+            probeStatistics[n % nSelected].addSample(sample);
+        }
+        if(recordProbes){
+            probeRecord.insert(probeRecord.end(),other.probeRecord.begin(),other.probeRecord.end());
+        }
+    }
+    for(uint32_t n=0; n<counterDirections.size(); n++){
+        counterDirections[n]+=other.counterDirections[n];
+    }
+    for(size_t n=0; n<profileCounters.size(); n++){
+        profileCounters[n]+=other.profileCounters[n];
+    }
+    counterTries+=other.counterTries;
+}
+
+/**
+* @details The selected monomers are stored as well to detect a checkpoint of a
+* different selection.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::saveState(CheckpointWriter& checkpoint) const
+{
+    checkpoint.writeVector(idXSelectedMonomers);
+    checkpoint.writeVector(counterPlus);
+    checkpoint.writeVector(counterMinus);
+    checkpoint.write(counterTries);
+    for(uint32_t i=0; i<probeStatistics.size(); i++){
+        probeStatistics[i].saveState(checkpoint);
+    }
+    checkpoint.writeVector(counterDirections);
+    checkpoint.writeVector(profileCounters);
+}
 
+template<class IngredientsType>
+void AnalyzerForce<IngredientsType>::loadState(CheckpointReader& checkpoint)
+{
+    updateAllMonomers();
+    updateProfile();
+
+    std::vector<uint32_t> savedMonomers;
+    checkpoint.readVector(savedMonomers);
+    if(savedMonomers != idXSelectedMonomers){
+        throw std::runtime_error("AnalyzerForce: checkpoint was written for a different selection of monomers");
+    }
+    checkpoint.readVector(counterPlus);
+    checkpoint.readVector(counterMinus);
+    checkpoint.read(counterTries);
+    for(uint32_t i=0; i<probeStatistics.size(); i++){
+        probeStatistics[i].loadState(checkpoint);
+    }
+    std::vector<uint64_t> savedDirections;
+    checkpoint.readVector(savedDirections);
+    if(savedDirections.size() != counterDirections.size()){
+        throw std::runtime_error("AnalyzerForce: checkpoint was written for a different set of probed directions");
+    }
+    counterDirections=savedDirections;
+
+    std::vector<uint64_t> savedProfile;
+    checkpoint.readVector(savedProfile);
+    if(savedProfile.size() != profileCounters.size()){
+        throw std::runtime_error("AnalyzerForce: checkpoint was written for a different profile");
+    }
+    profileCounters=savedProfile;
+}
 
 #endif //ANALYZER_FORCE_H
@@ -0,0 +1,423 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef ANALYZER_WRITE_BFM_FILE_ASYNC_H
+#define ANALYZER_WRITE_BFM_FILE_ASYNC_H
+/**
+* @file
+*
+* @class AnalyzerWriteBfmFileAsync
+*
+* @brief Write the configurations of a system to a bfm file in a background thread.
+*
+* @details execute() copies the positions and the age of the system into a buffer from
+* a fixed pool and returns. Formatting and file I/O of the buffer are done by an
+* AnalyzerWriteBfmFile in a worker thread, so a slow file system does not stall the
+* simulation.
+*
+* The writer works on a shadow copy of the system taken in initialize(), containing
+* molecules, box, periodicity, bondset and walls. Only positions and age are updated
+* afterwards, so bonds, attributes and tags have to stay constant during the run.
+* The header is written synchronously in initialize().
+*
+* The pool holds queueLength buffers. If all of them are waiting to be written,
+* execute() blocks until the worker returns one (backpressure), so memory is bounded
+* and no configuration is dropped. The number of these stalls is counted.
+* cleanup() writes all queued configurations before it returns. An exception of the
+* worker is rethrown by the next execute(), flush() or cleanup().
+*
+* In APPEND mode the worker also keeps the sidecar frame index of the file up to date,
+* see BfmFrameIndex, so a restart finds the last frame without scanning the file.
+*
+* @tparam IngredientsType
+**/
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <LeMonADE/analyzer/AbstractAnalyzer.h>
+#include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "BfmFrameIndex.h"
+
+template<class IngredientsType>
+class AnalyzerWriteBfmFileAsync: public AbstractAnalyzer
+{
+public:
+
+    //! same modes as AnalyzerWriteBfmFile
+    enum WRITE_MODE{
+      NEWFILE=AnalyzerWriteBfmFile<IngredientsType>::NEWFILE,
+      APPEND=AnalyzerWriteBfmFile<IngredientsType>::APPEND,
+      OVERWRITE=AnalyzerWriteBfmFile<IngredientsType>::OVERWRITE
+    };
+
+    AnalyzerWriteBfmFileAsync(const std::string& filename_, const IngredientsType& ing_, int mode_=APPEND, uint32_t queueLength_=4);
+
+    virtual ~AnalyzerWriteBfmFileAsync();
+
+    virtual void initialize();
+    virtual bool execute();
+    virtual void cleanup();
+
+    //! block until all queued configurations are written
+    void flush();
+
+    uint32_t getQueueLength() const { return queueLength; }
+    //! number of calls to execute() which had to wait for a free buffer
+    uint64_t getNumberOfStalls() const { return nStalls; }
+    //! number of configurations written by the worker
+    uint64_t getNumberOfWrittenFrames() const;
+
+private:
+
+    //! positions and age of one configuration
+    struct Snapshot
+    {
+      std::vector<VectorInt3> positions;
+      uint64_t age;
+    };
+
+    //! loop of the worker thread
+    void writeLoop();
+
+    //! stop and join the worker thread
+    void stopWorker();
+
+    //! rethrow the exception of the worker, call with the mutex locked
+    void rethrowError();
+
+    //! reference to the simulated system
+    const IngredientsType& ingredients;
+
+    //! name of the output file
+    std::string filename;
+
+    //! write mode of the AnalyzerWriteBfmFile
+    int mode;
+
+    //! number of buffers in the pool
+    uint32_t queueLength;
+
+    //! copy of the system read by the writer
+    std::unique_ptr<IngredientsType> shadow;
+
+    //! synchronous writer working on the shadow system
+    std::unique_ptr< AnalyzerWriteBfmFile<IngredientsType> > writer;
+
+    //! sidecar frame index of the file, APPEND mode only
+    std::unique_ptr<BfmFrameIndex> frameIndex;
+
+    //! buffer pool, indices of free and of queued buffers
+    std::vector<Snapshot> buffers;
+    std::deque<uint32_t> freeBuffers;
+    std::deque<uint32_t> queuedBuffers;
+
+    //! true while the worker writes a buffer
+    bool writing;
+    //! tells the worker to finish
+    bool stopRequested;
+
+    uint64_t nStalls;
+    uint64_t nWritten;
+
+    //! first exception thrown in the worker
+    std::exception_ptr error;
+
+    mutable std::mutex mutex;
+    //! signalled if a buffer is queued or the worker has to stop
+    std::condition_variable queued;
+    //! signalled if a buffer is returned to the pool
+    std::condition_variable returned;
+
+    std::thread worker;
+};
+
+
+/**
+* @param filename_ name of the output file
+* @param ing_ simulated system
+* @param mode_ NEWFILE, APPEND or OVERWRITE as in AnalyzerWriteBfmFile
+* @param queueLength_ number of configurations which can wait for the worker
+*/
+template<class IngredientsType>
+AnalyzerWriteBfmFileAsync<IngredientsType>::AnalyzerWriteBfmFileAsync(const std::string& filename_, const IngredientsType& ing_, int mode_, uint32_t queueLength_)
+:ingredients(ing_)
+,filename(filename_)
+,mode(mode_)
+,queueLength(queueLength_)
+,writing(false)
+,stopRequested(false)
+,nStalls(0)
+,nWritten(0)
+{
+    if(queueLength == 0){
+      throw std::runtime_error("AnalyzerWriteBfmFileAsync: queue length has to be at least 1");
+    }
+}
+
+/**
+* @details Queued configurations are still written, but errors are not reported.
+* Call cleanup() to get them.
+*/
+template<class IngredientsType>
+AnalyzerWriteBfmFileAsync<IngredientsType>::~AnalyzerWriteBfmFileAsync()
+{
+    stopWorker();
+}
+
+/**
+* @details Copies the system, writes the header and starts the worker thread.
+*/
+template<class IngredientsType>
+void AnalyzerWriteBfmFileAsync<IngredientsType>::initialize()
+{
+    stopWorker();
+
+    shadow.reset(new IngredientsType);
+    shadow->modifyMolecules()=ingredients.getMolecules();
+
+    shadow->setBoxX(ingredients.getBoxX());
+    shadow->setBoxY(ingredients.getBoxY());
+    shadow->setBoxZ(ingredients.getBoxZ());
+
+    shadow->setPeriodicX(ingredients.isPeriodicX());
+    shadow->setPeriodicY(ingredients.isPeriodicY());
+    shadow->setPeriodicZ(ingredients.isPeriodicZ());
+
+    shadow->modifyBondset()=ingredients.getBondset();
+
+    for(uint32_t w=0; w<ingredients.getWalls().size(); w++){
+      shadow->addWall(ingredients.getWalls()[w]);
+    }
+
+    shadow->synchronize();
+
+    writer.reset(new AnalyzerWriteBfmFile<IngredientsType>(filename,*shadow,mode));
+    writer->initialize();
+
+    if(mode == APPEND){
+      frameIndex.reset(new BfmFrameIndex(filename));
+    }else{
+      frameIndex.reset();
+    }
+
+    const uint32_t nMonomers(ingredients.getMolecules().size());
+    buffers.assign(queueLength,Snapshot());
+    freeBuffers.clear();
+    queuedBuffers.clear();
+    for(uint32_t b=0; b<queueLength; b++){
+      buffers[b].positions.resize(nMonomers);
+      freeBuffers.push_back(b);
+    }
+
+    // the worker starts with the update of the frame index
+    writing=bool(frameIndex);
+    stopRequested=false;
+    error=std::exception_ptr();
+
+    worker=std::thread(&AnalyzerWriteBfmFileAsync<IngredientsType>::writeLoop,this);
+}
+
+/**
+* @details Waits for a free buffer if all buffers are queued.
+*/
+template<class IngredientsType>
+bool AnalyzerWriteBfmFileAsync<IngredientsType>::execute()
+{
+    if(!worker.joinable()){
+      throw std::runtime_error("AnalyzerWriteBfmFileAsync: execute() called before initialize()");
+    }
+
+    const uint32_t nMonomers(ingredients.getMolecules().size());
+    if(nMonomers != shadow->getMolecules().size()){
+      throw std::runtime_error("AnalyzerWriteBfmFileAsync: number of monomers changed during the run");
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    rethrowError();
+
+    if(freeBuffers.empty()){
+      nStalls++;
+      returned.wait(lock,[this]{ return !freeBuffers.empty() || error; });
+      rethrowError();
+    }
+
+    const uint32_t b(freeBuffers.front());
+    freeBuffers.pop_front();
+    lock.unlock();
+
+    // the buffer belongs to this thread until it is queued
+    Snapshot& snapshot(buffers[b]);
+    for(uint32_t i=0; i<nMonomers; i++){
+      snapshot.positions[i]=ingredients.getMolecules()[i];
+    }
+    snapshot.age=ingredients.getMolecules().getAge();
+
+    lock.lock();
+    queuedBuffers.push_back(b);
+    lock.unlock();
+    queued.notify_one();
+
+    return true;
+}
+
+template<class IngredientsType>
+void AnalyzerWriteBfmFileAsync<IngredientsType>::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    returned.wait(lock,[this]{ return (queuedBuffers.empty() && !writing) || error || !worker.joinable(); });
+    rethrowError();
+}
+
+/**
+* @details Writes all queued configurations and stops the worker.
+*/
+template<class IngredientsType>
+void AnalyzerWriteBfmFileAsync<IngredientsType>::cleanup()
+{
+    if(!worker.joinable()){
+      return;
+    }
+
+    stopWorker();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    rethrowError();
+    writer->cleanup();
+}
+
+template<class IngredientsType>
+uint64_t AnalyzerWriteBfmFileAsync<IngredientsType>::getNumberOfWrittenFrames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return nWritten;
+}
+
+/**
+* @details Writes the queued buffers in order. After an exception the worker stops
+* writing and only returns the buffers, so execute() does not block forever. The
+* exception stays stored, so every later call reports it.
+*
+* The frame index is brought up to date first, which scans an existing file without
+* index once, and then after every frame.
+*/
+template<class IngredientsType>
+void AnalyzerWriteBfmFileAsync<IngredientsType>::writeLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if(frameIndex){
+      lock.unlock();
+      try{
+        frameIndex->update();
+      }catch(...){
+        lock.lock();
+        error=std::current_exception();
+        lock.unlock();
+      }
+      lock.lock();
+      writing=false;
+      returned.notify_all();
+    }
+
+    while(true){
+      queued.wait(lock,[this]{ return !queuedBuffers.empty() || stopRequested; });
+      if(queuedBuffers.empty()){
+        return;
+      }
+
+      const uint32_t b(queuedBuffers.front());
+      queuedBuffers.pop_front();
+      writing=true;
+      const bool failed(error);
+      lock.unlock();
+
+      if(!failed){
+        try{
+          const Snapshot& snapshot(buffers[b]);
+          for(uint32_t i=0; i<snapshot.positions.size(); i++){
+            shadow->modifyMolecules()[i].setAllCoordinates(snapshot.positions[i].getX(),snapshot.positions[i].getY(),snapshot.positions[i].getZ());
+          }
+          shadow->modifyMolecules().setAge(snapshot.age);
+          writer->execute();
+          if(frameIndex){
+            frameIndex->update();
+          }
+        }catch(...){
+          lock.lock();
+          error=std::current_exception();
+          lock.unlock();
+        }
+      }
+
+      lock.lock();
+      if(!error){
+        nWritten++;
+      }
+      writing=false;
+      freeBuffers.push_back(b);
+      returned.notify_all();
+    }
+}
+
+/**
+* @details The worker empties the queue before it returns.
+*/
+template<class IngredientsType>
+void AnalyzerWriteBfmFileAsync<IngredientsType>::stopWorker()
+{
+    if(!worker.joinable()){
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopRequested=true;
+    }
+    queued.notify_one();
+    worker.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    returned.notify_all();
+}
+
+template<class IngredientsType>
+void AnalyzerWriteBfmFileAsync<IngredientsType>::rethrowError()
+{
+    if(error){
+      std::rethrow_exception(error);
+    }
+}
+
+#endif //ANALYZER_WRITE_BFM_FILE_ASYNC_H
@@ -0,0 +1,182 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef ANALYZER_WRITE_BINARY_TRAJECTORY_H
+#define ANALYZER_WRITE_BINARY_TRAJECTORY_H
+/**
+* @file
+*
+* @class AnalyzerWriteBinaryTrajectory
+*
+* @brief Write the configurations of a system to a binary trajectory.
+*
+* @details The structure of the system (box, periodicity, bonds, attributes, movable
+* tags and walls) is taken in initialize() and has to stay constant during the run.
+* Every execute() appends one frame, see BinaryTrajectory.h for the format. The
+* trajectory can be converted to the bfm format with UpdaterReadBinaryTrajectory and
+* AnalyzerWriteBfmFile, e.g. by the executable convertBinaryTrajectory.
+*
+* @tparam IngredientsType
+**/
+
+#include <iostream>
+#include <string>
+
+#include <LeMonADE/analyzer/AbstractAnalyzer.h>
+
+#include "BinaryTrajectory.h"
+
+
+template<class IngredientsType>
+class AnalyzerWriteBinaryTrajectory: public AbstractAnalyzer
+{
+public:
+
+    enum WRITE_MODE{
+      NEWFILE=0,
+      APPEND=1
+    };
+
+    AnalyzerWriteBinaryTrajectory(const std::string& filename_, const IngredientsType& ing_, int mode_=APPEND, bool compression_=BinaryTrajectoryCodec::isCompressionAvailable());
+
+    virtual void initialize();
+    virtual bool execute();
+    virtual void cleanup();
+
+    const BinaryTrajectoryWriter& getWriter() const { return writer; }
+
+    //! structure of a system as stored in the header of a binary trajectory
+    static BinaryTrajectoryStructure getStructure(const IngredientsType& ing);
+
+private:
+
+    //! reference to the written system
+    const IngredientsType& ingredients;
+
+    //! name of the output file
+    std::string filename;
+
+    //! NEWFILE or APPEND
+    int mode;
+
+    //! compress the frames with zlib
+    bool compression;
+
+    BinaryTrajectoryWriter writer;
+};
+
+
+/**
+* @param filename_ name of the output file
+* @param ing_ system to write
+* @param mode_ NEWFILE replaces an existing file, APPEND continues it
+* @param compression_ compress the frames, needs a build with TANGLOTRON_WITH_ZLIB
+*/
+template<class IngredientsType>
+AnalyzerWriteBinaryTrajectory<IngredientsType>::AnalyzerWriteBinaryTrajectory(const std::string& filename_, const IngredientsType& ing_, int mode_, bool compression_)
+:ingredients(ing_)
+,filename(filename_)
+,mode(mode_)
+,compression(compression_)
+{
+    writer.setCompression(compression);
+}
+
+template<class IngredientsType>
+void AnalyzerWriteBinaryTrajectory<IngredientsType>::initialize()
+{
+    writer.open(filename, getStructure(ingredients), mode == APPEND);
+}
+
+template<class IngredientsType>
+bool AnalyzerWriteBinaryTrajectory<IngredientsType>::execute()
+{
+    writer.writeFrame(ingredients.getMolecules());
+    return true;
+}
+
+/**
+* @details Writes the frame index and reports the compression ratio.
+*/
+template<class IngredientsType>
+void AnalyzerWriteBinaryTrajectory<IngredientsType>::cleanup()
+{
+    if(!writer.isOpen()){
+        return;
+    }
+    writer.close();
+    if(writer.getStoredBytes() > 0){
+        std::cout << "AnalyzerWriteBinaryTrajectory: " << filename << " raw frames " << writer.getRawBytes()
+                  << " bytes, stored " << writer.getStoredBytes() << " bytes" << std::endl;
+    }
+}
+
+/**
+* @details Every bond is stored once with the smaller index first.
+*
+* @param ing system
+*/
+template<class IngredientsType>
+BinaryTrajectoryStructure AnalyzerWriteBinaryTrajectory<IngredientsType>::getStructure(const IngredientsType& ing)
+{
+    BinaryTrajectoryStructure structure;
+    structure.nMonomers=ing.getMolecules().size();
+
+    structure.box[0]=ing.getBoxX();
+    structure.box[1]=ing.getBoxY();
+    structure.box[2]=ing.getBoxZ();
+    structure.periodic[0]=ing.isPeriodicX();
+    structure.periodic[1]=ing.isPeriodicY();
+    structure.periodic[2]=ing.isPeriodicZ();
+
+    for(uint32_t i=0; i<structure.nMonomers; i++){
+        for(uint32_t n=0; n<ing.getMolecules().getNumLinks(i); n++){
+            const uint32_t j(ing.getMolecules().getNeighborIdx(i,n));
+            if(j > i){
+                structure.bonds.push_back(i);
+                structure.bonds.push_back(j);
+            }
+        }
+        structure.attributes.push_back(ing.getMolecules()[i].getAttributeTag());
+        structure.movable.push_back(ing.getMolecules()[i].getMovableTag() ? 1 : 0);
+    }
+
+    for(uint32_t w=0; w<ing.getWalls().size(); w++){
+        const VectorInt3 base(ing.getWalls()[w].getBase());
+        const VectorInt3 normal(ing.getWalls()[w].getNormal());
+        structure.walls.push_back(base.getX());
+        structure.walls.push_back(base.getY());
+        structure.walls.push_back(base.getZ());
+        structure.walls.push_back(normal.getX());
+        structure.walls.push_back(normal.getY());
+        structure.walls.push_back(normal.getZ());
+    }
+
+    return structure;
+}
+
+#endif //ANALYZER_WRITE_BINARY_TRAJECTORY_H
@@ -0,0 +1,272 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+#ifndef FORCE_PROBE_BATCH_H
+#define FORCE_PROBE_BATCH_H
+/**
+* @file
+*
+* @class ForceProbeBatch
+*
+* @brief Probe the jumps of all monomers of a system in one pass.
+*
+* @details The batch gives the same answers as ForceProbeKernel::getAllowedJumps() for
+* every monomer, but works on a structure-of-arrays copy of the positions:
+* - the positions are copied into one array per coordinate
+* - the bond vectors of all bonds are computed from these arrays
+* - every bond is classified for the jumps of its start and its end monomer in
+*   branch-free loops over the bond vectors, which the compiler vectorizes
+* - the classifications are combined per monomer through a list of its bonds
+* Only monomers whose bonds allow a jump read the lattice, through the face check of
+* the ForceProbeKernel.
+*
+* The jumps in +z and -z are probed always, the jumps in x and y if they are
+* requested in setup().
+*
+* A bond vector is classic if its squared length is 4, 5, 6, 9 or 10. Its components
+* are in [-3,3] then, so this is the bondset of BondMoveTable. The bond vectors are
+* clamped to [-5,5], which does not change the result of a jump by one lattice unit
+* and keeps the classification in 16 bit lanes.
+*
+* The bonds are taken from the molecules in setup() and have to be set up again if
+* the connectivity changes.
+**/
+
+#include <stdint.h>
+#include <vector>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "BondMoveTable.h"
+#include "ForceProbeKernel.h"
+
+
+class ForceProbeBatch
+{
+public:
+
+    ForceProbeBatch():nMonomers(0),directions(0){}
+
+    //! set up the list of bonds of molecules, allAxes probes x and y in addition to z
+    template<class MoleculesType>
+    void setup(const MoleculesType& molecules, bool allAxes=false);
+
+    //! probe the jumps of all monomers of view
+    template<class ViewType>
+    void probe(const ViewType& view, const ForceProbeKernel& kernel);
+
+    //! bit d set if monomer i could jump into BondMoveTable::getDirection(d) in the last probe
+    const std::vector<uint8_t>& getJumps() const { return jumps; }
+
+    //! mask of the probed directions
+    uint8_t getDirections() const { return directions; }
+
+    uint32_t getNumberOfMonomers() const { return nMonomers; }
+    uint32_t getNumberOfBonds() const { return bondStart.size(); }
+
+    //! 1 if a bond vector of squared length length2 is classic
+    static uint8_t isClassicLength(int32_t length2)
+    {
+        return uint8_t( ((length2 >= 4) & (length2 <= 6)) | (length2 == 9) | (length2 == 10) );
+    }
+
+    //! bond component clamped to [-5,5], which keeps it classic after a jump if and only if the original is
+    static int16_t clampComponent(int32_t c)
+    {
+        return int16_t( (c < -5) ? -5 : ((c > 5) ? 5 : c) );
+    }
+
+private:
+
+    //! helper function: classify bond-e and bond+e for the unit vector e along the first component
+    static void classifyAxis(uint32_t nBonds, const int16_t* along, const int16_t* side1, const int16_t* side2, uint8_t* minus, uint8_t* plus);
+
+    uint32_t nMonomers;
+
+    //! mask of the probed directions
+    uint8_t directions;
+
+    //! start and end monomer of every bond, start < end
+    std::vector<uint32_t> bondStart;
+    std::vector<uint32_t> bondEnd;
+
+    //! bonds of monomer i are links[linkOffsets[i]] to links[linkOffsets[i+1]-1], entry 2*bond+(1 if i is the end)
+    std::vector<uint32_t> linkOffsets;
+    std::vector<uint32_t> links;
+
+    //! positions of the monomers
+    std::vector<int32_t> x, y, z;
+
+    //! bond vectors from start to end, clamped to [-5,5] for 16 bit arithmetic
+    std::vector<int16_t> bondX, bondY, bondZ;
+
+    //! classic[d][k] is 1 if bond k minus the unit vector of direction d is classic
+    std::vector<uint8_t> classic[6];
+
+    //! directions allowed by bond k for a jump of its start and its end monomer
+    std::vector<uint8_t> startMoves;
+    std::vector<uint8_t> endMoves;
+
+    //! result of the last probe
+    std::vector<uint8_t> jumps;
+};
+
+
+/**
+* @param molecules molecules providing the links
+* @param allAxes probe the jumps in x and y as well
+*/
+template<class MoleculesType>
+void ForceProbeBatch::setup(const MoleculesType& molecules, bool allAxes)
+{
+    nMonomers=molecules.size();
+    directions=uint8_t(allAxes ? BondMoveTable::allMoves() : 0x30);
+    bondStart.clear();
+    bondEnd.clear();
+    linkOffsets.assign(1,0);
+    links.clear();
+
+    for(uint32_t i=0; i<nMonomers; i++){
+        for(uint32_t n=0; n<molecules.getNumLinks(i); n++){
+            const uint32_t j(molecules.getNeighborIdx(i,n));
+            if(j > i){
+                bondStart.push_back(i);
+                bondEnd.push_back(j);
+            }
+        }
+    }
+
+    // bonds of every monomer, the bonds are sorted by their start
+    std::vector<std::vector<uint32_t> > monomerLinks(nMonomers);
+    for(uint32_t k=0; k<bondStart.size(); k++){
+        monomerLinks[bondStart[k]].push_back(2*k);
+        monomerLinks[bondEnd[k]].push_back(2*k+1);
+    }
+    for(uint32_t i=0; i<nMonomers; i++){
+        links.insert(links.end(), monomerLinks[i].begin(), monomerLinks[i].end());
+        linkOffsets.push_back(links.size());
+    }
+
+    x.resize(nMonomers);
+    y.resize(nMonomers);
+    z.resize(nMonomers);
+    bondX.resize(bondStart.size());
+    bondY.resize(bondStart.size());
+    bondZ.resize(bondStart.size());
+    for(uint32_t d=0; d<6; d++){
+        classic[d].assign(((directions >> d) & 1) ? bondStart.size() : 0, 0);
+    }
+    startMoves.resize(bondStart.size());
+    endMoves.resize(bondStart.size());
+    jumps.resize(nMonomers);
+}
+
+/**
+* @details If the start monomer of a bond jumps by e the bond vector becomes bond-e,
+* if the end monomer jumps by e the bond vector seen from the end becomes -(bond+e).
+* So the classification of bond-e and bond+e per axis covers all jumps along the axis,
+* for the end monomer with the directions d and d^1 exchanged.
+*
+* @param view system as seen by the force probe, see ForceProbeView
+* @param kernel kernel providing the face check
+*/
+template<class ViewType>
+void ForceProbeBatch::probe(const ViewType& view, const ForceProbeKernel& kernel)
+{
+    const uint32_t nBonds(bondStart.size());
+
+    for(uint32_t i=0; i<nMonomers; i++){
+        const VectorInt3& pos(view.getMolecules()[i]);
+        x[i]=pos.getX();
+        y[i]=pos.getY();
+        z[i]=pos.getZ();
+    }
+
+    for(uint32_t k=0; k<nBonds; k++){
+        bondX[k]=clampComponent(x[bondEnd[k]]-x[bondStart[k]]);
+        bondY[k]=clampComponent(y[bondEnd[k]]-y[bondStart[k]]);
+        bondZ[k]=clampComponent(z[bondEnd[k]]-z[bondStart[k]]);
+    }
+
+    if(directions & 0x03){
+        classifyAxis(nBonds, bondX.data(), bondY.data(), bondZ.data(), classic[0].data(), classic[1].data());
+        classifyAxis(nBonds, bondY.data(), bondX.data(), bondZ.data(), classic[2].data(), classic[3].data());
+    }
+    classifyAxis(nBonds, bondZ.data(), bondX.data(), bondY.data(), classic[4].data(), classic[5].data());
+
+    // pack the classifications into one mask per bond end
+    uint8_t* const start(startMoves.data());
+    uint8_t* const end(endMoves.data());
+    for(uint32_t k=0; k<nBonds; k++){
+        start[k]=uint8_t((classic[4][k] << 4) | (classic[5][k] << 5));
+        end[k]=uint8_t((classic[5][k] << 4) | (classic[4][k] << 5));
+    }
+    if(directions & 0x03){
+        for(uint32_t k=0; k<nBonds; k++){
+            start[k]|=uint8_t(classic[0][k] | (classic[1][k] << 1) | (classic[2][k] << 2) | (classic[3][k] << 3));
+            end[k]|=uint8_t(classic[1][k] | (classic[0][k] << 1) | (classic[3][k] << 2) | (classic[2][k] << 3));
+        }
+    }
+
+    for(uint32_t i=0; i<nMonomers; i++){
+        uint8_t allowed(directions);
+        for(uint32_t l=linkOffsets[i]; l<linkOffsets[i+1]; l++){
+            allowed&=((links[l] & 1) ? end[links[l] >> 1] : start[links[l] >> 1]);
+        }
+
+        const VectorInt3 pos(x[i],y[i],z[i]);
+        for(uint32_t d=0; d<6; d++){
+            if(((allowed >> d) & 1) && !kernel.isFaceFree(view, pos, BondMoveTable::getDirection(d))){
+                allowed&=uint8_t(~(1u << d));
+            }
+        }
+        jumps[i]=allowed;
+    }
+}
+
+/**
+* @details 16 bit lanes, the squared lengths are at most 3*36.
+*
+* @param nBonds number of bonds
+* @param along component of the bond vectors along the axis
+* @param side1 first component perpendicular to the axis
+* @param side2 second component perpendicular to the axis
+* @param minus set to 1 if bond-e is classic
+* @param plus set to 1 if bond+e is classic
+*/
+inline void ForceProbeBatch::classifyAxis(uint32_t nBonds, const int16_t* along, const int16_t* side1, const int16_t* side2, uint8_t* minus, uint8_t* plus)
+{
+    for(uint32_t k=0; k<nBonds; k++){
+        const int16_t lateral(side1[k]*side1[k]+side2[k]*side2[k]);
+        const int16_t below(along[k]-1), above(along[k]+1);
+        minus[k]=isClassicLength(int16_t(lateral+below*below));
+        plus[k]=isClassicLength(int16_t(lateral+above*above));
+    }
+}
+
+#endif //FORCE_PROBE_BATCH_H
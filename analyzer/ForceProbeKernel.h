@@ -0,0 +1,185 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef FORCE_PROBE_KERNEL_H
+#define FORCE_PROBE_KERNEL_H
+/**
+* @file
+*
+* @class ForceProbeKernel
+*
+* @brief Check if a monomer could jump by one lattice unit reading the lattice of
+* the system directly.
+*
+* @details The kernel answers the same question as MoveLocalSc::check() on a copy of
+* the system with periodic boundaries, without walls and with the probed monomer set
+* movable: Are the four lattice sites in front of the monomer cube free and are all
+* bonds to the neighbors still part of the classic BFM bondset after the jump?
+* Walls and movable tags of the system are ignored. Periodicity in z is given by the
+* folding of the lattice.
+*
+* The bonds are checked with one lookup per neighbor in a BondMoveTable.
+*
+* getAllowedJumps() probes all six directions of a monomer in one pass: the bonds are
+* looked up once for all directions, and the six faces around the monomer cube are
+* disjoint, so every lattice site of the neighbourhood is read at most once.
+*
+* If the system provides isFaceFree(pos,dir) itself, e.g. through the lattice
+* FeatureLatticeBitPacked, the face is checked by that function instead of four
+* single lattice reads.
+**/
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "BondMoveTable.h"
+
+
+/**
+* @brief Trait detecting a member function isFaceFree(const VectorInt3&, const VectorInt3&) const
+**/
+template<class IngredientsType>
+struct HasFaceCheck
+{
+private:
+    template<class T>
+    static auto test(int) -> decltype(std::declval<const T&>().isFaceFree(VectorInt3(),VectorInt3()), std::true_type());
+    template<class T>
+    static std::false_type test(...);
+public:
+    static const bool value=decltype(test<IngredientsType>(0))::value;
+};
+
+
+class ForceProbeKernel
+{
+public:
+
+    //! check if monomer idx of ing could jump into direction dir (unit vector)
+    template<class IngredientsType>
+    bool checkJump(const IngredientsType& ing, uint32_t idx, const VectorInt3& dir) const;
+
+    //! mask of the directions in the order of BondMoveTable monomer idx of ing could jump into
+    template<class IngredientsType>
+    uint8_t getAllowedJumps(const IngredientsType& ing, uint32_t idx, uint8_t directions=BondMoveTable::allMoves()) const;
+
+    //! check if the four lattice sites in front of the monomer at pos in direction dir are free
+    template<class IngredientsType>
+    bool isFaceFree(const IngredientsType& ing, const VectorInt3& pos, const VectorInt3& dir) const;
+
+    //! check if a bond vector is part of the classic BFM bondset
+    bool isClassicBond(const VectorInt3& bond) const { return bondMoves.isClassicBond(bond); }
+
+private:
+
+    //! face check of the system itself
+    template<class IngredientsType>
+    bool checkFace(const IngredientsType& ing, const VectorInt3& pos, const VectorInt3& dir, std::true_type) const
+    {
+        return ing.isFaceFree(pos,dir);
+    }
+
+    //! face check by four lattice reads
+    template<class IngredientsType>
+    bool checkFace(const IngredientsType& ing, const VectorInt3& pos, const VectorInt3& dir, std::false_type) const;
+
+    //! lookup table for the classic bondset and the moves keeping bonds classic
+    BondMoveTable bondMoves;
+
+};
+
+
+/**
+* @param ing system providing molecules and lattice
+* @param idx index of the probed monomer
+* @param dir direction of the jump, one of the six unit vectors
+* @return true if the jump would be accepted in the force probe
+*/
+template<class IngredientsType>
+inline bool ForceProbeKernel::checkJump(const IngredientsType& ing, uint32_t idx, const VectorInt3& dir) const
+{
+    return ((bondMoves.getAllowedMoves(ing.getMolecules(), idx) >> BondMoveTable::getDirectionIndex(dir)) & 1) &&
+           isFaceFree(ing, ing.getMolecules()[idx], dir);
+}
+
+/**
+* @details The faces are only checked for directions which keep all bonds classic.
+*
+* @param ing system providing molecules and lattice
+* @param idx index of the probed monomer
+* @param directions mask of the probed directions, all six by default
+* @return bit d set if the jump into BondMoveTable::getDirection(d) would be accepted
+*/
+template<class IngredientsType>
+inline uint8_t ForceProbeKernel::getAllowedJumps(const IngredientsType& ing, uint32_t idx, uint8_t directions) const
+{
+    uint8_t allowed(bondMoves.getAllowedMoves(ing.getMolecules(), idx) & directions);
+    const VectorInt3& pos(ing.getMolecules()[idx]);
+    for(uint32_t d=0; d<6; d++){
+        if(((allowed >> d) & 1) && !isFaceFree(ing, pos, BondMoveTable::getDirection(d))){
+            allowed&=uint8_t(~(1u << d));
+        }
+    }
+    return allowed;
+}
+
+/**
+* @details The monomer occupies the cube [pos,pos+(1,1,1)]. For a jump in positive
+* direction the sites at pos+2*dir are checked, in negative direction at pos+dir.
+*
+* @param ing system providing the lattice
+* @param pos lower left corner of the monomer cube
+* @param dir direction of the jump, one of the six unit vectors
+*/
+template<class IngredientsType>
+inline bool ForceProbeKernel::isFaceFree(const IngredientsType& ing, const VectorInt3& pos, const VectorInt3& dir) const
+{
+    return checkFace(ing, pos, dir, std::integral_constant<bool,HasFaceCheck<IngredientsType>::value>());
+}
+
+template<class IngredientsType>
+inline bool ForceProbeKernel::checkFace(const IngredientsType& ing, const VectorInt3& pos, const VectorInt3& dir, std::false_type) const
+{
+    // two directions perpendicular to dir spanning the face
+    const VectorInt3 perp1( (dir.getX()==0) ? 1 : 0, (dir.getX()!=0) ? 1 : 0, 0);
+    const VectorInt3 perp2( 0, (dir.getZ()==0) ? 0 : 1, (dir.getZ()==0) ? 1 : 0);
+
+    VectorInt3 face(pos+dir);
+    if(dir.getX()>0 || dir.getY()>0 || dir.getZ()>0){
+        face+=dir;
+    }
+
+    return !( ing.getLatticeEntry(face) ||
+              ing.getLatticeEntry(face+perp1) ||
+              ing.getLatticeEntry(face+perp2) ||
+              ing.getLatticeEntry(face+perp1+perp2) );
+}
+
+#endif //FORCE_PROBE_KERNEL_H
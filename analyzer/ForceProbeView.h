@@ -0,0 +1,145 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef FORCE_PROBE_VIEW_H
+#define FORCE_PROBE_VIEW_H
+/**
+* @file
+*
+* @class ForceProbeView
+*
+* @brief Read-only view of a system as it is seen by the force probe.
+*
+* @details The view wraps the molecules and the lattice of the simulated system
+* without copying them and applies the changes the force analyzer needs:
+* - the box is periodic in all directions, lattice positions are folded in z into [0,boxZ)
+* - walls are not part of the view
+* - movable tags are not part of the view, so the probed monomer is always movable
+*
+* Any number of analyzers can hold a view of the same system.
+*
+* If the system provides a face check isFaceFree(pos,dir), the view provides it as
+* well with the same periodic folding in z.
+*
+* @tparam IngredientsType
+**/
+
+#include <utility>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+
+template<class IngredientsType>
+class ForceProbeView
+{
+public:
+
+    typedef typename IngredientsType::molecules_type molecules_type;
+
+    explicit ForceProbeView(const IngredientsType& ing_):ingredients(ing_){}
+
+    //! molecules of the viewed system
+    const molecules_type& getMolecules() const { return ingredients.getMolecules(); }
+
+    //! lattice entry of the viewed system with periodic folding in z
+    bool getLatticeEntry(const VectorInt3& pos) const;
+
+    //! face check of the viewed system with periodic folding in z, only if the system has one
+    template<class I=IngredientsType>
+    auto isFaceFree(const VectorInt3& pos, const VectorInt3& dir) const -> decltype(std::declval<const I&>().isFaceFree(pos,dir));
+
+    uint32_t getBoxX() const { return ingredients.getBoxX(); }
+    uint32_t getBoxY() const { return ingredients.getBoxY(); }
+    uint32_t getBoxZ() const { return ingredients.getBoxZ(); }
+
+    bool isPeriodicX() const { return true; }
+    bool isPeriodicY() const { return true; }
+    bool isPeriodicZ() const { return true; }
+
+private:
+
+    //! reference to the viewed system
+    const IngredientsType& ingredients;
+
+};
+
+/**
+* @details The probed sites are at most one lattice unit outside of the box, so the
+* folding in z is done by a single addition or subtraction of the box size.
+*
+* @param pos lattice position
+*/
+template<class IngredientsType>
+inline bool ForceProbeView<IngredientsType>::getLatticeEntry(const VectorInt3& pos) const
+{
+    const int32_t boxZ(ingredients.getBoxZ());
+    int32_t z(pos.getZ());
+    if(z < 0){
+        z+=boxZ;
+    }else if(z >= boxZ){
+        z-=boxZ;
+    }
+    return ingredients.getLatticeEntry(VectorInt3(pos.getX(),pos.getY(),z));
+}
+
+/**
+* @details Faces perpendicular to z which lie one lattice unit outside of the box are
+* shifted by the box size into the box. Faces perpendicular to x or y spanning the
+* boundary in z are read site by site.
+*
+* @param pos lower left corner of the monomer cube
+* @param dir direction of the jump, one of the six unit vectors
+*/
+template<class IngredientsType>
+template<class I>
+inline auto ForceProbeView<IngredientsType>::isFaceFree(const VectorInt3& pos, const VectorInt3& dir) const -> decltype(std::declval<const I&>().isFaceFree(pos,dir))
+{
+    const int32_t boxZ(ingredients.getBoxZ());
+    const int32_t z(pos.getZ());
+
+    if(dir.getZ()!=0){
+        const int32_t zFace( z + ((dir.getZ() > 0) ? 2 : -1) );
+        if(zFace < 0){
+            return ingredients.isFaceFree(VectorInt3(pos.getX(),pos.getY(),z+boxZ),dir);
+        }else if(zFace >= boxZ){
+            return ingredients.isFaceFree(VectorInt3(pos.getX(),pos.getY(),z-boxZ),dir);
+        }
+        return ingredients.isFaceFree(pos,dir);
+    }
+
+    if(z >= 0 && z+1 < boxZ){
+        return ingredients.isFaceFree(pos,dir);
+    }
+
+    const VectorInt3 face( pos + dir + ((dir.getX()>0 || dir.getY()>0) ? dir : VectorInt3(0,0,0)) );
+    const VectorInt3 perp( (dir.getX()==0) ? 1 : 0, (dir.getX()!=0) ? 1 : 0, 0);
+    const VectorInt3 up(0,0,1);
+    return !( getLatticeEntry(face) || getLatticeEntry(face+perp) ||
+              getLatticeEntry(face+up) || getLatticeEntry(face+perp+up) );
+}
+
+#endif //FORCE_PROBE_VIEW_H
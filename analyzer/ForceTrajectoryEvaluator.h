@@ -0,0 +1,294 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+#ifndef FORCE_TRAJECTORY_EVALUATOR_H
+#define FORCE_TRAJECTORY_EVALUATOR_H
+/**
+* @file
+*
+* @class ForceTrajectoryEvaluator
+*
+* @brief Probe the force of selected monomers on every frame of a stored trajectory.
+*
+* @details The frames of a trajectory are split into chunks of consecutive frames,
+* which are distributed over the threads of a ThreadPool. Every chunk is evaluated with
+* its own copy of the system, its own TrajectoryType::FrameReader and its own
+* AnalyzerForce, so the threads share nothing but the read-only trajectory. Within a
+* chunk the lattice is updated for the monomers which moved since the last frame only.
+* The copy of a chunk lives as long as the chunk is evaluated, so at most one lattice
+* per thread is allocated at a time. For huge boxes use a hashed lattice, e.g. the
+* executable evaluateForceTrajectorySparse.
+*
+* The trajectory is a MappedBinaryTrajectory or a BfmTrajectory, any class with
+* getStructure(), getNumberOfFrames(), getMcs(n), isOpen() and a FrameReader reading
+* the positions of frame n works.
+*
+* The chunk analyzers record the outcome of every probe, see
+* AnalyzerForce::setRecordProbes(). After run() the records of all chunks are replayed
+* into one analyzer in frame order, so the blocking analysis sees the whole trajectory
+* as one series and the result equals a serial evaluation, independent of the number
+* of threads and of the chunk size.
+*
+* @tparam IngredientsType
+* @tparam TrajectoryType
+**/
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "AnalyzerForce.h"
+#include "MappedBinaryTrajectory.h"
+#include "ThreadPool.h"
+#include "UpdaterReadBinaryTrajectory.h"
+
+
+template<class IngredientsType, class TrajectoryType=MappedBinaryTrajectory>
+class ForceTrajectoryEvaluator
+{
+public:
+    ForceTrajectoryEvaluator(const TrajectoryType& trajectory_, std::vector<uint32_t> selectedMonomers_, uint32_t framesPerChunk_=64);
+
+    //! probe every every-th frame starting at frame first, frames before age beginCalculation are skipped
+    void run(uint32_t nThreads, uint64_t first=0, uint64_t every=1, uint64_t beginCalculation=0);
+
+    //! force statistics of all evaluated frames, available after run()
+    const AnalyzerForce<IngredientsType>& getMergedForce() const;
+
+    //! system with the structure of the trajectory at the last evaluated frame
+    const IngredientsType& getIngredients() const { return ingredients; }
+
+    //! output file of the merged results, force.dat by default
+    void setFilename(const std::string& filename_){ filename=filename_; }
+
+    //! optional measurements of the chunk analyzers, see AnalyzerForce::setOptions()
+    void setForceOptions(const AnalyzerForceOptions& forceOptions_){ forceOptions=forceOptions_; }
+
+    uint64_t getNumberOfEvaluatedFrames() const { return frames.size(); }
+    uint32_t getNumberOfChunks() const { return chunkForces.size(); }
+    uint32_t getFramesPerChunk() const { return framesPerChunk; }
+
+private:
+
+    //! trajectory the frames are read from
+    const TrajectoryType& trajectory;
+
+    //! monomers the force is measured for
+    const std::vector<uint32_t> selectedMonomers;
+
+    //! number of consecutive frames evaluated by one task
+    uint32_t framesPerChunk;
+
+    //! system the results refer to
+    IngredientsType ingredients;
+
+    //! indices of the frames to evaluate
+    std::vector<uint64_t> frames;
+
+    //! statistics of every chunk, merged in chunk order
+    std::vector<std::unique_ptr<AnalyzerForce<IngredientsType> > > chunkForces;
+
+    //! merged force statistics of all chunks
+    std::unique_ptr<AnalyzerForce<IngredientsType> > mergedForce;
+
+    //! output file of the merged results
+    std::string filename;
+
+    //! optional measurements of the analyzers
+    AnalyzerForceOptions forceOptions;
+
+    //! helper function: evaluate chunk c
+    void evaluateChunk(uint32_t c, uint64_t beginCalculation);
+
+    //! helper function: set the positions of ing to positions, without updating the lattice
+    static void setPositions(IngredientsType& ing, const std::vector<VectorInt3>& positions);
+
+    //! helper function: move the monomers of ing to positions, updating the lattice of moved monomers only
+    static void moveMonomers(IngredientsType& ing, const std::vector<VectorInt3>& positions);
+
+    //! helper function: set all eight lattice sites of the monomer cube with lower left corner pos
+    static void setMonomerCube(IngredientsType& ing, const VectorInt3& pos, bool value);
+};
+
+/**
+* @param trajectory_ open trajectory, has to outlive the evaluator
+* @param selectedMonomers_ monomers the force is measured for
+* @param framesPerChunk_ number of consecutive frames evaluated by one task
+*/
+template<class IngredientsType, class TrajectoryType>
+ForceTrajectoryEvaluator<IngredientsType,TrajectoryType>::ForceTrajectoryEvaluator(const TrajectoryType& trajectory_, std::vector<uint32_t> selectedMonomers_, uint32_t framesPerChunk_)
+:trajectory(trajectory_),selectedMonomers(selectedMonomers_),framesPerChunk(framesPerChunk_),filename("force.dat"),forceOptions()
+{
+    if(framesPerChunk == 0){
+        throw std::runtime_error("ForceTrajectoryEvaluator: number of frames per chunk must be positive");
+    }
+    if(!trajectory.isOpen()){
+        throw std::runtime_error("ForceTrajectoryEvaluator: trajectory is not open");
+    }
+    for(uint32_t i=0; i<selectedMonomers.size(); i++){
+        if(selectedMonomers[i] >= trajectory.getStructure().nMonomers){
+            throw std::runtime_error("ForceTrajectoryEvaluator: selected monomer is not part of the trajectory");
+        }
+    }
+    UpdaterReadBinaryTrajectory<IngredientsType>::createSystem(trajectory.getStructure(), ingredients);
+}
+
+/**
+* @details Every chunk probes its first frame in AnalyzerForce::initialize() and all
+* further frames in AnalyzerForce::execute(), so every frame is probed once.
+*
+* @param nThreads number of threads, 0 uses the number of cores
+* @param first index of the first frame
+* @param every distance between two evaluated frames
+* @param beginCalculation age of the first frame which is probed
+*/
+template<class IngredientsType, class TrajectoryType>
+void ForceTrajectoryEvaluator<IngredientsType,TrajectoryType>::run(uint32_t nThreads, uint64_t first, uint64_t every, uint64_t beginCalculation)
+{
+    if(every == 0){
+        throw std::runtime_error("ForceTrajectoryEvaluator: every has to be at least 1");
+    }
+    mergedForce.reset();
+
+    frames.clear();
+    for(uint64_t n=first; n<trajectory.getNumberOfFrames(); n+=every){
+        frames.push_back(n);
+    }
+
+    chunkForces.clear();
+    chunkForces.resize((frames.size()+framesPerChunk-1)/framesPerChunk);
+    for(uint32_t c=0; c<chunkForces.size(); c++){
+        chunkForces[c].reset(new AnalyzerForce<IngredientsType>(ingredients,selectedMonomers,beginCalculation));
+        chunkForces[c]->setOptions(forceOptions);
+        chunkForces[c]->setRecordProbes(true);
+    }
+
+    ThreadPool pool(nThreads);
+    std::cout<<"ForceTrajectoryEvaluator: evaluate "<<frames.size()<<" frames in "<<chunkForces.size()<<" chunks on "<<pool.getNumberOfThreads()<<" threads"<<std::endl;
+    pool.run(chunkForces.size(), [&](uint32_t c){ evaluateChunk(c,beginCalculation); });
+
+    if(!frames.empty()){
+        typename TrajectoryType::FrameReader reader(trajectory);
+        setPositions(ingredients, reader.read(frames.back()));
+        ingredients.modifyMolecules().setAge(trajectory.getMcs(frames.back()));
+    }
+
+    mergedForce.reset(new AnalyzerForce<IngredientsType>(ingredients,selectedMonomers,beginCalculation));
+    mergedForce->setFilename(filename);
+    mergedForce->setOptions(forceOptions);
+    for(uint32_t c=0; c<chunkForces.size(); c++){
+        mergedForce->merge(*(chunkForces[c]));
+        chunkForces[c]->setRecordProbes(false);
+    }
+}
+
+template<class IngredientsType, class TrajectoryType>
+const AnalyzerForce<IngredientsType>& ForceTrajectoryEvaluator<IngredientsType,TrajectoryType>::getMergedForce() const
+{
+    if(!mergedForce){
+        throw std::runtime_error("ForceTrajectoryEvaluator: merged force is only available after run()");
+    }
+    return *mergedForce;
+}
+
+/**
+* @details Runs in a thread of the pool. The system of the chunk lives for the chunk
+* only, its statistics are kept in chunkForces[c].
+*/
+template<class IngredientsType, class TrajectoryType>
+void ForceTrajectoryEvaluator<IngredientsType,TrajectoryType>::evaluateChunk(uint32_t c, uint64_t beginCalculation)
+{
+    const uint64_t begin(uint64_t(c)*framesPerChunk);
+    const uint64_t end(std::min<uint64_t>(begin+framesPerChunk,frames.size()));
+
+    IngredientsType ing;
+    UpdaterReadBinaryTrajectory<IngredientsType>::createSystem(trajectory.getStructure(), ing);
+
+    typename TrajectoryType::FrameReader reader(trajectory);
+    setPositions(ing, reader.read(frames[begin]));
+    ing.modifyMolecules().setAge(trajectory.getMcs(frames[begin]));
+    ing.synchronize();
+
+    AnalyzerForce<IngredientsType> analyzer(ing,selectedMonomers,beginCalculation);
+    analyzer.setOptions(forceOptions);
+    analyzer.setRecordProbes(true);
+    analyzer.initialize();
+
+    for(uint64_t n=begin+1; n<end; n++){
+        moveMonomers(ing, reader.read(frames[n]));
+        ing.modifyMolecules().setAge(trajectory.getMcs(frames[n]));
+        analyzer.execute();
+    }
+
+    chunkForces[c]->merge(analyzer);
+}
+
+template<class IngredientsType, class TrajectoryType>
+void ForceTrajectoryEvaluator<IngredientsType,TrajectoryType>::setPositions(IngredientsType& ing, const std::vector<VectorInt3>& positions)
+{
+    for(uint32_t i=0; i<positions.size(); i++){
+        ing.modifyMolecules()[i].setAllCoordinates(positions[i].getX(),positions[i].getY(),positions[i].getZ());
+    }
+}
+
+/**
+* @details All moved monomers are removed from the lattice before any of them is set
+* again, so monomers swapping their sites between two frames are handled as well.
+*/
+template<class IngredientsType, class TrajectoryType>
+void ForceTrajectoryEvaluator<IngredientsType,TrajectoryType>::moveMonomers(IngredientsType& ing, const std::vector<VectorInt3>& positions)
+{
+    for(uint32_t i=0; i<positions.size(); i++){
+        if(ing.getMolecules()[i] != positions[i]){
+            setMonomerCube(ing, ing.getMolecules()[i], false);
+        }
+    }
+    for(uint32_t i=0; i<positions.size(); i++){
+        if(ing.getMolecules()[i] != positions[i]){
+            setMonomerCube(ing, positions[i], true);
+            ing.modifyMolecules()[i].setAllCoordinates(positions[i].getX(),positions[i].getY(),positions[i].getZ());
+        }
+    }
+}
+
+template<class IngredientsType, class TrajectoryType>
+inline void ForceTrajectoryEvaluator<IngredientsType,TrajectoryType>::setMonomerCube(IngredientsType& ing, const VectorInt3& pos, bool value)
+{
+    for(int32_t dx=0; dx<2; dx++){
+        for(int32_t dy=0; dy<2; dy++){
+            for(int32_t dz=0; dz<2; dz++){
+                ing.setLatticeEntry(pos+VectorInt3(dx,dy,dz),value);
+            }
+        }
+    }
+}
+
+#endif //FORCE_TRAJECTORY_EVALUATOR_H
@@ -0,0 +1,162 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
+
+#include "FeatureSlitConfinement.h"
+#include "UpdaterReadBinaryTrajectory.h"
+#include "UpdaterReadBfmFileIndexed.h"
+#include "AnalyzerWriteBinaryTrajectory.h"
+#include "BfmFrameIndex.h"
+
+#include <cstdio>
+
+// read in command line options
+#include <boost/program_options.hpp>
+using namespace boost::program_options;
+
+//! true if filename ends with extension
+bool hasExtension(const std::string& filename, const std::string& extension)
+{
+  return filename.size() >= extension.size() && filename.compare(filename.size()-extension.size(), extension.size(), extension) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+  /* read arguments
+  * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  */
+  std::string ifilename, ofilename;
+  uint32_t every;
+  bool lastOnly(false);
+
+  try{
+    options_description desc{"Convert a binary trajectory (.btr) of SimualtorChainInSlitForce to the bfm format, or a bfm file to a binary trajectory\nAllowed options"};
+    desc.add_options()
+      ("help,h", "produce help message")
+      ("ifilename,i", value<std::string>(&ifilename)->default_value("configRun.btr"), "input binary trajectory, or bfm file (.bfm) read frame by frame through its index")
+      ("ofilename,o", value<std::string>(&ofilename), "output file, it is replaced, default: input file with the extension .bfm or .btr swapped")
+      ("every,e", value<uint32_t>(&every)->default_value(1), "write every n-th frame only")
+      ("last,l", bool_switch(&lastOnly), "write the last frame only");
+
+    variables_map options_map;
+    store(parse_command_line(argc, argv, desc), options_map);
+    notify(options_map);
+
+    // help option
+    if (options_map.count("help")) {
+      std::cout << desc << "\n";
+      return 1;
+    }
+  } catch (const error &ex){
+    std::cerr << ex.what() << '\n';
+  }
+
+  const bool fromBfm(hasExtension(ifilename,".bfm"));
+  if(ofilename.empty()){
+    const std::string stem(hasExtension(ifilename,".bfm") || hasExtension(ifilename,".btr") ? ifilename.substr(0,ifilename.size()-4) : ifilename);
+    ofilename=stem+(fromBfm ? ".btr" : ".bfm");
+  }
+
+  /* initialize system
+  * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  */
+
+  // no lattice: the frames are only copied, the synchronize of every frame stays cheap for any box
+  typedef LOKI_TYPELIST_4(FeatureMoleculesIO, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+  const uint max_bonds=4;
+  typedef ConfigureSystem<VectorInt3,Features,max_bonds> Config;
+  typedef Ingredients<Config> IngredientsType;
+  IngredientsType ingredients;
+
+  /* convert frame by frame
+  * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  */
+  try{
+    if(every == 0){
+      throw std::runtime_error("every has to be at least 1");
+    }
+
+    if(fromBfm){
+      // bfm to binary trajectory: the frames are looked up in the sidecar index of the bfm file
+      BfmFrameIndex index(ifilename);
+      index.update();
+      if(index.getNumberOfFrames() == 0){
+        throw std::runtime_error(ifilename+" contains no frame");
+      }
+
+      const uint64_t first(lastOnly ? index.getNumberOfFrames()-1 : 0);
+      UpdaterReadBfmFileIndexed<IngredientsType>::readFrame(index,first,ingredients);
+
+      AnalyzerWriteBinaryTrajectory<IngredientsType> writer(ofilename,ingredients,AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE);
+      writer.initialize();
+      writer.execute();
+      uint64_t nWritten(1);
+      for(uint64_t n=first+every; n<index.getNumberOfFrames(); n+=every){
+        UpdaterReadBfmFileIndexed<IngredientsType>::readFrame(index,n,ingredients);
+        writer.execute();
+        nWritten++;
+      }
+      writer.cleanup();
+
+      std::cout << "converted " << nWritten << " of " << index.getNumberOfFrames() << " frames of " << ifilename << " to " << ofilename << std::endl;
+      return 0;
+    }
+
+    UpdaterReadBinaryTrajectory<IngredientsType> reader(ifilename,ingredients,(lastOnly ? UpdaterReadBinaryTrajectory<IngredientsType>::READ_LAST_CONFIG : UpdaterReadBinaryTrajectory<IngredientsType>::READ_STEPWISE));
+    reader.initialize();
+
+    std::remove(ofilename.c_str());
+    AnalyzerWriteBfmFile<IngredientsType> writer(ofilename,ingredients,AnalyzerWriteBfmFile<IngredientsType>::APPEND);
+    writer.initialize();
+
+    uint64_t nWritten(0);
+    if(lastOnly){
+      writer.execute();
+      nWritten++;
+    }else{
+      for(uint64_t n=0; n<reader.getNumberOfFrames(); n+=every){
+        reader.readFrame(n);
+        writer.execute();
+        nWritten++;
+      }
+    }
+    writer.cleanup();
+
+    std::cout << "converted " << nWritten << " of " << reader.getNumberOfFrames() << " frames of " << ifilename << " to " << ofilename << std::endl;
+
+  }catch(std::exception& err){
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -29,7 +29,6 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 #include <LeMonADE/feature/FeatureMoleculesIO.h>
 #include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
 #include <LeMonADE/feature/FeatureAttributes.h>
-#include <LeMonADE/feature/FeatureWall.h>
 #include <LeMonADE/feature/FeatureFixedMonomers.h>
 
 #include <LeMonADE/utility/TaskManager.h>
@@ -37,6 +36,9 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
 
+#include "FeatureLatticeBitPacked.h"
+#include "FeatureLatticeSparse.h"
+#include "FeatureSlitConfinement.h"
 #include "UpdaterCreateChainInSlit.h"
 
 
@@ -51,6 +53,7 @@ int main(int argc, char* argv[])
   */
   std::string filename;
   uint32_t LinearChainLength, slitSize, box, mode, fixedPosition;
+  bool compactBox;
 
   
   try{
@@ -62,7 +65,8 @@ int main(int argc, char* argv[])
       ("box,b", value<uint32_t>(&box)->default_value(128), "boxsize ( in x,y)")
       ("slit,s", value<uint32_t>(&slitSize)->default_value(0), "size of slit (in z)")
       ("positionZ,p", value<uint32_t>(&fixedPosition)->default_value(0), "fixed monomer position")
-      ("mode,m", value<uint32_t>(&mode)->default_value(0), "mode: 0=grafted chain, 1=chain fixed between walls, 2=monomer fixed in space");
+      ("mode,m", value<uint32_t>(&mode)->default_value(0), "mode: 0=grafted chain, 1=chain fixed between walls, 2=monomer fixed in space")
+      ("compact,c", bool_switch(&compactBox), "use the slit size as box size in z instead of the next power of two");
       
     variables_map options_map;
     store(parse_command_line(argc, argv, desc), options_map);
@@ -81,13 +85,20 @@ int main(int argc, char* argv[])
   std::cout << "file name = '" << filename <<"'"<<std::endl
   << "LinearChainLength = '" << LinearChainLength <<"'\t"
   << "mode = '" << mode <<"'"<<std::endl
-  << "box size = '" << box <<"' ("<<slitSize<<")"<<std::endl;
+  << "box size = '" << box <<"' ("<<slitSize<<")"<<std::endl
+  << "compact box = '" << compactBox <<"'"<<std::endl;
   
   /* initialize system
   * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++   
   */
 
-  typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+  // dense lattice for slits, hashed lattice for single chains in huge boxes (TANGLOTRON_SPARSE_LATTICE)
+#ifdef TANGLOTRON_SPARSE_LATTICE
+  typedef FeatureLatticeSparse<bool> LatticeType;
+#else
+  typedef FeatureLatticeBitPacked LatticeType;
+#endif
+  typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< LatticeType >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
   const uint max_bonds=4;
   // define maximal number of bonds
   typedef ConfigureSystem<VectorInt3,Features,max_bonds> Config;
@@ -106,9 +117,9 @@ int main(int argc, char* argv[])
   * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
   */
   TaskManager taskManager;
-   // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0);
+   // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0, bool compactBox_=false);
     // SINGLE_FIXPOINT_BOTTOM=0,    DOUBLE_FIXED_AT_WALLS=1,    FIXED_AT_WALL_AND_IN_SPACE=2
-  taskManager.addUpdater(new UpdaterCreateChainInSlit<IngredientsType>(ingredients, LinearChainLength, slitSize, box, mode, fixedPosition));
+  taskManager.addUpdater(new UpdaterCreateChainInSlit<IngredientsType>(ingredients, LinearChainLength, slitSize, box, mode, fixedPosition, compactBox));
 
   taskManager.addAnalyzer(new AnalyzerWriteBfmFile<IngredientsType>(filename,ingredients,AnalyzerWriteBfmFile<IngredientsType>::OVERWRITE ));
 
@@ -0,0 +1,146 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include "FeatureLatticeBitPacked.h"
+#include "FeatureLatticeSparse.h"
+#include "FeatureSlitConfinement.h"
+#include "ForceTrajectoryEvaluator.h"
+#include "BfmTrajectory.h"
+
+// read in command line options
+#include <boost/program_options.hpp>
+using namespace boost::program_options;
+
+//! true if filename ends with extension
+bool hasExtension(const std::string& filename, const std::string& extension)
+{
+  return filename.size() >= extension.size() && filename.compare(filename.size()-extension.size(), extension.size(), extension) == 0;
+}
+
+//! evaluate the frames of trajectory and write the merged force to ofilename
+template<class IngredientsType, class TrajectoryType>
+void evaluate(const TrajectoryType& trajectory, std::vector<uint32_t> selectedMonomers, const std::string& ifilename, const std::string& ofilename,
+              uint64_t first, uint64_t every, uint64_t beginCalculation, uint32_t nThreads, uint32_t framesPerChunk, const AnalyzerForceOptions& forceOptions)
+{
+  if(selectedMonomers.empty()){
+    for(uint32_t i=0; i<trajectory.getStructure().nMonomers; i++){
+      selectedMonomers.push_back(i);
+    }
+  }
+
+  ForceTrajectoryEvaluator<IngredientsType,TrajectoryType> evaluator(trajectory,selectedMonomers,framesPerChunk);
+  evaluator.setFilename(ofilename);
+  evaluator.setForceOptions(forceOptions);
+  evaluator.run(nThreads,first,every,beginCalculation);
+  evaluator.getMergedForce().writeResults();
+
+  std::cout << "evaluated " << evaluator.getNumberOfEvaluatedFrames() << " of " << trajectory.getNumberOfFrames() << " frames of " << ifilename << ", results in " << ofilename << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  /* read arguments
+  * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  */
+  std::string ifilename, ofilename;
+  std::vector<uint32_t> selectedMonomers;
+  uint64_t first, every, beginCalculation;
+  uint32_t nThreads, framesPerChunk;
+  AnalyzerForceOptions forceOptions;
+
+  try{
+    options_description desc{"Measure the force of selected monomers on every frame of a binary trajectory (.btr) or bfm file of SimualtorChainInSlitForce\nthe binary trajectory is written by SimualtorChainInSlitForce --binary\nAllowed options"};
+    desc.add_options()
+      ("help,h", "produce help message")
+      ("ifilename,i", value<std::string>(&ifilename)->default_value("configRun.btr"), "input binary trajectory, or bfm file (.bfm) read frame by frame through its index")
+      ("ofilename,o", value<std::string>(&ofilename)->default_value("force.dat"), "output file of the force")
+      ("selection,v", value<vector<uint32_t> >(&selectedMonomers)->multitoken(), "vector of monomers to measure force {a,b,...}, all monomers if empty")
+      ("first,f", value<uint64_t>(&first)->default_value(0), "index of the first evaluated frame")
+      ("every,e", value<uint64_t>(&every)->default_value(1), "evaluate every n-th frame only")
+      ("relax,r", value<uint64_t>(&beginCalculation)->default_value(0), "mcs of the first frame which is probed")
+      ("xyz", bool_switch(&forceOptions.allAxes), "probe the jumps in x and y as well and write the force along all three axes")
+      ("profile", bool_switch(&forceOptions.profile), "bin the jumps by z layer and distance to the walls and write the force profile to <ofilename>_profile.dat")
+      ("threads,j", value<uint32_t>(&nThreads)->default_value(0), "number of threads, 0 uses all cores")
+      ("chunk,c", value<uint32_t>(&framesPerChunk)->default_value(64), "number of consecutive frames evaluated by one task, the result does not depend on it");
+
+    variables_map options_map;
+    store(parse_command_line(argc, argv, desc), options_map);
+    notify(options_map);
+
+    // help option
+    if (options_map.count("help")) {
+      std::cout << desc << "\n";
+      return 1;
+    }
+  } catch (const error &ex){
+    std::cerr << ex.what() << '\n';
+  }
+
+  /* initialize system
+  * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  */
+
+  // dense lattice for slits, hashed lattice for single chains in huge boxes (TANGLOTRON_SPARSE_LATTICE)
+#ifdef TANGLOTRON_SPARSE_LATTICE
+  typedef FeatureLatticeSparse<bool> LatticeType;
+#else
+  typedef FeatureLatticeBitPacked LatticeType;
+#endif
+  typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< LatticeType >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+  const uint max_bonds=4;
+  typedef ConfigureSystem<VectorInt3,Features,max_bonds> Config;
+  typedef Ingredients<Config> IngredientsType;
+
+  // the frames of bfm files are parsed into a system without lattice
+  typedef LOKI_TYPELIST_4(FeatureMoleculesIO, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) ReadFeatures;
+  typedef ConfigureSystem<VectorInt3,ReadFeatures,max_bonds> ReadConfig;
+  typedef Ingredients<ReadConfig> ReadIngredientsType;
+
+  /* evaluate the trajectory
+  * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+  */
+  try{
+    if(hasExtension(ifilename,".bfm")){
+      BfmTrajectory<ReadIngredientsType> trajectory(ifilename);
+      evaluate<IngredientsType>(trajectory,selectedMonomers,ifilename,ofilename,first,every,beginCalculation,nThreads,framesPerChunk,forceOptions);
+    }else{
+      MappedBinaryTrajectory trajectory(ifilename);
+      evaluate<IngredientsType>(trajectory,selectedMonomers,ifilename,ofilename,first,every,beginCalculation,nThreads,framesPerChunk,forceOptions);
+    }
+
+  }catch(std::exception& err){
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
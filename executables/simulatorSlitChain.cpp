@@ -29,17 +29,28 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 #include <LeMonADE/feature/FeatureMoleculesIO.h>
 #include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
 #include <LeMonADE/feature/FeatureAttributes.h>
-#include <LeMonADE/feature/FeatureWall.h>
 #include <LeMonADE/feature/FeatureFixedMonomers.h>
 
 #include <LeMonADE/utility/RandomNumberGenerators.h>
 #include <LeMonADE/utility/TaskManager.h>
 
-#include <LeMonADE/updater/UpdaterSimpleSimulator.h>
-#include <LeMonADE/updater/UpdaterReadBfmFile.h>
 #include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
 
+#include "FeatureLatticeBitPacked.h"
+#include "FeatureLatticeSparse.h"
+#include "FeatureLatticeTiled.h"
+#include "FeatureSlitConfinement.h"
+#include "AnalyzerCorrelation.h"
 #include "AnalyzerForce.h"
+#include "AnalyzerWriteBfmFileAsync.h"
+#include "AnalyzerWriteBinaryTrajectory.h"
+#include "UpdaterReadBfmFileIndexed.h"
+#include "UpdaterSimulatorForceSampling.h"
+#include "UpdaterForceConvergence.h"
+#include "UpdaterCheckpoint.h"
+#include "ReplicaRunner.h"
+
+#include <csignal>
 
 // read in command line options
 #include <boost/program_options.hpp>
@@ -50,9 +61,13 @@ int main(int argc, char* argv[])
   /* read arguments
   * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ 
   */
-  std::string ifilename,ofilename;
-  int32_t max_mcs, save_interval, force_interval, relaxtime;
+  std::string ifilename,ofilename,checkpointFilename;
+  int32_t max_mcs, save_interval, force_interval, correlation_interval, relaxtime, flush_interval, checkpoint_interval, nReplicas, nThreads;
+  double target_error, wall_time;
+  uint64_t seed;
   std::vector<uint32_t> selectedMonomers;
+  bool piggyback(false), binaryTrajectory(false), allMonomers(false), correlation(false);
+  AnalyzerForceOptions forceOptions;
 
   try{
     options_description desc{"Set up all paramters for SimulatorSlitChain with force measurement\nnummcs, nforce and nsave are requested to give useful values when dividing by each other\nAllowed options"};
@@ -64,7 +79,22 @@ int main(int argc, char* argv[])
       ("numsave,s", value<int32_t>(&save_interval)->default_value(1000), "mcs intervall to save the current config")
       ("nforce,f", value<int32_t>(&force_interval)->default_value(10), "mcs intervall to analyzer force")
       ("selection,v", value<vector<uint32_t> >(&selectedMonomers)->multitoken(), "vector of monomers to measure force {a,b,...}")
-      ("relax,r", value<int32_t>(&relaxtime)->default_value(10), "num mcs before starting force calculation");
+      ("all,a", bool_switch(&allMonomers), "measure the force of every monomer, e.g. for the tension profile along the chain, instead of the selection")
+      ("xyz", bool_switch(&forceOptions.allAxes), "probe the jumps in x and y as well and write the force along all three axes")
+      ("profile", bool_switch(&forceOptions.profile), "bin the jumps by z layer and distance to the walls and write the force profile to force_profile.dat")
+      ("correlation", bool_switch(&correlation), "write the autocorrelation functions and times of end-to-end vector, radius of gyration and height of the selected monomers to _correlation.dat, sampled every ncorrelation mcs")
+      ("ncorrelation", value<int32_t>(&correlation_interval)->default_value(1), "mcs intervall to sample the correlation functions, a divisor of nforce and numsave")
+      ("relax,r", value<int32_t>(&relaxtime)->default_value(10), "age in mcs at which the force calculation starts")
+      ("piggyback,p", bool_switch(&piggyback), "additionally sample the force from all z moves of the selected monomers attempted in the simulator")
+      ("flush,w", value<int32_t>(&flush_interval)->default_value(1000), "mcs intervall to write the force results during the run, 0 writes them at the end only")
+      ("error,e", value<double>(&target_error)->default_value(0.0), "stop once the error of log(n-/n+) is below this value for all selected monomers, 0 runs nummcs")
+      ("walltime,t", value<double>(&wall_time)->default_value(0.0), "stop after this wall-clock time in seconds, 0 runs nummcs")
+      ("checkpoint,c", value<std::string>(&checkpointFilename)->default_value(""), "binary checkpoint file to resume from and to write to, empty for no checkpoints")
+      ("ncheckpoint", value<int32_t>(&checkpoint_interval)->default_value(100000), "mcs intervall to write the checkpoint, a multiple of numsave and nforce, it is also written at the end and on SIGTERM")
+      ("replicas,R", value<int32_t>(&nReplicas)->default_value(1), "number of independent replicas of the input system simulated in this process")
+      ("threads,j", value<int32_t>(&nThreads)->default_value(0), "number of threads for the replicas, 0 uses all cores")
+      ("seed", value<uint64_t>(&seed)->default_value(0), "master seed of the random number streams of the simulation, 0 draws a seed")
+      ("binary,b", bool_switch(&binaryTrajectory), "write the trajectory as compact binary trajectory (.btr) instead of bfm, the last config is still written as bfm");
       
     variables_map options_map;
     store(parse_command_line(argc, argv, desc), options_map);
@@ -83,6 +113,12 @@ int main(int argc, char* argv[])
       auto& value = it.second.value();
       if (auto v = boost::any_cast<int32_t>(&value)){
 	    std::cout << *v << std::endl;
+      }else if (auto v = boost::any_cast<bool>(&value)){
+	    std::cout << *v << std::endl;
+      }else if (auto v = boost::any_cast<double>(&value)){
+	    std::cout << *v << std::endl;
+      }else if (auto v = boost::any_cast<uint64_t>(&value)){
+	    std::cout << *v << std::endl;
       }else if (auto v = boost::any_cast<std::string>(&value)){
 	    std::cout << *v << std::endl;
       }else if (auto v = boost::any_cast<std::vector<uint32_t> >(&value)){
@@ -104,7 +140,16 @@ int main(int argc, char* argv[])
   * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++   
   */
 
-  typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+  // dense lattice for slits, hashed lattice for single chains in huge boxes (TANGLOTRON_SPARSE_LATTICE),
+  // cache line tiles for dense multi chain slits (TANGLOTRON_TILED_LATTICE)
+#if defined(TANGLOTRON_SPARSE_LATTICE)
+  typedef FeatureLatticeSparse<bool> LatticeType;
+#elif defined(TANGLOTRON_TILED_LATTICE)
+  typedef FeatureLatticeTiled<uint8_t> LatticeType;
+#else
+  typedef FeatureLatticeBitPacked LatticeType;
+#endif
+  typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< LatticeType >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
   const uint max_bonds=4;
   // define maximal number of bonds
   typedef ConfigureSystem<VectorInt3,Features,max_bonds> Config;
@@ -118,37 +163,141 @@ int main(int argc, char* argv[])
   */
   RandomNumberGenerators rng;
   rng.seedAll();
+
+  // the simulation draws from Philox4x32 streams of the master seed
+  if(seed == 0){
+    seed=(uint64_t(rng.r250_rand32())<<32) | rng.r250_rand32();
+  }
+  std::cout << "master seed " << seed << std::endl;
   
   /* use TaskManager
   * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ 
   */
 
   try{
-    // prepare cycles
-    int simulatorCycles(0), simulatorInterval(0), writePeriod(0);
+    // prepare cycles, the simulator runs in steps of ncorrelation mcs if the correlation is sampled
+    int simulatorCycles(0), simulatorInterval(0), writePeriod(0), forcePeriod(0);
 
     if(save_interval > force_interval){
-        writePeriod=(save_interval/force_interval);
-        simulatorCycles=(max_mcs/force_interval);
-        simulatorInterval=force_interval;
+        simulatorInterval=(correlation ? correlation_interval : force_interval);
+        if(simulatorInterval <= 0 || force_interval % simulatorInterval != 0 || save_interval % simulatorInterval != 0){
+            throw std::runtime_error("ncorrelation is no divisor of nforce and numsave");
+        }
+        writePeriod=(save_interval/simulatorInterval);
+        forcePeriod=(force_interval/simulatorInterval);
+        simulatorCycles=(max_mcs/simulatorInterval);
     }else{
         throw std::runtime_error("force_intervall is smaller than save_interval");
     }
 
+    // the last frame is found by the sidecar index of the input file
+    UpdaterReadBfmFileIndexed<IngredientsType> reader(ifilename,ingredients,UpdaterReadBfmFileIndexed<IngredientsType>::READ_LAST_CONFIG);
+    reader.initialize();
+
+    if(allMonomers){
+      if(piggyback){
+        throw std::runtime_error("piggyback is only available with a selection of monomers");
+      }
+      selectedMonomers.resize(ingredients.getMolecules().size());
+      for(uint32_t i=0; i<selectedMonomers.size(); i++){
+        selectedMonomers[i]=i;
+      }
+    }
+
+    // replica mode: read the system once and simulate independent copies on all threads
+    if(nReplicas > 1){
+      if(!checkpointFilename.empty() || target_error > 0.0 || wall_time > 0.0 || piggyback || correlation){
+        throw std::runtime_error("checkpoint, error, walltime, piggyback and correlation are not available with replicas");
+      }
+
+      ofilename=(ofilename.substr(0,ofilename.find_last_of(".")));
+      ReplicaRunner<IngredientsType> replicas(ingredients,nReplicas,selectedMonomers,seed);
+      replicas.setReplicaFilenamePrefix(ofilename+"_force_r");
+      replicas.setForceOptions(forceOptions);
+      replicas.run(nThreads,simulatorCycles,simulatorInterval,relaxtime);
+
+      // merged force statistics of all replicas in force.dat
+      replicas.getMergedForce().writeResults();
+
+      for(uint32_t r=0; r<replicas.getNumberOfReplicas(); r++){
+        std::stringstream filename;
+        filename << ofilename << "_r" << r << "_lastconfig.bfm";
+        AnalyzerWriteBfmFile<IngredientsType> lastConfig(filename.str(),replicas.getReplicaIngredients(r),AnalyzerWriteBfmFile<IngredientsType>::OVERWRITE);
+        lastConfig.initialize();
+        lastConfig.execute();
+        lastConfig.cleanup();
+      }
+
+      return 0;
+    }
+
     TaskManager taskmanager;
-    taskmanager.addUpdater(new UpdaterReadBfmFile<IngredientsType>(ifilename,ingredients,UpdaterReadBfmFile<IngredientsType>::READ_LAST_CONFIG_SAVE),0);
-    taskmanager.addUpdater(new UpdaterSimpleSimulator<IngredientsType,MoveLocalSc>(ingredients,simulatorInterval));
 
-    taskmanager.addAnalyzer(new AnalyzerForce<IngredientsType>(ingredients,selectedMonomers,relaxtime/force_interval));
+    // the simulator samples the z moves of the selected monomers only with piggyback
+    UpdaterSimulatorForceSampling<IngredientsType>* simulator(new UpdaterSimulatorForceSampling<IngredientsType>(ingredients,simulatorInterval,(piggyback ? selectedMonomers : std::vector<uint32_t>())));
+    simulator->setSeed(seed);
+
+    AnalyzerForce<IngredientsType>* analyzerForce(new AnalyzerForce<IngredientsType>(ingredients,selectedMonomers,relaxtime));
+    analyzerForce->setFlushInterval(flush_interval/force_interval);
+    analyzerForce->setOptions(forceOptions);
 
     ofilename=(ofilename.substr(0,ofilename.find_last_of(".")));
-    taskmanager.addAnalyzer(new AnalyzerWriteBfmFile<IngredientsType>(ofilename+".bfm",ingredients,AnalyzerWriteBfmFile<IngredientsType>::APPEND ),writePeriod);
-    taskmanager.addAnalyzer(new AnalyzerWriteBfmFile<IngredientsType>(ofilename+"_lastconfig.bfm",ingredients,AnalyzerWriteBfmFile<IngredientsType>::OVERWRITE ),writePeriod);
+    const std::string trajectoryFilename(ofilename+(binaryTrajectory ? ".btr" : ".bfm"));
+
+    // the checkpoint is restored behind the bfm file and in front of the simulator,
+    // it is only taken on cycles where the writer and the force analyzer are in phase
+    if(!checkpointFilename.empty()){
+      if(correlation){
+        throw std::runtime_error("the correlation functions are not part of the checkpoint, correlation is not available with checkpoint");
+      }
+      int phasePeriod(writePeriod);
+      while(phasePeriod % forcePeriod != 0){
+        phasePeriod+=writePeriod;
+      }
+      if(checkpoint_interval <= 0 || checkpoint_interval % (phasePeriod*simulatorInterval) != 0){
+        throw std::runtime_error("ncheckpoint has to be a multiple of numsave and nforce");
+      }
+      UpdaterCheckpoint<IngredientsType>* checkpoint(new UpdaterCheckpoint<IngredientsType>(ingredients,checkpointFilename,checkpoint_interval/simulatorInterval,simulatorCycles*simulatorInterval,phasePeriod));
+      checkpoint->addComponent(simulator);
+      checkpoint->addComponent(analyzerForce);
+      checkpoint->addTrajectory(trajectoryFilename);
+      taskmanager.addUpdater(checkpoint);
+      std::signal(SIGTERM,checkpointSignalHandler);
+    }
+
+    taskmanager.addUpdater(simulator);
+    taskmanager.addAnalyzer(analyzerForce,forcePeriod);
+
+    // stop early if the force is converged or the wall time is used up
+    if(target_error > 0.0 || wall_time > 0.0){
+      taskmanager.addUpdater(new UpdaterForceConvergence<IngredientsType>(*analyzerForce,target_error,wall_time),forcePeriod);
+    }
+
+    // formatting and writing of the configurations run in background threads
+    if(binaryTrajectory){
+      taskmanager.addAnalyzer(new AnalyzerWriteBinaryTrajectory<IngredientsType>(trajectoryFilename,ingredients,AnalyzerWriteBinaryTrajectory<IngredientsType>::APPEND ),writePeriod);
+    }else{
+      taskmanager.addAnalyzer(new AnalyzerWriteBfmFileAsync<IngredientsType>(trajectoryFilename,ingredients,AnalyzerWriteBfmFileAsync<IngredientsType>::APPEND ),writePeriod);
+    }
+    taskmanager.addAnalyzer(new AnalyzerWriteBfmFileAsync<IngredientsType>(ofilename+"_lastconfig.bfm",ingredients,AnalyzerWriteBfmFileAsync<IngredientsType>::OVERWRITE ),writePeriod);
+
+    // correlation times of the conformation from the start, to choose relax and nforce
+    if(correlation){
+      taskmanager.addAnalyzer(new AnalyzerCorrelation<IngredientsType>(ingredients,selectedMonomers,0,ofilename+"_correlation.dat"));
+    }
 
     taskmanager.initialize();
     taskmanager.run(simulatorCycles);
+
+    // cleanup() writes all queued configurations
     taskmanager.cleanup();
 
+    // the last config is only written every writePeriod, so write it again for early stops
+    AnalyzerWriteBfmFile<IngredientsType> lastConfig(ofilename+"_lastconfig.bfm",ingredients,AnalyzerWriteBfmFile<IngredientsType>::OVERWRITE);
+    lastConfig.initialize();
+    lastConfig.execute();
+    lastConfig.cleanup();
+
   }catch(std::exception& err){
     std::cerr<<err.what();
   }
@@ -0,0 +1,262 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef FEATURE_LATTICE_BIT_PACKED_H
+#define FEATURE_LATTICE_BIT_PACKED_H
+/**
+* @file
+*
+* @class FeatureLatticeBitPacked
+*
+* @brief Occupancy lattice storing one bit per site in 64 bit words.
+*
+* @details Drop-in replacement for FeatureLatticeSlit<bool>, e.g. as lattice of
+* FeatureExcludedVolumeSc< FeatureLatticeBitPacked >. The extents and the folding are
+* the same: x and y are powers of two folded with bit masks, z has any extent and is
+* folded only in a periodic box. A non-periodic z reads as empty outside of [0,boxZ).
+*
+* The bits of one (x,y) column along z are stored in ceil(boxZ/64) consecutive words,
+* so a lattice of 512x512x64 needs 2MB instead of 16MB. The face of a monomer cube
+* perpendicular to x or y lies in two columns and two neighboring z bits, which are
+* read with one word and a mask per column. The face perpendicular to z is one bit in
+* four columns. isFaceFree() does these checks directly and is used by the force probe
+* (see ForceProbeKernel), FeatureExcludedVolumeSc uses the generic site access.
+**/
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <LeMonADE/feature/Feature.h>
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "LatticeFolding.h"
+
+
+class FeatureLatticeBitPacked : public Feature
+{
+public:
+
+    FeatureLatticeBitPacked();
+    virtual ~FeatureLatticeBitPacked(){}
+
+    //! set up the lattice if the box of ingredients changed
+    template<class IngredientsType>
+    void synchronize(IngredientsType& ingredients);
+
+    //! allocate an empty lattice of size boxX_*boxY_*boxZ_
+    void setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_);
+
+    //! lattice entry at pos
+    bool getLatticeEntry(const VectorInt3& pos) const { return getLatticeEntry(pos.getX(),pos.getY(),pos.getZ()); }
+
+    //! lattice entry at (x,y,z)
+    bool getLatticeEntry(int32_t x, int32_t y, int32_t z) const;
+
+    //! set the lattice entry at pos
+    void setLatticeEntry(const VectorInt3& pos, bool value);
+
+    //! move the entry at oldPos to newPos and clear oldPos
+    void moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos);
+
+    //! set all entries to false
+    void clearLattice(){ std::fill(lattice.begin(),lattice.end(),uint64_t(0)); }
+
+    //! check if the four sites in front of the monomer cube at pos in direction dir are free
+    bool isFaceFree(const VectorInt3& pos, const VectorInt3& dir) const;
+
+    //! number of allocated 64 bit words
+    size_t getNumberOfWords() const { return lattice.size(); }
+
+private:
+
+    //! index of the first word of the column at (x,y)
+    size_t column(int32_t x, int32_t y) const
+    {
+        return ( size_t(x & maskX) | (size_t(y & maskY) << shiftY) ) * wordsPerColumn;
+    }
+
+    //! bit at folded z coordinate zFolded in the column starting at word col
+    bool getBit(size_t col, uint32_t zFolded) const
+    {
+        return (lattice[col+(zFolded >> 6)] >> (zFolded & 63)) & 1;
+    }
+
+    //! true if the site at (x,y,z) is occupied, z unfolded
+    bool isOccupied(size_t col, int32_t z) const
+    {
+        const uint32_t zFolded(foldZ(z,boxZ,periodicZ));
+        return (zFolded != boxZ) && getBit(col,zFolded);
+    }
+
+    //! columns of sites along z, each wordsPerColumn words long
+    std::vector<uint64_t> lattice;
+
+    uint32_t boxX;
+    uint32_t boxY;
+    uint32_t boxZ;
+
+    //! true if z is folded periodically
+    bool periodicZ;
+
+    //! bit masks folding x and y
+    int32_t maskX;
+    int32_t maskY;
+
+    //! bit shift of y in the column index
+    uint32_t shiftY;
+
+    //! number of 64 bit words per column
+    uint32_t wordsPerColumn;
+};
+
+
+inline FeatureLatticeBitPacked::FeatureLatticeBitPacked()
+:boxX(0), boxY(0), boxZ(0), periodicZ(false), maskX(0), maskY(0), shiftY(0), wordsPerColumn(0)
+{}
+
+/**
+* @details Reallocates as FeatureLatticeSlit::synchronize.
+*
+* @param ingredients system providing the box
+*/
+template<class IngredientsType>
+void FeatureLatticeBitPacked::synchronize(IngredientsType& ingredients)
+{
+    if( ingredients.getBoxX()!=boxX || ingredients.getBoxY()!=boxY ||
+        ingredients.getBoxZ()!=boxZ || ingredients.isPeriodicZ()!=periodicZ ){
+        setupLattice(ingredients.getBoxX(), ingredients.getBoxY(), ingredients.getBoxZ(), ingredients.isPeriodicZ());
+    }
+}
+
+/**
+* @param boxX_ box size in x, power of two
+* @param boxY_ box size in y, power of two
+* @param boxZ_ box size in z, any positive number
+* @param periodicZ_ periodicity of the box in z
+*/
+inline void FeatureLatticeBitPacked::setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_)
+{
+    if( boxX_==0 || (boxX_ & (boxX_-1))!=0 || boxY_==0 || (boxY_ & (boxY_-1))!=0 ){
+        throw std::runtime_error("FeatureLatticeBitPacked: box sizes in x and y have to be powers of two");
+    }
+    if(boxZ_==0){
+        throw std::runtime_error("FeatureLatticeBitPacked: box size in z has to be positive");
+    }
+
+    boxX=boxX_;
+    boxY=boxY_;
+    boxZ=boxZ_;
+    periodicZ=periodicZ_;
+
+    maskX=int32_t(boxX-1);
+    maskY=int32_t(boxY-1);
+
+    shiftY=0;
+    while((1u << shiftY) < boxX) shiftY++;
+
+    wordsPerColumn=(boxZ+63)/64;
+
+    lattice.assign(size_t(boxX)*size_t(boxY)*wordsPerColumn, uint64_t(0));
+}
+
+inline bool FeatureLatticeBitPacked::getLatticeEntry(int32_t x, int32_t y, int32_t z) const
+{
+    return isOccupied(column(x,y),z);
+}
+
+inline void FeatureLatticeBitPacked::setLatticeEntry(const VectorInt3& pos, bool value)
+{
+    const uint32_t zFolded(foldZ(pos.getZ(),boxZ,periodicZ));
+    if(zFolded==boxZ){
+        throw std::runtime_error("FeatureLatticeBitPacked: lattice site outside of the non-periodic box in z");
+    }
+    uint64_t& word(lattice[column(pos.getX(),pos.getY())+(zFolded >> 6)]);
+    const uint64_t bit(uint64_t(1) << (zFolded & 63));
+    if(value){
+        word|=bit;
+    }else{
+        word&=~bit;
+    }
+}
+
+inline void FeatureLatticeBitPacked::moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos)
+{
+    const bool value(getLatticeEntry(oldPos));
+    setLatticeEntry(oldPos, false);
+    setLatticeEntry(newPos, value);
+}
+
+/**
+* @details The monomer occupies the cube [pos,pos+(1,1,1)]. For a jump in positive
+* direction the sites at pos+2*dir are checked, in negative direction at pos+dir.
+* Faces crossing the boundary of a non-periodic box count the sites outside as free,
+* those crossing a word boundary or the periodic boundary in z are read bit by bit.
+*
+* @param pos lower left corner of the monomer cube
+* @param dir direction of the jump, one of the six unit vectors
+* @return true if all four sites of the face are empty
+*/
+inline bool FeatureLatticeBitPacked::isFaceFree(const VectorInt3& pos, const VectorInt3& dir) const
+{
+    const int32_t x(pos.getX());
+    const int32_t y(pos.getY());
+    const int32_t z(pos.getZ());
+
+    if(dir.getZ()!=0){
+        const uint32_t zFolded(foldZ( z + ((dir.getZ() > 0) ? 2 : -1), boxZ, periodicZ ));
+        if(zFolded==boxZ){
+            return true;
+        }
+        const size_t offset(zFolded >> 6);
+        const uint64_t columns( lattice[column(x,y)+offset] | lattice[column(x+1,y)+offset] |
+                                lattice[column(x,y+1)+offset] | lattice[column(x+1,y+1)+offset] );
+        return ((columns >> (zFolded & 63)) & 1)==0;
+    }
+
+    size_t col1, col2;
+    if(dir.getX()!=0){
+        const int32_t xFace( x + ((dir.getX() > 0) ? 2 : -1) );
+        col1=column(xFace,y);
+        col2=column(xFace,y+1);
+    }else{
+        const int32_t yFace( y + ((dir.getY() > 0) ? 2 : -1) );
+        col1=column(x,yFace);
+        col2=column(x+1,yFace);
+    }
+
+    // both z sites in the same word: one mask per column
+    if(uint32_t(z) < boxZ-1 && (z & 63)!=63){
+        const size_t offset(uint32_t(z) >> 6);
+        const uint64_t mask(uint64_t(3) << (z & 63));
+        return ((lattice[col1+offset] | lattice[col2+offset]) & mask)==0;
+    }
+
+    return !( isOccupied(col1,z) || isOccupied(col1,z+1) || isOccupied(col2,z) || isOccupied(col2,z+1) );
+}
+
+#endif //FEATURE_LATTICE_BIT_PACKED_H
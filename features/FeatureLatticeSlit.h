@@ -0,0 +1,203 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef FEATURE_LATTICE_SLIT_H
+#define FEATURE_LATTICE_SLIT_H
+/**
+* @file
+*
+* @class FeatureLatticeSlit
+*
+* @brief Lattice for slit systems with power of two extents in x and y and an
+* arbitrary extent in z.
+*
+* @details Drop-in replacement for FeatureLatticePowerOfTwo, e.g. as lattice of
+* FeatureExcludedVolumeSc< FeatureLatticeSlit<bool> >. The x and y coordinates are
+* folded with bit masks as in FeatureLatticePowerOfTwo. The z extent is the box size
+* in z without rounding up to the next power of two, so a slit of 17 allocates 17
+* planes instead of 32:
+* - non-periodic z: coordinates are used without folding, sites outside of [0,boxZ)
+*   read as empty and can not be set
+* - periodic z: coordinates are folded into [0,boxZ) by a modulo operation
+*
+* @tparam ValueType type of the lattice entries
+**/
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <LeMonADE/feature/Feature.h>
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "LatticeFolding.h"
+
+
+template<class ValueType=bool>
+class FeatureLatticeSlit : public Feature
+{
+public:
+
+    FeatureLatticeSlit();
+    virtual ~FeatureLatticeSlit(){}
+
+    //! set up the lattice if the box of ingredients changed
+    template<class IngredientsType>
+    void synchronize(IngredientsType& ingredients);
+
+    //! allocate an empty lattice of size boxX_*boxY_*boxZ_
+    void setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_);
+
+    //! lattice entry at pos
+    ValueType getLatticeEntry(const VectorInt3& pos) const { return getLatticeEntry(pos.getX(),pos.getY(),pos.getZ()); }
+
+    //! lattice entry at (x,y,z)
+    ValueType getLatticeEntry(int32_t x, int32_t y, int32_t z) const;
+
+    //! set the lattice entry at pos
+    void setLatticeEntry(const VectorInt3& pos, ValueType value);
+
+    //! move the entry at oldPos to newPos and clear oldPos
+    void moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos);
+
+    //! set all entries to ValueType()
+    void clearLattice(){ std::fill(lattice.begin(),lattice.end(),ValueType()); }
+
+    //! number of allocated lattice sites
+    size_t getLatticeSize() const { return lattice.size(); }
+
+private:
+
+    //! index of the lattice site with folded z coordinate zFolded
+    size_t index(int32_t x, int32_t y, uint32_t zFolded) const
+    {
+        return size_t(x & maskX) | (size_t(y & maskY) << shiftY) | (size_t(zFolded) << shiftZ);
+    }
+
+    //! lattice entries, x runs fastest
+    std::vector<ValueType> lattice;
+
+    uint32_t boxX;
+    uint32_t boxY;
+    uint32_t boxZ;
+
+    //! true if z is folded periodically
+    bool periodicZ;
+
+    //! bit masks folding x and y
+    int32_t maskX;
+    int32_t maskY;
+
+    //! bit shifts of y and z in the index
+    uint32_t shiftY;
+    uint32_t shiftZ;
+};
+
+
+template<class ValueType>
+FeatureLatticeSlit<ValueType>::FeatureLatticeSlit()
+:boxX(0), boxY(0), boxZ(0), periodicZ(false), maskX(0), maskY(0), shiftY(0), shiftZ(0)
+{}
+
+/**
+* @details The lattice is only allocated again if the box or the periodicity in z
+* changed, the entries are not cleared here. Features using the lattice fill it in
+* their own synchronize.
+*
+* @param ingredients system providing the box
+*/
+template<class ValueType>
+template<class IngredientsType>
+void FeatureLatticeSlit<ValueType>::synchronize(IngredientsType& ingredients)
+{
+    if( ingredients.getBoxX()!=boxX || ingredients.getBoxY()!=boxY ||
+        ingredients.getBoxZ()!=boxZ || ingredients.isPeriodicZ()!=periodicZ ){
+        setupLattice(ingredients.getBoxX(), ingredients.getBoxY(), ingredients.getBoxZ(), ingredients.isPeriodicZ());
+    }
+}
+
+/**
+* @param boxX_ box size in x, power of two
+* @param boxY_ box size in y, power of two
+* @param boxZ_ box size in z, any positive number
+* @param periodicZ_ periodicity of the box in z
+*/
+template<class ValueType>
+void FeatureLatticeSlit<ValueType>::setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_)
+{
+    if( boxX_==0 || (boxX_ & (boxX_-1))!=0 || boxY_==0 || (boxY_ & (boxY_-1))!=0 ){
+        throw std::runtime_error("FeatureLatticeSlit: box sizes in x and y have to be powers of two");
+    }
+    if(boxZ_==0){
+        throw std::runtime_error("FeatureLatticeSlit: box size in z has to be positive");
+    }
+
+    boxX=boxX_;
+    boxY=boxY_;
+    boxZ=boxZ_;
+    periodicZ=periodicZ_;
+
+    maskX=int32_t(boxX-1);
+    maskY=int32_t(boxY-1);
+
+    shiftY=0;
+    while((1u << shiftY) < boxX) shiftY++;
+    shiftZ=shiftY;
+    while((1u << (shiftZ-shiftY)) < boxY) shiftZ++;
+
+    lattice.assign(size_t(boxX)*size_t(boxY)*size_t(boxZ), ValueType());
+}
+
+template<class ValueType>
+inline ValueType FeatureLatticeSlit<ValueType>::getLatticeEntry(int32_t x, int32_t y, int32_t z) const
+{
+    const uint32_t zFolded(foldZ(z,boxZ,periodicZ));
+    if(zFolded==boxZ){
+        return ValueType();
+    }
+    return lattice[index(x,y,zFolded)];
+}
+
+template<class ValueType>
+inline void FeatureLatticeSlit<ValueType>::setLatticeEntry(const VectorInt3& pos, ValueType value)
+{
+    const uint32_t zFolded(foldZ(pos.getZ(),boxZ,periodicZ));
+    if(zFolded==boxZ){
+        throw std::runtime_error("FeatureLatticeSlit: lattice site outside of the non-periodic box in z");
+    }
+    lattice[index(pos.getX(),pos.getY(),zFolded)]=value;
+}
+
+template<class ValueType>
+inline void FeatureLatticeSlit<ValueType>::moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos)
+{
+    const ValueType value(getLatticeEntry(oldPos));
+    setLatticeEntry(oldPos, ValueType());
+    setLatticeEntry(newPos, value);
+}
+
+#endif //FEATURE_LATTICE_SLIT_H
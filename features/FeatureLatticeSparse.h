@@ -0,0 +1,321 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef FEATURE_LATTICE_SPARSE_H
+#define FEATURE_LATTICE_SPARSE_H
+/**
+* @file
+*
+* @class FeatureLatticeSparse
+*
+* @brief Lattice storing only the occupied sites in an open-addressing hash table.
+*
+* @details Drop-in replacement for the dense lattices, e.g. as lattice of
+* FeatureExcludedVolumeSc< FeatureLatticeSparse<bool> >, for single chains in boxes so
+* large that a dense lattice would be almost empty. The memory scales with the number of
+* sites set to a value other than ValueType(), i.e. eight sites per monomer, and not with
+* the box volume.
+*
+* x and y are folded periodically into the box, z is folded only in a periodic box and
+* reads as empty outside of [0,boxZ) otherwise, as in FeatureLatticeSlit. The box sizes
+* are arbitrary up to 2^21 in each direction.
+*
+* The table uses linear probing with a power of two capacity and a load factor of at
+* most one half. Entries are removed by shifting the following entries back, so there
+* are no tombstones and lookups of empty sites stop at the first empty slot.
+*
+* @tparam ValueType type of the lattice entries
+**/
+
+#include <stdexcept>
+#include <vector>
+
+#include <LeMonADE/feature/Feature.h>
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "LatticeFolding.h"
+
+
+template<class ValueType=bool>
+class FeatureLatticeSparse : public Feature
+{
+public:
+
+    FeatureLatticeSparse();
+    virtual ~FeatureLatticeSparse(){}
+
+    //! set up the lattice if the box of ingredients changed
+    template<class IngredientsType>
+    void synchronize(IngredientsType& ingredients);
+
+    //! set the box and remove all entries
+    void setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_);
+
+    //! lattice entry at pos
+    ValueType getLatticeEntry(const VectorInt3& pos) const { return getLatticeEntry(pos.getX(),pos.getY(),pos.getZ()); }
+
+    //! lattice entry at (x,y,z)
+    ValueType getLatticeEntry(int32_t x, int32_t y, int32_t z) const;
+
+    //! set the lattice entry at pos, ValueType() removes the site from the table
+    void setLatticeEntry(const VectorInt3& pos, ValueType value);
+
+    //! move the entry at oldPos to newPos and clear oldPos
+    void moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos);
+
+    //! remove all entries, the capacity of the table is kept
+    void clearLattice();
+
+    //! number of stored sites
+    size_t getNumberOfEntries() const { return nEntries; }
+
+    //! number of slots of the hash table
+    size_t getCapacity() const { return slots.size(); }
+
+private:
+
+    //! slot of the hash table, key emptyKey marks a free slot
+    struct Slot
+    {
+        uint64_t key;
+        ValueType value;
+    };
+
+    //! key of free slots, no folded position maps onto it
+    static uint64_t emptyKey() { return ~uint64_t(0); }
+
+    //! key of the site at (x,y,z), emptyKey() if z is outside of a non-periodic box
+    uint64_t makeKey(int32_t x, int32_t y, int32_t z) const;
+
+    //! home slot of key
+    size_t hashSlot(uint64_t key) const
+    {
+        return size_t((key*UINT64_C(0x9E3779B97F4A7C15)) >> hashShift);
+    }
+
+    //! slot holding key or the free slot where it would be inserted
+    size_t findSlot(uint64_t key) const;
+
+    //! remove the entry in slot and shift the following entries back
+    void eraseSlot(size_t slot);
+
+    //! allocate a table of newCapacity slots and insert all entries again
+    void rehash(size_t newCapacity);
+
+    //! hash table
+    std::vector<Slot> slots;
+
+    //! number of used slots
+    size_t nEntries;
+
+    //! 64 minus log2 of the capacity
+    uint32_t hashShift;
+
+    uint32_t boxX;
+    uint32_t boxY;
+    uint32_t boxZ;
+
+    //! true if z is folded periodically
+    bool periodicZ;
+};
+
+
+template<class ValueType>
+FeatureLatticeSparse<ValueType>::FeatureLatticeSparse()
+:nEntries(0), hashShift(64), boxX(0), boxY(0), boxZ(0), periodicZ(false)
+{
+    rehash(64);
+}
+
+/**
+* @details The table is only cleared if the box or the periodicity in z changed.
+* Features using the lattice fill it in their own synchronize.
+*
+* @param ingredients system providing the box
+*/
+template<class ValueType>
+template<class IngredientsType>
+void FeatureLatticeSparse<ValueType>::synchronize(IngredientsType& ingredients)
+{
+    if( ingredients.getBoxX()!=boxX || ingredients.getBoxY()!=boxY ||
+        ingredients.getBoxZ()!=boxZ || ingredients.isPeriodicZ()!=periodicZ ){
+        setupLattice(ingredients.getBoxX(), ingredients.getBoxY(), ingredients.getBoxZ(), ingredients.isPeriodicZ());
+    }
+}
+
+/**
+* @param boxX_ box size in x
+* @param boxY_ box size in y
+* @param boxZ_ box size in z
+* @param periodicZ_ periodicity of the box in z
+*/
+template<class ValueType>
+void FeatureLatticeSparse<ValueType>::setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_)
+{
+    const uint32_t maxBox(uint32_t(1) << 21);
+    if( boxX_==0 || boxY_==0 || boxZ_==0 || boxX_>maxBox || boxY_>maxBox || boxZ_>maxBox ){
+        throw std::runtime_error("FeatureLatticeSparse: box sizes have to be in [1,2^21]");
+    }
+
+    boxX=boxX_;
+    boxY=boxY_;
+    boxZ=boxZ_;
+    periodicZ=periodicZ_;
+
+    clearLattice();
+}
+
+template<class ValueType>
+inline uint64_t FeatureLatticeSparse<ValueType>::makeKey(int32_t x, int32_t y, int32_t z) const
+{
+    const uint32_t zFolded(foldZ(z,boxZ,periodicZ));
+    if(zFolded==boxZ){
+        return emptyKey();
+    }
+    return uint64_t(foldPeriodic(x,boxX)) | (uint64_t(foldPeriodic(y,boxY)) << 21) | (uint64_t(zFolded) << 42);
+}
+
+template<class ValueType>
+inline size_t FeatureLatticeSparse<ValueType>::findSlot(uint64_t key) const
+{
+    const size_t mask(slots.size()-1);
+    size_t slot(hashSlot(key));
+    while(slots[slot].key!=key && slots[slot].key!=emptyKey()){
+        slot=(slot+1) & mask;
+    }
+    return slot;
+}
+
+template<class ValueType>
+inline ValueType FeatureLatticeSparse<ValueType>::getLatticeEntry(int32_t x, int32_t y, int32_t z) const
+{
+    const uint64_t key(makeKey(x,y,z));
+    if(key==emptyKey()){
+        return ValueType();
+    }
+    const Slot& slot(slots[findSlot(key)]);
+    return (slot.key==key) ? slot.value : ValueType();
+}
+
+template<class ValueType>
+void FeatureLatticeSparse<ValueType>::setLatticeEntry(const VectorInt3& pos, ValueType value)
+{
+    const uint64_t key(makeKey(pos.getX(),pos.getY(),pos.getZ()));
+    if(key==emptyKey()){
+        throw std::runtime_error("FeatureLatticeSparse: lattice site outside of the non-periodic box in z");
+    }
+
+    size_t slot(findSlot(key));
+    if(slots[slot].key==key){
+        if(value==ValueType()){
+            eraseSlot(slot);
+        }else{
+            slots[slot].value=value;
+        }
+        return;
+    }
+    if(value==ValueType()){
+        return;
+    }
+
+    if(2*(nEntries+1) > slots.size()){
+        rehash(2*slots.size());
+        slot=findSlot(key);
+    }
+    slots[slot].key=key;
+    slots[slot].value=value;
+    nEntries++;
+}
+
+template<class ValueType>
+void FeatureLatticeSparse<ValueType>::moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos)
+{
+    const ValueType value(getLatticeEntry(oldPos));
+    setLatticeEntry(oldPos, ValueType());
+    setLatticeEntry(newPos, value);
+}
+
+template<class ValueType>
+void FeatureLatticeSparse<ValueType>::clearLattice()
+{
+    for(size_t i=0; i<slots.size(); i++){
+        slots[i].key=emptyKey();
+        slots[i].value=ValueType();
+    }
+    nEntries=0;
+}
+
+/**
+* @details Backward shift deletion for linear probing: an entry behind the free slot is
+* moved into it unless its home slot lies cyclically between the free slot and itself.
+*/
+template<class ValueType>
+void FeatureLatticeSparse<ValueType>::eraseSlot(size_t slot)
+{
+    const size_t mask(slots.size()-1);
+    size_t hole(slot);
+    size_t next((hole+1) & mask);
+    while(slots[next].key!=emptyKey()){
+        const size_t home(hashSlot(slots[next].key));
+        // distance of next from its home slot compared to the distance from the hole
+        if( ((next-home) & mask) >= ((next-hole) & mask) ){
+            slots[hole]=slots[next];
+            hole=next;
+        }
+        next=(next+1) & mask;
+    }
+    slots[hole].key=emptyKey();
+    slots[hole].value=ValueType();
+    nEntries--;
+}
+
+/**
+* @param newCapacity number of slots, power of two
+*/
+template<class ValueType>
+void FeatureLatticeSparse<ValueType>::rehash(size_t newCapacity)
+{
+    std::vector<Slot> oldSlots(newCapacity);
+    oldSlots.swap(slots);
+    for(size_t i=0; i<slots.size(); i++){
+        slots[i].key=emptyKey();
+        slots[i].value=ValueType();
+    }
+
+    hashShift=64;
+    while((size_t(1) << (64-hashShift)) < newCapacity){
+        hashShift--;
+    }
+
+    for(size_t i=0; i<oldSlots.size(); i++){
+        if(oldSlots[i].key!=emptyKey()){
+            slots[findSlot(oldSlots[i].key)]=oldSlots[i];
+        }
+    }
+}
+
+#endif //FEATURE_LATTICE_SPARSE_H
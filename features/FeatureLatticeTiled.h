@@ -0,0 +1,224 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef FEATURE_LATTICE_TILED_H
+#define FEATURE_LATTICE_TILED_H
+/**
+* @file
+*
+* @class FeatureLatticeTiled
+*
+* @brief Lattice stored in tiles of 4x4x4 sites for cache locality.
+*
+* @details Drop-in replacement for FeatureLatticeSlit, e.g. as lattice of
+* FeatureExcludedVolumeSc< FeatureLatticeTiled<bool> >, with the same extents and
+* folding: x and y are powers of two (at least 4) folded with bit masks, z has any
+* extent and is folded only in a periodic box, a non-periodic z reads as empty outside
+* of [0,boxZ).
+*
+* In a row-major lattice the sites of a monomer cube and its faces lie in up to eight
+* lines which are boxX or boxX*boxY entries apart. Here the lattice is split into tiles
+* of 4x4x4 sites, the 64 sites of a tile are contiguous and the tiles are stored
+* row-major. For ValueType uint8_t a tile is one 64 byte cache line. For ValueType bool
+* std::vector<bool> packs the sites into bits, a tile takes 8 bytes and a cache line
+* holds a block of 16x4x4 sites. A cube with its faces touches one to eight
+* neighboring tiles, so random moves in dense systems hit far fewer cache lines. The
+* z extent is padded to a multiple of four. The executables select
+* FeatureLatticeTiled<uint8_t> with TANGLOTRON_TILED_LATTICE.
+*
+* Only the storage order of the lattice changes, the monomer indices and coordinates
+* seen by analyzers and by AnalyzerWriteBfmFile are untouched. The monomers are not
+* reordered by spatial locality: UpdaterSimulatorForceSampling draws every move for a
+* uniformly random monomer, so consecutive moves are spatially uncorrelated whatever
+* the storage order, also in dense multi chain slits. Sorting the monomers would only
+* help loops over all monomers in index order, which are a small part of the run time,
+* and it would have to renumber the selections, fixed monomers, checkpoints and bfm
+* output that refer to monomer indices.
+*
+* @tparam ValueType type of the lattice entries
+**/
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <LeMonADE/feature/Feature.h>
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "LatticeFolding.h"
+
+
+template<class ValueType=bool>
+class FeatureLatticeTiled : public Feature
+{
+public:
+
+    FeatureLatticeTiled();
+    virtual ~FeatureLatticeTiled(){}
+
+    //! set up the lattice if the box of ingredients changed
+    template<class IngredientsType>
+    void synchronize(IngredientsType& ingredients);
+
+    //! allocate an empty lattice for a box of boxX_*boxY_*boxZ_
+    void setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_);
+
+    //! lattice entry at pos
+    ValueType getLatticeEntry(const VectorInt3& pos) const { return getLatticeEntry(pos.getX(),pos.getY(),pos.getZ()); }
+
+    //! lattice entry at (x,y,z)
+    ValueType getLatticeEntry(int32_t x, int32_t y, int32_t z) const;
+
+    //! set the lattice entry at pos
+    void setLatticeEntry(const VectorInt3& pos, ValueType value);
+
+    //! move the entry at oldPos to newPos and clear oldPos
+    void moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos);
+
+    //! set all entries to ValueType()
+    void clearLattice(){ std::fill(lattice.begin(),lattice.end(),ValueType()); }
+
+    //! number of allocated lattice sites including the padding in z
+    size_t getLatticeSize() const { return lattice.size(); }
+
+    //! position of the site (x,y,z) in the storage, z inside of [0,boxZ)
+    size_t getStorageIndex(int32_t x, int32_t y, int32_t z) const { return index(x,y,uint32_t(z)); }
+
+private:
+
+    //! storage index of the site with folded z coordinate zFolded
+    size_t index(int32_t x, int32_t y, uint32_t zFolded) const
+    {
+        const uint32_t xm(uint32_t(x & maskX));
+        const uint32_t ym(uint32_t(y & maskY));
+        const size_t tile( size_t(xm >> 2) | (size_t(ym >> 2) << tileShiftY) | (size_t(zFolded >> 2) << tileShiftZ) );
+        return (tile << 6) | (xm & 3) | ((ym & 3) << 2) | ((zFolded & 3) << 4);
+    }
+
+    //! lattice entries, tile by tile
+    std::vector<ValueType> lattice;
+
+    uint32_t boxX;
+    uint32_t boxY;
+    uint32_t boxZ;
+
+    //! true if z is folded periodically
+    bool periodicZ;
+
+    //! bit masks folding x and y
+    int32_t maskX;
+    int32_t maskY;
+
+    //! bit shifts of the tile coordinates in y and z in the tile index
+    uint32_t tileShiftY;
+    uint32_t tileShiftZ;
+};
+
+
+template<class ValueType>
+FeatureLatticeTiled<ValueType>::FeatureLatticeTiled()
+:boxX(0), boxY(0), boxZ(0), periodicZ(false), maskX(0), maskY(0), tileShiftY(0), tileShiftZ(0)
+{}
+
+/**
+* @details Reallocates as FeatureLatticeSlit::synchronize.
+*
+* @param ingredients system providing the box
+*/
+template<class ValueType>
+template<class IngredientsType>
+void FeatureLatticeTiled<ValueType>::synchronize(IngredientsType& ingredients)
+{
+    if( ingredients.getBoxX()!=boxX || ingredients.getBoxY()!=boxY ||
+        ingredients.getBoxZ()!=boxZ || ingredients.isPeriodicZ()!=periodicZ ){
+        setupLattice(ingredients.getBoxX(), ingredients.getBoxY(), ingredients.getBoxZ(), ingredients.isPeriodicZ());
+    }
+}
+
+/**
+* @param boxX_ box size in x, power of two and at least 4
+* @param boxY_ box size in y, power of two and at least 4
+* @param boxZ_ box size in z, any positive number
+* @param periodicZ_ periodicity of the box in z
+*/
+template<class ValueType>
+void FeatureLatticeTiled<ValueType>::setupLattice(uint32_t boxX_, uint32_t boxY_, uint32_t boxZ_, bool periodicZ_)
+{
+    if( boxX_<4 || (boxX_ & (boxX_-1))!=0 || boxY_<4 || (boxY_ & (boxY_-1))!=0 ){
+        throw std::runtime_error("FeatureLatticeTiled: box sizes in x and y have to be powers of two of at least 4");
+    }
+    if(boxZ_==0){
+        throw std::runtime_error("FeatureLatticeTiled: box size in z has to be positive");
+    }
+
+    boxX=boxX_;
+    boxY=boxY_;
+    boxZ=boxZ_;
+    periodicZ=periodicZ_;
+
+    maskX=int32_t(boxX-1);
+    maskY=int32_t(boxY-1);
+
+    // tiles per line in x and per plane as powers of two
+    tileShiftY=0;
+    while((4u << tileShiftY) < boxX) tileShiftY++;
+    tileShiftZ=tileShiftY;
+    while((4u << (tileShiftZ-tileShiftY)) < boxY) tileShiftZ++;
+
+    const size_t tilesZ((boxZ+3)/4);
+    lattice.assign((tilesZ << tileShiftZ)*64, ValueType());
+}
+
+template<class ValueType>
+inline ValueType FeatureLatticeTiled<ValueType>::getLatticeEntry(int32_t x, int32_t y, int32_t z) const
+{
+    const uint32_t zFolded(foldZ(z,boxZ,periodicZ));
+    if(zFolded==boxZ){
+        return ValueType();
+    }
+    return lattice[index(x,y,zFolded)];
+}
+
+template<class ValueType>
+inline void FeatureLatticeTiled<ValueType>::setLatticeEntry(const VectorInt3& pos, ValueType value)
+{
+    const uint32_t zFolded(foldZ(pos.getZ(),boxZ,periodicZ));
+    if(zFolded==boxZ){
+        throw std::runtime_error("FeatureLatticeTiled: lattice site outside of the non-periodic box in z");
+    }
+    lattice[index(pos.getX(),pos.getY(),zFolded)]=value;
+}
+
+template<class ValueType>
+inline void FeatureLatticeTiled<ValueType>::moveOnLattice(const VectorInt3& oldPos, const VectorInt3& newPos)
+{
+    const ValueType value(getLatticeEntry(oldPos));
+    setLatticeEntry(oldPos, ValueType());
+    setLatticeEntry(newPos, value);
+}
+
+#endif //FEATURE_LATTICE_TILED_H
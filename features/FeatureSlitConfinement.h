@@ -0,0 +1,374 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef FEATURE_SLIT_CONFINEMENT_H
+#define FEATURE_SLIT_CONFINEMENT_H
+/**
+* @file
+*
+* @class FeatureSlitConfinement
+*
+* @brief Confinement of all monomers between two planes perpendicular to z.
+*
+* @details Replacement of FeatureWall for systems which are plain slits. Lattice sites
+* with lowerZ <= z < upperZ are accessible, so the lower left corner of a monomer cube
+* has to stay in [lowerZ,upperZ-2]. The check of a local move is a pair of integer
+* comparisons on the new z coordinate instead of a loop over a list of walls and the
+* eight sites of the cube.
+*
+* For compatibility with setups using FeatureWall the slit can also be given by walls
+* perpendicular to z through addWall(). The normal of a wall points out of the slit:
+* (0,0,1) is the upper and (0,0,-1) the lower bound. getWalls() returns the walls
+* equivalent to the slit.
+* Without any bound the feature accepts all moves.
+*
+* The slit is written to and read from bfm files with the command
+* !slit_confinement=lowerZ upperZ
+* Files written with FeatureWall store the slit as !add_wall command instead, followed by
+* one line with base and normal vector per wall. Such walls are read as well and mapped
+* onto the slit by addWall(), so existing files keep both bounds.
+**/
+
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/feature/Feature.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/updater/moves/MoveBase.h>
+#include <LeMonADE/updater/moves/MoveLocalSc.h>
+#include <LeMonADE/updater/moves/MoveAddMonomerSc.h>
+#include <LeMonADE/io/AbstractRead.h>
+#include <LeMonADE/io/AbstractWrite.h>
+#include <LeMonADE/utility/Vector3D.h>
+
+
+class FeatureSlitConfinement : public Feature
+{
+public:
+
+    FeatureSlitConfinement();
+    virtual ~FeatureSlitConfinement(){}
+
+    //! set the accessible planes to lowerZ <= z < upperZ
+    void setSlit(int32_t lowerZ_, int32_t upperZ_);
+
+    //! remove both bounds
+    void clearSlit();
+
+    //! add a bound given as wall with normal (0,0,1) or (0,0,-1)
+    void addWall(const Wall& wall);
+
+    //! remove both bounds (FeatureWall interface)
+    void clearAllWalls(){ clearSlit(); }
+
+    //! walls equivalent to the bounds of the slit
+    std::vector<Wall> getWalls() const;
+
+    //! lowest accessible plane
+    int32_t getLowerZ() const { return lowerZ; }
+
+    //! first inaccessible plane above the slit
+    int32_t getUpperZ() const { return upperZ; }
+
+    //! true if the slit is bounded from below
+    bool hasLowerBound() const { return lowerZ != std::numeric_limits<int32_t>::min(); }
+
+    //! true if the slit is bounded from above
+    bool hasUpperBound() const { return upperZ != std::numeric_limits<int32_t>::max(); }
+
+    //! check if a monomer cube with lower left corner at z fits into the slit
+    bool isInside(int32_t z) const { return (z >= cubeZMin) && (z <= cubeZMax); }
+
+    //! check for all unknown moves: always true
+    using Feature::checkMove;
+
+    //! check for a local move: the moved cube has to stay inside the slit
+    template<class IngredientsType>
+    bool checkMove(const IngredientsType& ingredients, const MoveLocalSc& move) const;
+
+    //! check for adding a monomer: the new cube has to be inside the slit
+    template<class IngredientsType, class TagType>
+    bool checkMove(const IngredientsType& ingredients, const MoveAddMonomerSc<TagType>& move) const;
+
+    //! export the read command for the slit to the file reader
+    template<class IngredientsType>
+    void exportRead(FileImport<IngredientsType>& fileReader);
+
+    //! export the write command for the slit to the file writer
+    template<class IngredientsType>
+    void exportWrite(AnalyzerWriteBfmFile<IngredientsType>& fileWriter) const;
+
+private:
+
+    //! lowest accessible plane
+    int32_t lowerZ;
+
+    //! first inaccessible plane above the slit
+    int32_t upperZ;
+
+    //! smallest allowed z of the lower left corner of a monomer cube
+    int32_t cubeZMin;
+
+    //! largest allowed z of the lower left corner of a monomer cube
+    int32_t cubeZMax;
+
+    //! derive the allowed range of cube corners from the accessible planes
+    void updateCubeRange();
+};
+
+
+/**
+* @class ReadSlitConfinement
+*
+* @brief Read the command !slit_confinement=lowerZ upperZ
+**/
+template<class IngredientsType>
+class ReadSlitConfinement : public ReadToDestination<IngredientsType>
+{
+public:
+    explicit ReadSlitConfinement(IngredientsType& destination):ReadToDestination<IngredientsType>(destination){}
+    virtual ~ReadSlitConfinement(){}
+    virtual void execute();
+};
+
+/**
+* @class ReadSlitConfinementWalls
+*
+* @brief Read the walls of the command !add_wall of FeatureWall into the slit
+*
+* @details The lines behind the command up to the next command or an empty line hold
+* the walls. Every wall is given by six integers, the base and the normal vector, any
+* other characters like b(x,y,z) n(x,y,z) are ignored.
+**/
+template<class IngredientsType>
+class ReadSlitConfinementWalls : public ReadToDestination<IngredientsType>
+{
+public:
+    explicit ReadSlitConfinementWalls(IngredientsType& destination):ReadToDestination<IngredientsType>(destination){}
+    virtual ~ReadSlitConfinementWalls(){}
+    virtual void execute();
+
+private:
+    //! helper function: append all integers of line to values
+    static void parseIntegers(const std::string& line, std::vector<int32_t>& values);
+};
+
+/**
+* @class WriteSlitConfinement
+*
+* @brief Write the command !slit_confinement=lowerZ upperZ if the slit has any bound
+**/
+template<class IngredientsType>
+class WriteSlitConfinement : public AbstractWrite<IngredientsType>
+{
+public:
+    explicit WriteSlitConfinement(const IngredientsType& source):AbstractWrite<IngredientsType>(source){ this->setHeaderOnly(true); }
+    virtual ~WriteSlitConfinement(){}
+    virtual void writeStream(std::ostream& stream);
+};
+
+
+inline FeatureSlitConfinement::FeatureSlitConfinement()
+:lowerZ(std::numeric_limits<int32_t>::min()), upperZ(std::numeric_limits<int32_t>::max())
+{
+    updateCubeRange();
+}
+
+/**
+* @param lowerZ_ lowest accessible plane
+* @param upperZ_ first inaccessible plane, at least lowerZ_+2
+*/
+inline void FeatureSlitConfinement::setSlit(int32_t lowerZ_, int32_t upperZ_)
+{
+    if(int64_t(upperZ_)-int64_t(lowerZ_) < 2){
+        throw std::runtime_error("FeatureSlitConfinement: slit is too narrow for a monomer");
+    }
+    lowerZ=lowerZ_;
+    upperZ=upperZ_;
+    updateCubeRange();
+}
+
+inline void FeatureSlitConfinement::clearSlit()
+{
+    lowerZ=std::numeric_limits<int32_t>::min();
+    upperZ=std::numeric_limits<int32_t>::max();
+    updateCubeRange();
+}
+
+/**
+* @details Only walls perpendicular to z can be mapped onto the slit. A wall at plane
+* z=c makes this plane inaccessible: with normal (0,0,1) it is the upper bound c, with
+* normal (0,0,-1) the lower bound is c+1. Tighter bounds win if several walls are added.
+*
+* @param wall wall with normal (0,0,1) or (0,0,-1)
+*/
+inline void FeatureSlitConfinement::addWall(const Wall& wall)
+{
+    const VectorInt3 normal(wall.getNormal());
+    if(normal.getX()!=0 || normal.getY()!=0 || normal.getZ()==0){
+        throw std::runtime_error("FeatureSlitConfinement: only walls perpendicular to z are supported");
+    }
+
+    const int32_t plane(wall.getBase().getZ());
+    if(normal.getZ() > 0){
+        setSlit(lowerZ, (plane < upperZ) ? plane : upperZ);
+    }else{
+        setSlit((plane+1 > lowerZ) ? plane+1 : lowerZ, upperZ);
+    }
+}
+
+inline std::vector<Wall> FeatureSlitConfinement::getWalls() const
+{
+    std::vector<Wall> walls;
+    if(hasLowerBound()){
+        Wall wall;
+        wall.setBase(0,0,lowerZ-1);
+        wall.setNormal(0,0,-1);
+        walls.push_back(wall);
+    }
+    if(hasUpperBound()){
+        Wall wall;
+        wall.setBase(0,0,upperZ);
+        wall.setNormal(0,0,1);
+        walls.push_back(wall);
+    }
+    return walls;
+}
+
+inline void FeatureSlitConfinement::updateCubeRange()
+{
+    cubeZMin=lowerZ;
+    cubeZMax=hasUpperBound() ? upperZ-2 : upperZ;
+}
+
+/**
+* @param ingredients system the move is applied to
+* @param move local move of one monomer by one lattice unit
+* @return true if the moved cube is inside the slit
+*/
+template<class IngredientsType>
+inline bool FeatureSlitConfinement::checkMove(const IngredientsType& ingredients, const MoveLocalSc& move) const
+{
+    return isInside(ingredients.getMolecules()[move.getIndex()].getZ()+move.getDir().getZ());
+}
+
+/**
+* @param move move adding a monomer
+* @return true if the new cube is inside the slit
+*/
+template<class IngredientsType, class TagType>
+inline bool FeatureSlitConfinement::checkMove(const IngredientsType&, const MoveAddMonomerSc<TagType>& move) const
+{
+    return isInside(move.getPosition().getZ());
+}
+
+template<class IngredientsType>
+inline void FeatureSlitConfinement::exportRead(FileImport<IngredientsType>& fileReader)
+{
+    fileReader.registerRead("!slit_confinement", new ReadSlitConfinement<IngredientsType>(fileReader.getDestination()));
+    fileReader.registerRead("!add_wall", new ReadSlitConfinementWalls<IngredientsType>(fileReader.getDestination()));
+}
+
+template<class IngredientsType>
+inline void FeatureSlitConfinement::exportWrite(AnalyzerWriteBfmFile<IngredientsType>& fileWriter) const
+{
+    fileWriter.registerWrite("!slit_confinement", new WriteSlitConfinement<IngredientsType>(fileWriter.getIngredients_()));
+}
+
+template<class IngredientsType>
+void ReadSlitConfinement<IngredientsType>::execute()
+{
+    std::string line;
+    std::getline(this->getInputStream(),line);
+    const size_t assign(line.find('='));
+    if(assign!=std::string::npos){
+        line.erase(0,assign+1);
+    }
+
+    std::stringstream stream(line);
+    int32_t lowerZ, upperZ;
+    if(!(stream >> lowerZ >> upperZ)){
+        throw std::runtime_error("ReadSlitConfinement: could not read bounds from !slit_confinement="+line);
+    }
+    this->getDestination().setSlit(lowerZ,upperZ);
+}
+
+template<class IngredientsType>
+void ReadSlitConfinementWalls<IngredientsType>::execute()
+{
+    std::istream& source(this->getInputStream());
+
+    // rest of the command line and the wall lines up to the next command
+    std::vector<int32_t> values;
+    std::string line;
+    std::getline(source,line);
+    parseIntegers(line,values);
+    while(source.peek() != '!' && std::getline(source,line) && !line.empty()){
+        parseIntegers(line,values);
+    }
+
+    if(values.empty() || (values.size() % 6) != 0){
+        throw std::runtime_error("ReadSlitConfinementWalls: !add_wall needs base and normal vector of every wall");
+    }
+    for(size_t w=0; w<values.size(); w+=6){
+        Wall wall;
+        wall.setBase(values[w],values[w+1],values[w+2]);
+        wall.setNormal(values[w+3],values[w+4],values[w+5]);
+        this->getDestination().addWall(wall);
+    }
+}
+
+template<class IngredientsType>
+void ReadSlitConfinementWalls<IngredientsType>::parseIntegers(const std::string& line, std::vector<int32_t>& values)
+{
+    const char* position(line.c_str());
+    while(*position != '\0'){
+        const bool sign((*position == '-' || *position == '+') && position[1] >= '0' && position[1] <= '9');
+        if(sign || (*position >= '0' && *position <= '9')){
+            char* end(0);
+            values.push_back(int32_t(std::strtol(position,&end,10)));
+            position=end;
+        }else{
+            position++;
+        }
+    }
+}
+
+template<class IngredientsType>
+void WriteSlitConfinement<IngredientsType>::writeStream(std::ostream& stream)
+{
+    const IngredientsType& ingredients(this->getSource());
+    if(ingredients.hasLowerBound() || ingredients.hasUpperBound()){
+        stream << "!slit_confinement=" << ingredients.getLowerZ() << " " << ingredients.getUpperZ() << std::endl << std::endl;
+    }
+}
+
+#endif //FEATURE_SLIT_CONFINEMENT_H
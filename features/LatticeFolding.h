@@ -0,0 +1,71 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+#ifndef LATTICE_FOLDING_H
+#define LATTICE_FOLDING_H
+/**
+* @file
+*
+* @brief Folding of lattice coordinates shared by the slit lattices
+* FeatureLatticeSlit, FeatureLatticeBitPacked, FeatureLatticeTiled and
+* FeatureLatticeSparse.
+**/
+
+#include <stdint.h>
+
+/**
+* @brief fold c periodically into [0,box)
+*
+* @details Coordinates inside of the box are returned after a single unsigned
+* comparison, the modulo is only needed for coordinates outside.
+*/
+inline uint32_t foldPeriodic(int32_t c, uint32_t box)
+{
+    if(uint32_t(c) < box){
+        return uint32_t(c);
+    }
+    int32_t folded(c % int32_t(box));
+    return uint32_t( (folded < 0) ? folded+int32_t(box) : folded );
+}
+
+/**
+* @brief fold z into [0,boxZ) if periodicZ, else return boxZ for z outside of [0,boxZ)
+*
+* @details The slit lattices use the returned boxZ as marker of a site outside of a
+* non-periodic box: it reads as empty and can not be set.
+*/
+inline uint32_t foldZ(int32_t z, uint32_t boxZ, bool periodicZ)
+{
+    if(uint32_t(z) < boxZ){
+        return uint32_t(z);
+    }
+    if(!periodicZ){
+        return boxZ;
+    }
+    return foldPeriodic(z,boxZ);
+}
+
+#endif //LATTICE_FOLDING_H
@@ -0,0 +1,106 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+#ifndef LATTICE_PROBE_COMPARISON_H
+#define LATTICE_PROBE_COMPARISON_H
+/**
+* @file
+*
+* @brief Test helper comparing the force probe on the lattice of a system with the
+* probe on an incremental copy of the system.
+*
+* @details Shared by the tests of the slit lattices: a lattice is a valid drop-in
+* replacement if AnalyzerForce counts the same jumps with PROBE_LATTICE as with
+* PROBE_INCREMENTAL_COPY, whose copy uses the lattice of LeMonADE.
+**/
+
+#include <stdint.h>
+#include <vector>
+
+#include "catch.hpp"
+
+#include "UpdaterSimulatorForceSampling.h"
+#include "AnalyzerForce.h"
+
+//! does nothing, default check after every simulation step
+struct NoStepCheck
+{
+    template<class IngredientsType>
+    void operator()(const IngredientsType&) const {}
+};
+
+/**
+* @brief simulate ingredients and compare the counters of both probe types
+*
+* @param ingredients system set up with the lattice under test
+* @param selection indices of the probed monomers
+* @param mcs monte carlo steps between two samples
+* @param nSamples number of samples
+* @param stepCheck called with ingredients after every simulation step
+* @return number of probe tries of the lattice probe
+*/
+template<class IngredientsType, class StepCheck>
+uint64_t compareLatticeProbeWithCopy(IngredientsType& ingredients, const std::vector<uint32_t>& selection, uint32_t mcs, uint32_t nSamples, StepCheck stepCheck)
+{
+    UpdaterSimulatorForceSampling<IngredientsType> Simon(ingredients, mcs, std::vector<uint32_t>());
+    Simon.setVerbose(false);
+    Simon.initialize();
+
+    AnalyzerForce<IngredientsType> Fritz(ingredients, selection, 0);
+    AnalyzerForce<IngredientsType> Franz(ingredients, selection, 0, AnalyzerForce<IngredientsType>::PROBE_INCREMENTAL_COPY);
+    Fritz.initialize();
+    Franz.initialize();
+
+    for(uint32_t n=0; n<nSamples; n++){
+        Simon.execute();
+        stepCheck(ingredients);
+        Fritz.execute();
+        Franz.execute();
+    }
+    CHECK(Fritz.getCounterPlus() == Franz.getCounterPlus());
+    CHECK(Fritz.getCounterMinus() == Franz.getCounterMinus());
+    return Fritz.getCounterTries();
+}
+
+//! compareLatticeProbeWithCopy without a check after the simulation steps
+template<class IngredientsType>
+uint64_t compareLatticeProbeWithCopy(IngredientsType& ingredients, const std::vector<uint32_t>& selection, uint32_t mcs, uint32_t nSamples)
+{
+    return compareLatticeProbeWithCopy(ingredients, selection, mcs, nSamples, NoStepCheck());
+}
+
+//! indices of all monomers of ingredients
+template<class IngredientsType>
+std::vector<uint32_t> allMonomers(const IngredientsType& ingredients)
+{
+    std::vector<uint32_t> selection;
+    for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+        selection.push_back(i);
+    }
+    return selection;
+}
+
+#endif //LATTICE_PROBE_COMPARISON_H
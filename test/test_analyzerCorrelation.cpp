@@ -0,0 +1,98 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include "AnalyzerCorrelation.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+TEST_CASE( "TestAnalyzerCorrelation" ) {
+    IngredientsType ingredients;
+    ingredients.setBoxX(16);
+    ingredients.setBoxY(16);
+    ingredients.setBoxZ(16);
+    ingredients.setPeriodicX(true);
+    ingredients.setPeriodicY(true);
+    ingredients.setPeriodicZ(true);
+    ingredients.modifyMolecules().addMonomer(0,0,0);
+    ingredients.modifyMolecules().addMonomer(2,0,0);
+    ingredients.modifyMolecules().addMonomer(4,0,0);
+
+    AnalyzerCorrelation<IngredientsType> Cora(ingredients, std::vector<uint32_t>(1,1), 20, "testCorrelation.dat");
+    CHECK(Cora.getFilename() == "testCorrelation.dat");
+    Cora.initialize();
+
+    // the middle monomer hops between z=0 and z=2, so its height is anticorrelated at lag 1
+    for(uint32_t t=0; t<64; t++){
+        ingredients.modifyMolecules().setAge(10*t);
+        ingredients.modifyMolecules()[1].setZ(2*(t%2));
+        Cora.execute();
+    }
+
+    // samples before age 20 are skipped
+    CHECK(Cora.getEndToEndCorrelator().getNumberOfSamples() == 62);
+    CHECK(Cora.getSampleInterval() == Approx(10.0));
+    CHECK(Cora.getEndToEndCorrelator().getMean(0) == Approx(4.0));
+    // Rg^2 is 8/3 with the middle monomer at z=0 and 32/9 at z=2
+    CHECK(Cora.getGyrationCorrelator().getMean(0) == Approx((8.0/3.0+32.0/9.0)/2.0));
+
+    std::vector<uint64_t> lags;
+    std::vector<double> correlation;
+    Cora.getHeightCorrelator(0).getCorrelation(lags,correlation);
+    CHECK(correlation[1] == Approx(-1.0).epsilon(0.05));
+    CHECK(Cora.getHeightCorrelator(0).getIntegratedTime() == 0.0);
+
+    Cora.cleanup();
+    std::ifstream result("testCorrelation.dat");
+    REQUIRE(result.good());
+    std::string content((std::istreambuf_iterator<char>(result)),std::istreambuf_iterator<char>());
+    CHECK(content.find("tau_z(1)= 0") != std::string::npos);
+    CHECK(content.find("# tau = (1/2 + sum of C") != std::string::npos);
+    CHECK(content.find("C_z(1)") != std::string::npos);
+    result.close();
+    std::remove("testCorrelation.dat");
+
+    AnalyzerCorrelation<IngredientsType> Carl(ingredients, std::vector<uint32_t>(1,3));
+    CHECK_THROWS_AS(Carl.initialize(), std::runtime_error);
+}
@@ -28,6 +28,11 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 // use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
 #include "catch.hpp"
 
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
 #include <LeMonADE/core/Ingredients.h>
 #include <LeMonADE/feature/FeatureMoleculesIO.h>
 #include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
@@ -36,9 +41,11 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
 #include <LeMonADE/feature/FeatureFixedMonomers.h>
 
 #include <LeMonADE/utility/RandomNumberGenerators.h>
+#include <LeMonADE/updater/UpdaterSimpleSimulator.h>
 
 #include "UpdaterCreateChainInSlit.h"
 #include "AnalyzerForce.h"
+#include "ForceProbeBatch.h"
 
 typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
 typedef ConfigureSystem<VectorInt3,Features,4> Config;
@@ -130,6 +137,35 @@ TEST_CASE( "TestAnalyzerForce_execute" ) {
     CHECK(Calvin.getCounterMinus().at(0) == 1);
     CHECK(Calvin.getCounterTries() == 1);
 
+    // without a jump up the force is not defined
+    CHECK(!Calvin.isForceDefined(0));
+    CHECK(std::isnan(Calvin.getForce(0)));
+    CHECK(std::isnan(Calvin.getForceError(0)));
+    CHECK(std::isnan(Calvin.getForceErrorNaive(0)));
+    CHECK(!Calvin.isForceErrorConverged(0));
+
+    AnalyzerForce<IngredientsType> Carla(ingredients, std::vector<uint32_t> (1,0), 0);
+    Carla.setProbeAllAxes(true);
+    Carla.initialize();
+    CHECK(Carla.getCounterDirection(0,0) == 1);
+    CHECK(Carla.getForce(0,0) == 0.0);
+    CHECK(std::isnan(Carla.getForce(0,2)));
+
+    // force.dat reports nan instead of inf
+    Calvin.setFilename("test_force_undefined.dat");
+    Calvin.writeResults();
+    std::ifstream undefined("test_force_undefined.dat");
+    std::string line, values;
+    while(std::getline(undefined,line)){
+        if(!line.empty() && line[0] != '#'){
+            values+=line;
+        }
+    }
+    CHECK(values.find("nan") != std::string::npos);
+    CHECK(values.find("inf") == std::string::npos);
+    undefined.close();
+    std::remove("test_force_undefined.dat");
+
     // move second monomer to block minus movement
     ingredients.modifyMolecules()[1].setAllCoordinates(0,0,3);
 
@@ -213,3 +249,407 @@ TEST_CASE( "TestAnalyzerForce_execute" ) {
 
 }
 
+
+TEST_CASE( "TestAnalyzerForce_probeTypes" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    // analyzer copying the complete system, updating moved monomers only and reading the lattice of ingredients
+    std::vector<uint32_t> selection {0,5,10,15};
+    AnalyzerForce<IngredientsType> Anna(ingredients, selection, 0, AnalyzerForce<IngredientsType>::PROBE_FULL_COPY);
+    AnalyzerForce<IngredientsType> Berta(ingredients, selection, 0, AnalyzerForce<IngredientsType>::PROBE_INCREMENTAL_COPY);
+    AnalyzerForce<IngredientsType> Carla(ingredients, selection, 0);
+    CHECK(Anna.getProbeType() == AnalyzerForce<IngredientsType>::PROBE_FULL_COPY);
+    CHECK(Berta.getProbeType() == AnalyzerForce<IngredientsType>::PROBE_INCREMENTAL_COPY);
+    CHECK(Carla.getProbeType() == AnalyzerForce<IngredientsType>::PROBE_LATTICE);
+    Anna.initialize();
+    Berta.initialize();
+    Carla.initialize();
+
+    UpdaterSimpleSimulator<IngredientsType,MoveLocalSc> simulator(ingredients,1);
+    for(uint32_t n=0; n<200; n++){
+        simulator.execute();
+        Anna.execute();
+        Berta.execute();
+        Carla.execute();
+    }
+
+    CHECK(Anna.getCounterTries() == 201);
+    CHECK(Berta.getCounterTries() == 201);
+    CHECK(Carla.getCounterTries() == 201);
+    for(uint32_t i=0; i<selection.size(); i++){
+        CHECK(Anna.getCounterPlus().at(i) == Berta.getCounterPlus().at(i));
+        CHECK(Anna.getCounterMinus().at(i) == Berta.getCounterMinus().at(i));
+        CHECK(Anna.getCounterPlus().at(i) == Carla.getCounterPlus().at(i));
+        CHECK(Anna.getCounterMinus().at(i) == Carla.getCounterMinus().at(i));
+    }
+}
+
+TEST_CASE( "TestAnalyzerForce_allMonomers" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    // all monomers in one batch, by an explicit list of all monomers and one by one on a copy
+    std::vector<uint32_t> all;
+    for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+        all.push_back(i);
+    }
+    AnalyzerForce<IngredientsType> Dora(ingredients, std::vector<uint32_t>(), 0);
+    AnalyzerForce<IngredientsType> Emil(ingredients, all, 0);
+    AnalyzerForce<IngredientsType> Frida(ingredients, all, 0, AnalyzerForce<IngredientsType>::PROBE_FULL_COPY);
+    Dora.selectAllMonomers();
+    CHECK(Dora.isAllMonomers());
+    CHECK(!Emil.isAllMonomers());
+    CHECK(Dora.getSelectedMonomers().empty());
+
+    Dora.initialize();
+    Emil.initialize();
+    Frida.initialize();
+    CHECK(Dora.getSelectedMonomers() == all);
+    CHECK(Emil.isAllMonomers());
+
+    UpdaterSimpleSimulator<IngredientsType,MoveLocalSc> simulator(ingredients,1);
+    for(uint32_t n=0; n<200; n++){
+        simulator.execute();
+        Dora.execute();
+        Emil.execute();
+        Frida.execute();
+    }
+
+    CHECK(Dora.getCounterTries() == 201);
+    CHECK(Dora.getCounterPlus() == Frida.getCounterPlus());
+    CHECK(Dora.getCounterMinus() == Frida.getCounterMinus());
+    CHECK(Emil.getCounterPlus() == Frida.getCounterPlus());
+    CHECK(Emil.getCounterMinus() == Frida.getCounterMinus());
+    CHECK(Dora.getProbeStatistics(7).getNumberOfSamples() == 201);
+
+    // an analyzer of all monomers merges with the explicit list
+    AnalyzerForce<IngredientsType> merged(ingredients, std::vector<uint32_t>(), 0);
+    merged.selectAllMonomers();
+    merged.merge(Dora);
+    merged.merge(Emil);
+    CHECK(merged.getCounterTries() == 402);
+    CHECK(merged.getCounterPlus().at(3) == 2*Dora.getCounterPlus().at(3));
+}
+
+TEST_CASE( "TestAnalyzerForce_probeBatch" ) {
+    // the classic squared lengths give the classic bondset
+    BondMoveTable table;
+    for(int32_t x=-4; x<=4; x++){
+        for(int32_t y=-4; y<=4; y++){
+            for(int32_t z=-4; z<=4; z++){
+                CHECK(bool(ForceProbeBatch::isClassicLength(x*x+y*y+z*z)) == table.isClassicBond(VectorInt3(x,y,z)));
+            }
+        }
+    }
+    CHECK(ForceProbeBatch::isClassicLength(-1) == 0);
+    CHECK(ForceProbeBatch::isClassicLength(20) == 0);
+
+    // branched molecule with one neighbor blocking a jump
+    IngredientsType ingredients;
+    ingredients.setBoxX(16);
+    ingredients.setBoxY(16);
+    ingredients.setBoxZ(16);
+    ingredients.setPeriodicX(true);
+    ingredients.setPeriodicY(true);
+    ingredients.setPeriodicZ(true);
+    ingredients.modifyBondset().addBFMclassicBondset();
+    ingredients.modifyMolecules().addMonomer(4,4,4);
+    ingredients.modifyMolecules().addMonomer(6,4,4);
+    ingredients.modifyMolecules().addMonomer(4,4,7);
+    ingredients.modifyMolecules().addMonomer(4,7,4);
+    ingredients.modifyMolecules().addMonomer(6,4,6);
+    ingredients.modifyMolecules().addMonomer(10,10,15);
+    ingredients.modifyMolecules().connect(0,1);
+    ingredients.modifyMolecules().connect(0,2);
+    ingredients.modifyMolecules().connect(0,3);
+    ingredients.modifyMolecules().connect(1,4);
+    ingredients.synchronize();
+
+    ForceProbeView<IngredientsType> view(ingredients);
+    ForceProbeKernel kernel;
+    ForceProbeBatch batch;
+    batch.setup(ingredients.getMolecules());
+    CHECK(batch.getNumberOfMonomers() == 6);
+    CHECK(batch.getNumberOfBonds() == 4);
+
+    batch.probe(view, kernel);
+    CHECK(batch.getDirections() == 0x30);
+    for(uint32_t i=0; i<6; i++){
+        CHECK(((batch.getJumps()[i] >> 4) & 1) == kernel.checkJump(view, i, VectorInt3(0,0,1)));
+        CHECK(((batch.getJumps()[i] >> 5) & 1) == kernel.checkJump(view, i, VectorInt3(0,0,-1)));
+        CHECK((batch.getJumps()[i] & 0x0F) == 0);
+    }
+    // the bond (0,0,3) of monomer 0 forbids the jump down, monomer 4 blocks the jump up of monomer 1
+    CHECK(((batch.getJumps()[0] >> 5) & 1) == 0);
+    CHECK(((batch.getJumps()[1] >> 4) & 1) == 0);
+    CHECK(batch.getJumps()[5] == 0x30);
+
+    // all six directions equal the single checks of the kernel
+    batch.setup(ingredients.getMolecules(), true);
+    batch.probe(view, kernel);
+    CHECK(batch.getDirections() == 0x3F);
+    for(uint32_t i=0; i<6; i++){
+        CHECK(batch.getJumps()[i] == kernel.getAllowedJumps(view, i));
+        for(uint32_t d=0; d<6; d++){
+            CHECK(((batch.getJumps()[i] >> d) & 1) == kernel.checkJump(view, i, BondMoveTable::getDirection(d)));
+        }
+    }
+    // monomer 1 and the bond (2,0,0) block the jump of monomer 0 in +x, the bond (0,3,0) the one in -y
+    CHECK(((batch.getJumps()[0] >> 0) & 1) == 0);
+    CHECK(((batch.getJumps()[0] >> 1) & 1) == 1);
+    CHECK(((batch.getJumps()[0] >> 3) & 1) == 0);
+    CHECK(batch.getJumps()[5] == 0x3F);
+    CHECK(kernel.getAllowedJumps(view, 5, 0x0C) == 0x0C);
+}
+
+TEST_CASE( "TestAnalyzerForce_allAxes" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    // all axes on the lattice, on a copy, in one batch of all monomers and z only
+    std::vector<uint32_t> selection {0,5,10,15};
+    AnalyzerForce<IngredientsType> Greta(ingredients, selection, 0);
+    AnalyzerForce<IngredientsType> Hanna(ingredients, selection, 0, AnalyzerForce<IngredientsType>::PROBE_INCREMENTAL_COPY);
+    AnalyzerForce<IngredientsType> Ida(ingredients, std::vector<uint32_t>(), 0);
+    AnalyzerForce<IngredientsType> Jana(ingredients, selection, 0);
+    Greta.setProbeAllAxes(true);
+    Hanna.setProbeAllAxes(true);
+    Ida.setProbeAllAxes(true);
+    Ida.selectAllMonomers();
+    CHECK(Greta.isProbeAllAxes());
+    CHECK(!Jana.isProbeAllAxes());
+    CHECK_THROWS(Jana.getForce(0,0));
+
+    Greta.initialize();
+    Hanna.initialize();
+    Ida.initialize();
+    Jana.initialize();
+
+    UpdaterSimpleSimulator<IngredientsType,MoveLocalSc> simulator(ingredients,1);
+    for(uint32_t n=0; n<200; n++){
+        simulator.execute();
+        Greta.execute();
+        Hanna.execute();
+        Ida.execute();
+        Jana.execute();
+    }
+
+    uint64_t sumX(0);
+    for(uint32_t i=0; i<selection.size(); i++){
+        for(uint32_t d=0; d<6; d++){
+            CHECK(Greta.getCounterDirection(i,d) == Hanna.getCounterDirection(i,d));
+            CHECK(Greta.getCounterDirection(i,d) == Ida.getCounterDirection(selection[i],d));
+        }
+        // the z counters are the ones of the z probe
+        CHECK(Greta.getCounterDirection(i,4) == Jana.getCounterPlus().at(i));
+        CHECK(Greta.getCounterDirection(i,5) == Jana.getCounterMinus().at(i));
+        CHECK(Greta.getCounterPlus().at(i) == Jana.getCounterPlus().at(i));
+        sumX+=Greta.getCounterDirection(i,0)+Greta.getCounterDirection(i,1);
+    }
+    CHECK(sumX > 0);
+    // a monomer without jumps in one direction has no force
+    if(Greta.getCounterDirection(1,0) > 0 && Greta.getCounterDirection(1,1) > 0){
+        CHECK(Greta.getForce(1,0) == log(double(Greta.getCounterDirection(1,1))/double(Greta.getCounterDirection(1,0))));
+    }else{
+        CHECK(std::isnan(Greta.getForce(1,0)));
+    }
+    if(Greta.isForceDefined(1)){
+        CHECK(Greta.getForce(1,2) == Greta.getForce(1));
+    }else{
+        CHECK(std::isnan(Greta.getForce(1,2)));
+        CHECK(std::isnan(Greta.getForce(1)));
+    }
+
+    // merging needs the same directions, the checkpoint keeps them
+    AnalyzerForce<IngredientsType> merged(ingredients, selection, 0);
+    CHECK_THROWS(merged.merge(Greta));
+    merged.setProbeAllAxes(true);
+    merged.merge(Greta);
+    merged.merge(Hanna);
+    CHECK(merged.getCounterDirection(2,3) == 2*Greta.getCounterDirection(2,3));
+
+    CheckpointWriter writer;
+    Greta.saveState(writer);
+    AnalyzerForce<IngredientsType> restored(ingredients, selection, 0);
+    CheckpointReader wrongReader(writer.getBuffer());
+    CHECK_THROWS(restored.loadState(wrongReader));
+    restored.setProbeAllAxes(true);
+    CheckpointReader reader(writer.getBuffer());
+    restored.loadState(reader);
+    CHECK(reader.isAtEnd());
+    CHECK(restored.getCounterDirection(3,2) == Greta.getCounterDirection(3,2));
+}
+
+TEST_CASE( "TestAnalyzerForce_profile" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // slit of 14 planes in a box of 16 planes, not periodic in z, one bin per position of the monomer cube in the slit
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    std::vector<uint32_t> selection {0,5,10,15};
+    AnalyzerForce<IngredientsType> Karla(ingredients, selection, 0);
+    AnalyzerForce<IngredientsType> Lena(ingredients, selection, 0);
+    Karla.setProfile(true);
+    Karla.setFilename("test_force_profile.dat");
+    CHECK(Karla.isProfile());
+    CHECK(!Lena.isProfile());
+    CHECK(Karla.getProfileFilename() == "test_force_profile_profile.dat");
+
+    Karla.initialize();
+    Lena.initialize();
+    CHECK(Karla.getNumberOfProfileBins() == 13);
+    CHECK(Lena.getNumberOfProfileBins() == 0);
+
+    UpdaterSimpleSimulator<IngredientsType,MoveLocalSc> simulator(ingredients,1);
+    for(uint32_t n=0; n<200; n++){
+        simulator.execute();
+        Karla.execute();
+        Lena.execute();
+    }
+
+    typedef AnalyzerForce<IngredientsType> Analyzer;
+    for(uint32_t i=0; i<selection.size(); i++){
+        // every probe is in one bin of every type, the sums are the counters of the whole run
+        uint64_t tries[3]={0,0,0}, plus[3]={0,0,0}, minus(0);
+        for(uint32_t bin=0; bin<Karla.getNumberOfProfileBins(); bin++){
+            for(int type=0; type<3; type++){
+                tries[type]+=Karla.getProfileTries(type,i,bin);
+                plus[type]+=Karla.getProfileCounterPlus(type,i,bin);
+            }
+            minus+=Karla.getProfileCounterMinus(Analyzer::PROFILE_LAYER,i,bin);
+
+            // the lower wall is the bottom of the box at z=0, the upper wall the plane z=14
+            CHECK(Karla.getProfileTries(Analyzer::PROFILE_LOWER_WALL,i,bin) == Karla.getProfileTries(Analyzer::PROFILE_LAYER,i,bin));
+            if(bin <= 12){
+                CHECK(Karla.getProfileCounterPlus(Analyzer::PROFILE_UPPER_WALL,i,12-bin) == Karla.getProfileCounterPlus(Analyzer::PROFILE_LAYER,i,bin));
+            }else{
+                CHECK(Karla.getProfileTries(Analyzer::PROFILE_LAYER,i,bin) == 0);
+            }
+        }
+        for(int type=0; type<3; type++){
+            CHECK(tries[type] == 201);
+            CHECK(plus[type] == Lena.getCounterPlus().at(i));
+        }
+        CHECK(minus == Lena.getCounterMinus().at(i));
+    }
+
+    // the fixed end monomer at the bottom stays in the first layer
+    CHECK(Karla.getProfileTries(Analyzer::PROFILE_LAYER,0,ingredients.getMolecules()[0].getZ()) == 201);
+
+    // merge and checkpoint keep the profile
+    AnalyzerForce<IngredientsType> merged(ingredients, selection, 0);
+    AnalyzerForceOptions options;
+    options.profile=true;
+    merged.setOptions(options);
+    CHECK(merged.isProfile());
+    CHECK(!merged.isProbeAllAxes());
+    merged.merge(Karla);
+    merged.merge(Karla);
+    CHECK(merged.getProfileTries(Analyzer::PROFILE_UPPER_WALL,2,3) == 2*Karla.getProfileTries(Analyzer::PROFILE_UPPER_WALL,2,3));
+    CHECK_THROWS(merged.merge(Lena));
+
+    CheckpointWriter writer;
+    Karla.saveState(writer);
+    AnalyzerForce<IngredientsType> restored(ingredients, selection, 0);
+    restored.setProfile(true);
+    CheckpointReader reader(writer.getBuffer());
+    restored.loadState(reader);
+    CHECK(reader.isAtEnd());
+    CHECK(restored.getProfileCounterPlus(Analyzer::PROFILE_LAYER,1,4) == Karla.getProfileCounterPlus(Analyzer::PROFILE_LAYER,1,4));
+
+    // the profile is written next to the results
+    Karla.cleanup();
+    std::ifstream file(Karla.getProfileFilename().c_str());
+    CHECK(file.good());
+    file.close();
+    std::remove("test_force_profile.dat");
+    std::remove(Karla.getProfileFilename().c_str());
+}
+
+TEST_CASE( "TestAnalyzerForce_errors" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    std::vector<uint32_t> selection {0,5,10,15};
+    AnalyzerForce<IngredientsType> Anna(ingredients, selection, 0);
+    CHECK(Anna.getFlushInterval() == 0);
+    Anna.setFlushInterval(50);
+    CHECK(Anna.getFlushInterval() == 50);
+    Anna.initialize();
+
+    UpdaterSimpleSimulator<IngredientsType,MoveLocalSc> simulator(ingredients,1);
+    for(uint32_t n=0; n<400; n++){
+        simulator.execute();
+        Anna.execute();
+    }
+
+    for(uint32_t i=0; i<selection.size(); i++){
+        // every probe is one sample of (jump down, jump up)
+        const BlockAverageAccumulator& statistics(Anna.getProbeStatistics(i));
+        CHECK(statistics.getNumberOfObservables() == 2);
+        CHECK(statistics.getNumberOfSamples() == Anna.getCounterTries());
+        CHECK(statistics.getMean(0)*Anna.getCounterTries() == Approx(Anna.getCounterMinus().at(i)));
+        CHECK(statistics.getMean(1)*Anna.getCounterTries() == Approx(Anna.getCounterPlus().at(i)));
+
+        if(Anna.getCounterMinus().at(i) > 0 && Anna.getCounterPlus().at(i) > 0){
+            CHECK(Anna.getForce(i) == Approx(log(double(Anna.getCounterMinus().at(i))/double(Anna.getCounterPlus().at(i)))));
+            CHECK(Anna.getForceErrorNaive(i) > 0.0);
+            CHECK(Anna.getForceError(i) >= 0.0);
+        }
+    }
+}
+
+TEST_CASE( "TestAnalyzerForce_probeView" ) {
+    IngredientsType ingredients;
+    ingredients.setBoxX(16);
+    ingredients.setBoxY(16);
+    ingredients.setBoxZ(16);
+    ingredients.setPeriodicX(true);
+    ingredients.setPeriodicY(true);
+    ingredients.setPeriodicZ(false);
+    ingredients.modifyBondset().addBFMclassicBondset();
+    ingredients.modifyMolecules().addMonomer(0,0,14);
+    ingredients.modifyMolecules()[0].setMovableTag(false);
+    ingredients.synchronize();
+
+    ForceProbeView<IngredientsType> view(ingredients);
+    CHECK(view.isPeriodicZ());
+    CHECK(view.getBoxZ() == 16);
+    CHECK(view.getMolecules()[0] == VectorInt3(0,0,14));
+
+    // z is folded periodically
+    CHECK(view.getLatticeEntry(VectorInt3(0,0,15)) == true);
+    CHECK(view.getLatticeEntry(VectorInt3(0,0,-1)) == true);
+    CHECK(view.getLatticeEntry(VectorInt3(1,1,-2)) == true);
+    CHECK(view.getLatticeEntry(VectorInt3(0,0,16)) == false);
+
+    // the fixed monomer can jump in the view
+    ForceProbeKernel kernel;
+    CHECK(kernel.checkJump(view, 0, VectorInt3(0,0,1)) == true);
+    CHECK(kernel.checkJump(view, 0, VectorInt3(0,0,-1)) == true);
+}
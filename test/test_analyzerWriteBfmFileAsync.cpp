@@ -0,0 +1,156 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+#include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "AnalyzerWriteBfmFileAsync.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+namespace{
+  std::string readFile(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str());
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+  }
+
+  //! shift all monomers and advance the age, the writers do not check the lattice
+  void step(IngredientsType& ing, int32_t n)
+  {
+    for(uint32_t i=0; i<ing.getMolecules().size(); i++){
+      const VectorInt3 pos(ing.getMolecules()[i]);
+      ing.modifyMolecules()[i].setAllCoordinates(pos.getX()+(n%3==0),pos.getY()+(n%3==1),pos.getZ());
+    }
+    ing.modifyMolecules().setAge(ing.getMolecules().getAge()+10);
+  }
+}
+
+TEST_CASE( "AnalyzerWriteBfmFileAsync_sameOutput" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    std::remove("test_async_sync.bfm");
+    std::remove("test_async_async.bfm");
+
+    AnalyzerWriteBfmFile<IngredientsType> Sam("test_async_sync.bfm", ingredients, AnalyzerWriteBfmFile<IngredientsType>::APPEND);
+    AnalyzerWriteBfmFileAsync<IngredientsType> Alice("test_async_async.bfm", ingredients, AnalyzerWriteBfmFileAsync<IngredientsType>::APPEND, 2);
+    AnalyzerWriteBfmFile<IngredientsType> Sally("test_async_sync_last.bfm", ingredients, AnalyzerWriteBfmFile<IngredientsType>::OVERWRITE);
+    AnalyzerWriteBfmFileAsync<IngredientsType> Amy("test_async_async_last.bfm", ingredients, AnalyzerWriteBfmFileAsync<IngredientsType>::OVERWRITE, 1);
+    CHECK(Alice.getQueueLength() == 2);
+    CHECK_THROWS(AnalyzerWriteBfmFileAsync<IngredientsType>("test_async_none.bfm", ingredients, AnalyzerWriteBfmFileAsync<IngredientsType>::APPEND, 0));
+    CHECK_THROWS(Alice.execute());
+
+    Sam.initialize();
+    Alice.initialize();
+    Sally.initialize();
+    Amy.initialize();
+
+    // the async writers copy the configuration before it is changed by the next step
+    for(int32_t n=0; n<50; n++){
+        step(ingredients, n);
+        Sam.execute();
+        Alice.execute();
+        Sally.execute();
+        Amy.execute();
+    }
+
+    Alice.flush();
+    CHECK(Alice.getNumberOfWrittenFrames() == 50);
+
+    Sam.cleanup();
+    Alice.cleanup();
+    Sally.cleanup();
+    Amy.cleanup();
+    CHECK(Amy.getNumberOfWrittenFrames() == 50);
+    CHECK(Amy.getNumberOfStalls() <= 50);
+
+    // all queued configurations are written in cleanup()
+    CHECK(readFile("test_async_async.bfm") == readFile("test_async_sync.bfm"));
+    CHECK(readFile("test_async_async_last.bfm") == readFile("test_async_sync_last.bfm"));
+    CHECK(readFile("test_async_async.bfm").size() > readFile("test_async_async_last.bfm").size());
+
+    // a second cleanup does nothing
+    CHECK_NOTHROW(Alice.cleanup());
+
+    std::remove("test_async_sync.bfm");
+    std::remove("test_async_async.bfm");
+    std::remove("test_async_sync_last.bfm");
+    std::remove("test_async_async_last.bfm");
+}
+
+TEST_CASE( "AnalyzerWriteBfmFileAsync_snapshot" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+    const VectorInt3 first(ingredients.getMolecules()[0]);
+
+    std::remove("test_async_snapshot.bfm");
+    AnalyzerWriteBfmFileAsync<IngredientsType> Alice("test_async_snapshot.bfm", ingredients, AnalyzerWriteBfmFileAsync<IngredientsType>::OVERWRITE, 1);
+    Alice.initialize();
+    Alice.execute();
+
+    // changes after execute() are not part of the written configuration
+    ingredients.modifyMolecules()[0].setAllCoordinates(first.getX()+100,first.getY(),first.getZ());
+    ingredients.modifyMolecules().setAge(1234);
+    Alice.cleanup();
+
+    std::stringstream expected;
+    expected << first;
+    const std::string content(readFile("test_async_snapshot.bfm"));
+    CHECK(content.find("1234") == std::string::npos);
+    CHECK(content.find(expected.str()) != std::string::npos);
+
+    std::remove("test_async_snapshot.bfm");
+}
@@ -0,0 +1,289 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "AnalyzerWriteBfmFileAsync.h"
+#include "UpdaterReadBfmFileIndexed.h"
+#include "BfmFrameIndex.h"
+#include "ThreadPool.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+namespace{
+  const std::string header("!number_of_monomers=2\n!box_x=16\n!box_y=16\n!box_z=16\n\n");
+
+  std::string frame(uint64_t mcs)
+  {
+    std::stringstream content;
+    content << "!mcs=" << mcs << "\n" << mcs%7 << " 0 0\n" << mcs%7+2 << " 0 0\n\n";
+    return content.str();
+  }
+
+  void writeFile(const std::string& filename, const std::string& content, bool append)
+  {
+    std::ofstream file(filename.c_str(), std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    file << content;
+  }
+
+  std::string readFile(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+  }
+}
+
+TEST_CASE( "BfmFrameIndex_build" ) {
+    const std::string filename("test_frameindex.bfm");
+    std::remove(BfmFrameIndex::getIndexFilename(filename).c_str());
+
+    std::string content(header);
+    for(uint64_t mcs=100; mcs<=1000; mcs+=100){
+        content+=frame(mcs);
+    }
+    writeFile(filename, content, false);
+
+    BfmFrameIndex Ivan(filename);
+    CHECK(Ivan.update() == 10);
+    CHECK(!Ivan.isSidecarUsed());
+    REQUIRE(Ivan.getNumberOfFrames() == 10);
+    CHECK(Ivan.getHeaderSize() == header.size());
+    for(uint64_t n=0; n<10; n++){
+        CHECK(Ivan.getMcs(n) == 100*(n+1));
+        CHECK(content.compare(Ivan.getOffset(n), Ivan.getFrameEnd(n)-Ivan.getOffset(n), frame(100*(n+1))) == 0);
+    }
+    CHECK(Ivan.findFrame(550) == 4);
+    CHECK(Ivan.findFrame(1000) == 9);
+    CHECK(Ivan.findFrame(5000) == 9);
+    CHECK_THROWS(Ivan.findFrame(50));
+
+    // header and one frame make up a bfm file
+    Ivan.extractFrame(9, "test_frameindex_last.bfm");
+    CHECK(readFile("test_frameindex_last.bfm") == header+frame(1000));
+    std::remove("test_frameindex_last.bfm");
+
+    // a second index uses the sidecar
+    BfmFrameIndex Ida(filename);
+    CHECK(Ida.update() == 0);
+    CHECK(Ida.isSidecarUsed());
+    CHECK(Ida.getNumberOfFrames() == 10);
+    CHECK(Ida.getOffset(9) == Ivan.getOffset(9));
+    CHECK(Ida.getFrameEnd(9) == content.size());
+
+    SECTION("appended frames"){
+        // incomplete lines of a running writer are not indexed
+        writeFile(filename, frame(1100)+"!mcs=1200", true);
+        CHECK(Ida.update() == 1);
+        writeFile(filename, "\n0 0 0\n2 0 0\n\n", true);
+        CHECK(Ida.update() == 1);
+        CHECK(Ida.getMcs(11) == 1200);
+
+        BfmFrameIndex Iris(filename);
+        CHECK(Iris.update() == 0);
+        CHECK(Iris.isSidecarUsed());
+        CHECK(Iris.getNumberOfFrames() == 12);
+        CHECK(Iris.getOffset(11) == Ida.getOffset(11));
+        CHECK(Iris.getFrameEnd(11) == readFile(filename).size());
+    }
+
+    SECTION("stale sidecar"){
+        writeFile(filename, header+frame(5)+frame(10), false);
+        BfmFrameIndex Iris(filename);
+        CHECK(Iris.update() == 2);
+        CHECK(!Iris.isSidecarUsed());
+        CHECK(Iris.getMcs(1) == 10);
+
+        // the running index notices the replaced file as well
+        CHECK(Ida.update() == 2);
+        CHECK(Ida.getNumberOfFrames() == 2);
+    }
+
+    SECTION("damaged sidecar"){
+        const std::string sidecar(readFile(BfmFrameIndex::getIndexFilename(filename)));
+        writeFile(BfmFrameIndex::getIndexFilename(filename), sidecar.substr(0, sidecar.size()-3), false);
+        BfmFrameIndex Iris(filename);
+        CHECK(Iris.update() == 10);
+        CHECK(!Iris.isSidecarUsed());
+        CHECK(readFile(BfmFrameIndex::getIndexFilename(filename)) == sidecar);
+    }
+
+    SECTION("missing sidecar"){
+        std::remove(BfmFrameIndex::getIndexFilename(filename).c_str());
+        BfmFrameIndex Iris(filename);
+        CHECK(Iris.update() == 10);
+        CHECK(!Iris.isSidecarUsed());
+    }
+
+    SECTION("removed frames"){
+        // frames behind a checkpoint at mcs 650 are cut off
+        CHECK(Ida.removeFramesAfter(650) == 4);
+        CHECK(Ida.getNumberOfFrames() == 6);
+        CHECK(readFile(filename) == content.substr(0, Ivan.getOffset(6)));
+        CHECK(Ida.removeFramesAfter(650) == 0);
+
+        BfmFrameIndex Iris(filename);
+        CHECK(Iris.update() == 0);
+        CHECK(Iris.isSidecarUsed());
+        CHECK(Iris.getMcs(5) == 600);
+        CHECK(Iris.getFrameEnd(5) == Ivan.getOffset(6));
+    }
+
+    std::remove(filename.c_str());
+    std::remove(BfmFrameIndex::getIndexFilename(filename).c_str());
+}
+
+TEST_CASE( "BfmFrameIndex_asyncWriter" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    const std::string filename("test_frameindex_async.bfm");
+    std::remove(filename.c_str());
+    std::remove(BfmFrameIndex::getIndexFilename(filename).c_str());
+
+    // the writer keeps the index of the appended trajectory up to date
+    for(uint32_t run=0; run<2; run++){
+        AnalyzerWriteBfmFileAsync<IngredientsType> Alice(filename, ingredients, AnalyzerWriteBfmFileAsync<IngredientsType>::APPEND, 2);
+        Alice.initialize();
+        for(uint32_t n=0; n<5; n++){
+            ingredients.modifyMolecules().setAge(ingredients.getMolecules().getAge()+10);
+            Alice.execute();
+        }
+        Alice.cleanup();
+    }
+
+    BfmFrameIndex Ivan(filename);
+    CHECK(Ivan.update() == 0);
+    CHECK(Ivan.isSidecarUsed());
+    REQUIRE(Ivan.getNumberOfFrames() == 10);
+    CHECK(Ivan.getMcs(9) == 100);
+    CHECK(Ivan.getFrameEnd(9) == readFile(filename).size());
+
+    CHECK_THROWS(UpdaterReadBfmFileIndexed<IngredientsType>(filename, ingredients, 3));
+    UpdaterReadBfmFileIndexed<IngredientsType> Rudi(filename, ingredients, UpdaterReadBfmFileIndexed<IngredientsType>::READ_NTH_CONFIG, 10);
+    CHECK_THROWS(Rudi.initialize());
+
+    std::remove(filename.c_str());
+    std::remove(BfmFrameIndex::getIndexFilename(filename).c_str());
+}
+
+TEST_CASE( "BfmFrameIndex_readFrame" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+    const uint32_t nMonomers(ingredients.getMolecules().size());
+
+    const std::string filename("test_frameindex_read.bfm");
+    std::remove(filename.c_str());
+    std::remove(BfmFrameIndex::getIndexFilename(filename).c_str());
+
+    // every frame shifts the chain in x, so all frames differ
+    std::vector< std::vector<VectorInt3> > frames;
+    AnalyzerWriteBfmFileAsync<IngredientsType> Alice(filename, ingredients, AnalyzerWriteBfmFileAsync<IngredientsType>::APPEND, 2);
+    Alice.initialize();
+    for(uint32_t n=0; n<6; n++){
+        std::vector<VectorInt3> positions;
+        for(uint32_t i=0; i<nMonomers; i++){
+            const VectorInt3 pos(ingredients.getMolecules()[i]);
+            ingredients.modifyMolecules()[i].setAllCoordinates(pos.getX()+n+1,pos.getY(),pos.getZ());
+            positions.push_back(VectorInt3(ingredients.getMolecules()[i]));
+        }
+        frames.push_back(positions);
+        ingredients.modifyMolecules().setAge(ingredients.getMolecules().getAge()+10);
+        Alice.execute();
+    }
+    Alice.cleanup();
+
+    BfmFrameIndex Ivan(filename);
+    Ivan.update();
+    REQUIRE(Ivan.getNumberOfFrames() == 6);
+
+    // frame k read through the index matches the written positions
+    for(uint64_t k=0; k<6; k++){
+        IngredientsType copy;
+        UpdaterReadBfmFileIndexed<IngredientsType> Rudi(filename, copy, UpdaterReadBfmFileIndexed<IngredientsType>::READ_NTH_CONFIG, k);
+        Rudi.initialize();
+        REQUIRE(copy.getMolecules().size() == nMonomers);
+        CHECK(copy.getMolecules().getAge() == 10*(k+1));
+        uint32_t mismatches(0);
+        for(uint32_t i=0; i<nMonomers; i++){
+            mismatches+=(VectorInt3(copy.getMolecules()[i]) != frames[k][i]);
+        }
+        CHECK(mismatches == 0);
+        CHECK(copy.getMolecules().areConnected(0,1));
+    }
+
+    IngredientsType last;
+    UpdaterReadBfmFileIndexed<IngredientsType> Rudi(filename, last, UpdaterReadBfmFileIndexed<IngredientsType>::READ_LAST_CONFIG);
+    Rudi.initialize();
+    REQUIRE(last.getMolecules().size() == nMonomers);
+    CHECK(VectorInt3(last.getMolecules()[nMonomers-1]) == frames[5][nMonomers-1]);
+
+    // concurrent readers of the same frame use temporary files of their own
+    std::vector<uint32_t> mismatches(32,0);
+    ThreadPool pool(8);
+    pool.run(mismatches.size(), [&](uint32_t t){
+        IngredientsType copy;
+        UpdaterReadBfmFileIndexed<IngredientsType>::readFrame(Ivan, 3, copy);
+        for(uint32_t i=0; i<nMonomers; i++){
+            mismatches[t]+=(VectorInt3(copy.getMolecules()[i]) != frames[3][i]);
+        }
+    });
+    for(uint32_t t=0; t<mismatches.size(); t++){
+        CHECK(mismatches[t] == 0);
+    }
+
+    std::remove(filename.c_str());
+    std::remove(BfmFrameIndex::getIndexFilename(filename).c_str());
+}
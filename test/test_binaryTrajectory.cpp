@@ -0,0 +1,346 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "AnalyzerWriteBinaryTrajectory.h"
+#include "UpdaterReadBinaryTrajectory.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+namespace{
+  //! shift the chain as a whole and advance the age, bonds stay the same
+  void shiftChain(IngredientsType& ing, int32_t n)
+  {
+    for(uint32_t i=0; i<ing.getMolecules().size(); i++){
+      const VectorInt3 pos(ing.getMolecules()[i]);
+      ing.modifyMolecules()[i].setAllCoordinates(pos.getX()+(n%2),pos.getY()+((n+1)%2),pos.getZ());
+    }
+    ing.modifyMolecules().setAge(ing.getMolecules().getAge()+100);
+  }
+
+  //! copy of filename without its last nBytes bytes
+  void copyTruncated(const std::string& filename, const std::string& copy, size_t nBytes)
+  {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    std::vector<char> content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::ofstream out(copy.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(&content[0], content.size()-nBytes);
+  }
+}
+
+TEST_CASE( "BinaryTrajectory_BondVectorCode" ) {
+    BondVectorCode code;
+    BondMoveTable classic;
+    CHECK(code.getNumberOfCodes() == 108);
+
+    uint32_t nMismatches(0);
+    for(int32_t x=-4; x<=4; x++){
+        for(int32_t y=-4; y<=4; y++){
+            for(int32_t z=-4; z<=4; z++){
+                const VectorInt3 bond(x,y,z);
+                const uint8_t c(code.encode(bond));
+                if(classic.isClassicBond(bond)){
+                    nMismatches+=(c >= 108 || code.decode(c) != bond);
+                }else{
+                    nMismatches+=(c != BondVectorCode::escapeCode);
+                }
+            }
+        }
+    }
+    CHECK(nMismatches == 0);
+
+    // the numbering is part of the file format
+    CHECK(code.decode(0) == VectorInt3(-3,-1,0));
+    CHECK(code.encode(VectorInt3(2,0,0)) < 108);
+    CHECK(code.encode(VectorInt3(100,0,0)) == uint8_t(BondVectorCode::escapeCode));
+}
+
+TEST_CASE( "BinaryTrajectory_Codec" ) {
+    BinaryTrajectoryCodec codec;
+
+    // two chains far apart, the jump between them is stored as escape
+    Molecules molecules;
+    molecules.addMonomer(10,10,10);
+    molecules.addMonomer(12,10,10);
+    molecules.addMonomer(12,13,11);
+    molecules.addMonomer(-500,70000,3);
+    molecules.addMonomer(-498,70001,5);
+
+    std::vector<char> raw;
+    codec.encode(molecules, raw);
+    CHECK(raw.size() == 12+4+12);
+
+    std::vector<VectorInt3> positions;
+    codec.decode(&raw[0], raw.size(), 5, positions);
+    REQUIRE(positions.size() == 5);
+    for(uint32_t i=0; i<5; i++){
+        CHECK(positions[i] == VectorInt3(molecules[i]));
+    }
+
+    CHECK_THROWS(codec.decode(&raw[0], raw.size()-1, 5, positions));
+    CHECK_THROWS(codec.decode(&raw[0], raw.size(), 4, positions));
+    raw[12]=char(110);
+    CHECK_THROWS(codec.decode(&raw[0], raw.size(), 5, positions));
+}
+
+TEST_CASE( "BinaryTrajectory_WriteRead" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+    const uint32_t nMonomers(ingredients.getMolecules().size());
+
+    std::remove("test_binary.btr");
+    std::vector< std::vector<VectorInt3> > frames;
+
+    AnalyzerWriteBinaryTrajectory<IngredientsType> Willy("test_binary.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE, false);
+    Willy.initialize();
+    for(int32_t n=0; n<20; n++){
+        shiftChain(ingredients, n);
+        Willy.execute();
+        frames.push_back(std::vector<VectorInt3>(nMonomers));
+        for(uint32_t i=0; i<nMonomers; i++){
+            frames.back()[i]=ingredients.getMolecules()[i];
+        }
+    }
+    Willy.cleanup();
+    CHECK(Willy.getWriter().getNumberOfFrames() == 20);
+
+    // one byte per monomer behind the first, non classic bonds take 12 bytes more
+    BondMoveTable classic;
+    uint64_t nEscapes(0);
+    for(uint32_t i=1; i<nMonomers; i++){
+        nEscapes+=!classic.isClassicBond(frames[0][i]-frames[0][i-1]);
+    }
+    CHECK(Willy.getWriter().getRawBytes() == 20*(12+(nMonomers-1)+12*nEscapes));
+
+    SECTION("read with index"){
+        BinaryTrajectoryReader Rita;
+        Rita.open("test_binary.btr");
+        CHECK(Rita.hasIndex());
+        CHECK(Rita.getStructure().nMonomers == nMonomers);
+        REQUIRE(Rita.getNumberOfFrames() == 20);
+
+        std::vector<VectorInt3> positions;
+        for(uint64_t n=20; n-- > 0; ){
+            Rita.readFrame(n, positions);
+            CHECK(positions == frames[n]);
+            CHECK(Rita.getMcs(n) == 100*(n+1));
+        }
+    }
+
+    SECTION("rebuild the index of a killed run"){
+        copyTruncated("test_binary.btr", "test_binary_killed.btr", 20*16+24+5);
+        BinaryTrajectoryReader Rita;
+        Rita.open("test_binary_killed.btr");
+        CHECK(!Rita.hasIndex());
+        REQUIRE(Rita.getNumberOfFrames() == 19);
+
+        std::vector<VectorInt3> positions;
+        Rita.readFrame(18, positions);
+        CHECK(positions == frames[18]);
+        CHECK(Rita.getMcs(18) == 1900);
+
+        // appending continues behind the last complete frame
+        AnalyzerWriteBinaryTrajectory<IngredientsType> Wanda("test_binary_killed.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::APPEND, false);
+        Wanda.initialize();
+        Wanda.execute();
+        Wanda.cleanup();
+
+        Rita.open("test_binary_killed.btr");
+        CHECK(Rita.hasIndex());
+        REQUIRE(Rita.getNumberOfFrames() == 20);
+        Rita.readFrame(19, positions);
+        CHECK(positions == frames[19]);
+        std::remove("test_binary_killed.btr");
+    }
+
+    SECTION("append"){
+        AnalyzerWriteBinaryTrajectory<IngredientsType> Wanda("test_binary.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::APPEND, false);
+        Wanda.initialize();
+        shiftChain(ingredients, 20);
+        Wanda.execute();
+        Wanda.cleanup();
+        CHECK(Wanda.getWriter().getNumberOfFrames() == 21);
+
+        BinaryTrajectoryReader Rita;
+        Rita.open("test_binary.btr");
+        CHECK(Rita.hasIndex());
+        REQUIRE(Rita.getNumberOfFrames() == 21);
+        CHECK(Rita.getMcs(20) == 2100);
+
+        std::vector<VectorInt3> positions;
+        Rita.readFrame(3, positions);
+        CHECK(positions == frames[3]);
+
+        // a system of a different size cannot be appended
+        IngredientsType other;
+        other.modifyMolecules().addMonomer(0,0,0);
+        AnalyzerWriteBinaryTrajectory<IngredientsType> Wrong("test_binary.btr", other, AnalyzerWriteBinaryTrajectory<IngredientsType>::APPEND, false);
+        CHECK_THROWS(Wrong.initialize());
+
+        // neither can a system of a different box or bonds
+        BinaryTrajectoryStructure structure(AnalyzerWriteBinaryTrajectory<IngredientsType>::getStructure(ingredients));
+        CHECK(structure.difference(Rita.getStructure()).empty());
+        BinaryTrajectoryStructure changed(structure);
+        changed.box[2]++;
+        CHECK(changed.difference(structure) == "box");
+        changed=structure;
+        changed.periodic[0]=!changed.periodic[0];
+        CHECK(changed.difference(structure) == "periodicity");
+        changed=structure;
+        changed.bonds[1]=changed.bonds[0];
+        CHECK(changed.difference(structure) == "bonds");
+        changed=structure;
+        changed.movable[0]=!changed.movable[0];
+        CHECK(changed.difference(structure) == "movable tags");
+
+        ingredients.setBoxZ(ingredients.getBoxZ()*2);
+        AnalyzerWriteBinaryTrajectory<IngredientsType> Wider("test_binary.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::APPEND, false);
+        CHECK_THROWS(Wider.initialize());
+        ingredients.setBoxZ(ingredients.getBoxZ()/2);
+    }
+
+    std::remove("test_binary.btr");
+}
+
+TEST_CASE( "BinaryTrajectory_Compression" ) {
+    // a chain with a repeated bond pattern compresses well
+    IngredientsType ingredients;
+    ingredients.setBoxX(16);
+    ingredients.setBoxY(16);
+    ingredients.setBoxZ(256);
+    for(uint32_t i=0; i<64; i++){
+        ingredients.modifyMolecules().addMonomer(2*(i%4),0,2+2*(i/4));
+    }
+
+    if(!BinaryTrajectoryCodec::isCompressionAvailable()){
+        CHECK_THROWS(AnalyzerWriteBinaryTrajectory<IngredientsType>("test_binary_z.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE, true));
+        return;
+    }
+
+    AnalyzerWriteBinaryTrajectory<IngredientsType> Willy("test_binary_z.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE, true);
+    Willy.initialize();
+    Willy.execute();
+    Willy.cleanup();
+    CHECK(Willy.getWriter().getStoredBytes() < Willy.getWriter().getRawBytes());
+
+    BinaryTrajectoryReader Rita;
+    Rita.open("test_binary_z.btr");
+    std::vector<VectorInt3> positions;
+    Rita.readFrame(0, positions);
+    for(uint32_t i=0; i<positions.size(); i++){
+        CHECK(positions[i] == VectorInt3(ingredients.getMolecules()[i]));
+    }
+
+    std::remove("test_binary_z.btr");
+}
+
+TEST_CASE( "BinaryTrajectory_UpdaterRead" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+    ingredients.modifyMolecules()[3].setAttributeTag(7);
+
+    std::remove("test_binary_read.btr");
+    AnalyzerWriteBinaryTrajectory<IngredientsType> Willy("test_binary_read.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE, false);
+    Willy.initialize();
+    for(int32_t n=0; n<5; n++){
+        shiftChain(ingredients, n);
+        Willy.execute();
+    }
+    Willy.cleanup();
+
+    CHECK_THROWS(UpdaterReadBinaryTrajectory<IngredientsType>("test_binary_read.btr", ingredients, 5));
+
+    // the structure is restored from the header
+    IngredientsType copy;
+    UpdaterReadBinaryTrajectory<IngredientsType> Rudi("test_binary_read.btr", copy, UpdaterReadBinaryTrajectory<IngredientsType>::READ_STEPWISE);
+    Rudi.initialize();
+    CHECK(Rudi.getNumberOfFrames() == 5);
+    CHECK(copy.getBoxX() == ingredients.getBoxX());
+    CHECK(copy.getBoxZ() == ingredients.getBoxZ());
+    CHECK(copy.isPeriodicZ() == ingredients.isPeriodicZ());
+    CHECK(copy.getLowerZ() == ingredients.getLowerZ());
+    CHECK(copy.getUpperZ() == ingredients.getUpperZ());
+    REQUIRE(copy.getMolecules().size() == ingredients.getMolecules().size());
+    CHECK(copy.getMolecules()[3].getAttributeTag() == 7);
+    for(uint32_t i=0; i<copy.getMolecules().size(); i++){
+        CHECK(copy.getMolecules().getNumLinks(i) == ingredients.getMolecules().getNumLinks(i));
+        CHECK(copy.getMolecules()[i].getMovableTag() == ingredients.getMolecules()[i].getMovableTag());
+    }
+    CHECK(copy.getMolecules().getAge() == 100);
+
+    // stepwise through all frames
+    uint32_t nFrames(1);
+    while(Rudi.execute()){
+        nFrames++;
+    }
+    CHECK(nFrames == 5);
+    CHECK(copy.getMolecules().getAge() == ingredients.getMolecules().getAge());
+    for(uint32_t i=0; i<copy.getMolecules().size(); i++){
+        CHECK(copy.getMolecules()[i] == ingredients.getMolecules()[i]);
+    }
+
+    // the system has to be empty
+    UpdaterReadBinaryTrajectory<IngredientsType> Rosa("test_binary_read.btr", copy, UpdaterReadBinaryTrajectory<IngredientsType>::READ_LAST_CONFIG);
+    CHECK_THROWS(Rosa.initialize());
+
+    IngredientsType last;
+    UpdaterReadBinaryTrajectory<IngredientsType> Lisa("test_binary_read.btr", last, UpdaterReadBinaryTrajectory<IngredientsType>::READ_LAST_CONFIG);
+    Lisa.initialize();
+    CHECK(Lisa.getCurrentFrame() == 4);
+    CHECK(last.getMolecules().getAge() == 500);
+    CHECK(!Lisa.execute());
+
+    std::remove("test_binary_read.btr");
+}
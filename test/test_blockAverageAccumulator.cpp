@@ -0,0 +1,124 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <random>
+
+#include "BlockAverageAccumulator.h"
+
+TEST_CASE( "BlockAverageAccumulator_levels" ) {
+    BlockAverageAccumulator Bert(1);
+    CHECK(Bert.getNumberOfObservables() == 1);
+    CHECK(Bert.getNumberOfSamples() == 0);
+
+    // 0 1 2 ... 7 gives block averages 0.5 2.5 4.5 6.5, 1.5 5.5 and 3.5
+    for(uint32_t i=0; i<8; i++){
+        Bert.addSample(double(i));
+    }
+    REQUIRE(Bert.getNumberOfLevels() == 4);
+    CHECK(Bert.getNumberOfSamples() == 8);
+    CHECK(Bert.getNumberOfBlocks(0) == 8);
+    CHECK(Bert.getNumberOfBlocks(1) == 4);
+    CHECK(Bert.getNumberOfBlocks(2) == 2);
+    CHECK(Bert.getNumberOfBlocks(3) == 1);
+    CHECK(Bert.getMean(0) == Approx(3.5));
+
+    // sample variance of 0..7 is 6, of 0.5,2.5,4.5,6.5 is 20/3
+    CHECK(Bert.getCovarianceOfMean(0,0,0) == Approx(6.0/8.0));
+    CHECK(Bert.getCovarianceOfMean(1,0,0) == Approx(20.0/3.0/4.0));
+    CHECK(Bert.getCovarianceOfMean(3,0,0) == 0.0);
+}
+
+TEST_CASE( "BlockAverageAccumulator_constantSeries" ) {
+    BlockAverageAccumulator Carl(2);
+    double values[2]={1.0,0.0};
+    for(uint32_t i=0; i<100; i++){
+        Carl.addSample(values);
+    }
+    CHECK(Carl.getMean(0) == Approx(1.0));
+    CHECK(Carl.getMean(1) == Approx(0.0));
+    CHECK(Carl.getError(0) == Approx(0.0));
+    CHECK(Carl.isConverged(0));
+    CHECK(Carl.getCorrelationTime(1) == Approx(0.5));
+}
+
+TEST_CASE( "BlockAverageAccumulator_correlatedSeries" ) {
+    // AR(1) process x_t = phi x_{t-1} + noise with integrated autocorrelation time (1+phi)/(2(1-phi))
+    std::mt19937 generator(1234);
+    std::normal_distribution<double> noise(0.0,1.0);
+    const double phi(0.9);
+
+    BlockAverageAccumulator Dora(2);
+    double values[2]={0.0,0.0};
+    for(uint32_t i=0; i<(1<<20); i++){
+        values[0]=phi*values[0]+noise(generator);
+        values[1]=noise(generator);
+        Dora.addSample(values);
+    }
+
+    CHECK(Dora.getNumberOfSamples() == (1<<20));
+    CHECK(Dora.isConverged(0));
+    CHECK(Dora.isConverged(1));
+    CHECK(Dora.getCorrelationTime(0) == Approx(9.5).epsilon(0.2));
+    CHECK(Dora.getCorrelationTime(1) == Approx(0.5).epsilon(0.2));
+    CHECK(Dora.getError(0) > 3.0*Dora.getNaiveError(0));
+    CHECK(std::fabs(Dora.getMean(0)) < 5.0*Dora.getError(0));
+
+    // the two series are independent
+    const uint32_t l(Dora.getOptimalLevel(0));
+    CHECK(std::fabs(Dora.getCovarianceOfMean(l,0,1)) < 3.0*Dora.getErrorAtLevel(l,0)*Dora.getErrorAtLevel(l,1));
+}
+
+TEST_CASE( "BlockAverageAccumulator_merge" ) {
+    // the merged accumulator of two independent series of equal length behaves like one of double length
+    std::mt19937 generator(4321);
+    std::normal_distribution<double> noise(0.0,1.0);
+
+    BlockAverageAccumulator Emil, Fritz, Gustav;
+    for(uint32_t i=0; i<(1<<16); i++){
+        const double value(noise(generator));
+        Emil.addSample(value);
+        Gustav.addSample(value);
+    }
+    for(uint32_t i=0; i<(1<<16); i++){
+        const double value(noise(generator));
+        Fritz.addSample(value);
+        Gustav.addSample(value);
+    }
+
+    Emil.merge(Fritz);
+    CHECK(Emil.getNumberOfSamples() == (1<<17));
+    CHECK(Emil.getMean(0) == Approx(Gustav.getMean(0)));
+    CHECK(Emil.getNaiveError(0) == Approx(Gustav.getNaiveError(0)).epsilon(1e-3));
+    CHECK(Emil.getNumberOfBlocks(3) == Gustav.getNumberOfBlocks(3));
+    CHECK(Emil.getNumberOfLevels() == Gustav.getNumberOfLevels()-1);
+
+    BlockAverageAccumulator Hugo(2);
+    CHECK_THROWS(Emil.merge(Hugo));
+}
@@ -0,0 +1,155 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "BondMoveTable.h"
+#include "UpdaterSimulatorForceSampling.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+TEST_CASE( "BondMoveTable_masks" ) {
+    BondMoveTable table;
+    const VectorInt3 steps[6]={VectorInt3(1,0,0),VectorInt3(-1,0,0),VectorInt3(0,1,0),
+                               VectorInt3(0,-1,0),VectorInt3(0,0,1),VectorInt3(0,0,-1)};
+
+    for(int d=0; d<6; d++){
+        CHECK(BondMoveTable::getDirectionIndex(steps[d]) == uint32_t(d));
+    }
+
+    // the table agrees with the classic bondset built by LeMonADE
+    BondVectorSet bondset;
+    bondset.addBFMclassicBondset();
+
+    uint32_t nClassic(0), mismatches(0);
+    for(int32_t x=-6; x<=6; x++){
+        for(int32_t y=-6; y<=6; y++){
+            for(int32_t z=-6; z<=6; z++){
+                const VectorInt3 bond(x,y,z);
+                if(table.isClassicBond(bond)){
+                    nClassic++;
+                }
+                if(table.isClassicBond(bond) != bondset.isValidStrong(bond)){
+                    mismatches++;
+                }
+                for(int d=0; d<6; d++){
+                    const bool allowed((table.getMoveMask(bond) >> d) & 1);
+                    if(allowed != bondset.isValidStrong(bond-steps[d])){
+                        mismatches++;
+                    }
+                }
+            }
+        }
+    }
+    CHECK(nClassic == 108);
+    CHECK(mismatches == 0);
+
+    // (2,0,0) can not shrink to (1,0,0), i.e. the monomer can not jump +x
+    CHECK(table.getMoveMask(VectorInt3(2,0,0)) == 0x3E);
+    // (3,0,0) can not grow in +x direction of the bond, i.e. the monomer can not jump -x
+    CHECK(((table.getMoveMask(VectorInt3(3,0,0)) >> 1) & 1) == 0);
+    CHECK(((table.getMoveMask(VectorInt3(3,0,0)) >> 0) & 1) == 1);
+    CHECK(table.getMoveMask(VectorInt3(100,0,0)) == 0);
+}
+
+TEST_CASE( "BondMoveTable_allowedMoves" ) {
+    BondMoveTable table;
+    Molecules molecules;
+    molecules.addMonomer(0,0,0);
+    molecules.addMonomer(3,0,0);
+    molecules.addMonomer(3,0,2);
+    molecules.connect(0,1);
+    molecules.connect(1,2);
+
+    // monomer 0: only the bond (3,0,0)
+    CHECK(table.getAllowedMoves(molecules,0) == table.getMoveMask(VectorInt3(3,0,0)));
+    // monomer 1: bonds (-3,0,0) and (0,0,2)
+    CHECK(table.getAllowedMoves(molecules,1) == (table.getMoveMask(VectorInt3(-3,0,0)) & table.getMoveMask(VectorInt3(0,0,2))));
+    CHECK(((table.getAllowedMoves(molecules,1) >> 0) & 1) == 0);
+
+    molecules.addMonomer(10,10,10);
+    CHECK(table.getAllowedMoves(molecules,3) == BondMoveTable::allMoves());
+}
+
+TEST_CASE( "BondMoveTable_simulator" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    // straight chain with bonds (0,0,2) in a periodic box
+    IngredientsType ingredients;
+    ingredients.setBoxX(16);
+    ingredients.setBoxY(16);
+    ingredients.setBoxZ(32);
+    ingredients.setPeriodicX(true);
+    ingredients.setPeriodicY(true);
+    ingredients.setPeriodicZ(true);
+    ingredients.modifyBondset().addBFMclassicBondset();
+    for(int32_t i=0; i<16; i++){
+        ingredients.modifyMolecules().addMonomer(0,0,2*i);
+        if(i>0){
+            ingredients.modifyMolecules().connect(i-1,i);
+        }
+    }
+    ingredients.synchronize();
+
+    UpdaterSimulatorForceSampling<IngredientsType> Simon(ingredients, 200, std::vector<uint32_t>(1,8));
+    Simon.setVerbose(false);
+    Simon.initialize();
+    CHECK(Simon.getUseBondMoveTable());
+    Simon.execute();
+
+    // all bonds are still classic
+    BondMoveTable table;
+    uint32_t invalidBonds(0);
+    for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+        for(uint32_t n=0; n<ingredients.getMolecules().getNumLinks(i); n++){
+            const VectorInt3 bond(ingredients.getMolecules()[ingredients.getMolecules().getNeighborIdx(i,n)]-ingredients.getMolecules()[i]);
+            if(!table.isClassicBond(bond)){
+                invalidBonds++;
+            }
+        }
+    }
+    CHECK(invalidBonds == 0);
+
+    // a different bondset switches the early rejection off
+    ingredients.modifyBondset().addBondVector(4,0,0,200);
+    Simon.initialize();
+    CHECK(!Simon.getUseBondMoveTable());
+}
@@ -0,0 +1,374 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+#include <LeMonADE/utility/TaskManager.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "Checkpoint.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "UpdaterSimulatorForceSampling.h"
+#include "UpdaterCheckpoint.h"
+#include "AnalyzerForce.h"
+#include "AnalyzerWriteBinaryTrajectory.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+namespace{
+  //! chain created from the default seed, so every call gives the same configuration
+  void createChain(IngredientsType& ing)
+  {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedDefaultValuesAll();
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ing, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+  }
+
+  //! counters of a run compared between the uninterrupted and the resumed runs
+  struct RunResult
+  {
+    uint64_t tries;
+    std::vector<uint64_t> plus;
+    std::vector<uint64_t> minus;
+    std::vector<uint64_t> attemptsPlus;
+  };
+
+  /**
+  * one run of a TaskManager: checkpoint (if filename is set), simulator, force analyzer
+  * every 2nd and trajectory writer every 3rd cycle, so the tasks are in phase every 6th
+  * cycle; the signal is raised after signalCycle cycles if it is set
+  */
+  RunResult runTasks(IngredientsType& ing, const std::string& filename, const std::string& trajectory, uint64_t seed, uint32_t signalCycle)
+  {
+    std::vector<uint32_t> selection {10};
+    TaskManager taskmanager;
+
+    UpdaterSimulatorForceSampling<IngredientsType>* simulator(new UpdaterSimulatorForceSampling<IngredientsType>(ing, 1, selection));
+    simulator->setSeed(seed);
+    AnalyzerForce<IngredientsType>* force(new AnalyzerForce<IngredientsType>(ing, selection, 0));
+    force->setFilename("test_checkpoint_phase_force.dat");
+
+    if(!filename.empty()){
+      UpdaterCheckpoint<IngredientsType>* checkpoint(new UpdaterCheckpoint<IngredientsType>(ing, filename, 12, 60, 6));
+      checkpoint->addComponent(simulator);
+      checkpoint->addComponent(force);
+      checkpoint->addTrajectory(trajectory);
+      taskmanager.addUpdater(checkpoint);
+    }
+    taskmanager.addUpdater(simulator);
+    taskmanager.addAnalyzer(force, 2);
+    taskmanager.addAnalyzer(new AnalyzerWriteBinaryTrajectory<IngredientsType>(trajectory, ing, AnalyzerWriteBinaryTrajectory<IngredientsType>::APPEND, false), 3);
+
+    taskmanager.initialize();
+    if(signalCycle > 0){
+      taskmanager.run(signalCycle);
+      checkpointSignalHandler(SIGTERM);
+    }
+    taskmanager.run(60);
+    taskmanager.cleanup();
+    checkpointSignalFlag()=0;
+
+    RunResult result;
+    result.tries=force->getCounterTries();
+    result.plus=force->getCounterPlus();
+    result.minus=force->getCounterMinus();
+    result.attemptsPlus=simulator->getAttemptsPlus();
+    return result;
+  }
+
+  void copyFile(const std::string& source, const std::string& destination)
+  {
+    std::ifstream in(source.c_str(), std::ios::binary);
+    std::ofstream out(destination.c_str(), std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+  }
+
+  //! true if both binary trajectories hold the same frames
+  bool isSameTrajectory(const std::string& first, const std::string& second)
+  {
+    BinaryTrajectoryReader a, b;
+    a.open(first);
+    b.open(second);
+    if(a.getNumberOfFrames() != b.getNumberOfFrames()){
+      return false;
+    }
+    std::vector<VectorInt3> positionsA, positionsB;
+    for(uint64_t n=0; n<a.getNumberOfFrames(); n++){
+      a.readFrame(n, positionsA);
+      b.readFrame(n, positionsB);
+      if(a.getMcs(n) != b.getMcs(n) || positionsA != positionsB){
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+TEST_CASE( "Checkpoint_writeRead" ) {
+    CheckpointWriter writer;
+    writer.write(uint32_t(42));
+    writer.write(-1.5);
+    writer.writeVector(std::vector<uint64_t> {1,2,3});
+    writer.writeString("tanglotron");
+
+    CheckpointReader reader(writer.getBuffer());
+    uint32_t number(0);
+    double value(0.0);
+    std::vector<uint64_t> values;
+    std::string name;
+    reader.read(number);
+    reader.read(value);
+    reader.readVector(values);
+    reader.readString(name);
+
+    CHECK(number == 42);
+    CHECK(value == -1.5);
+    CHECK(values == std::vector<uint64_t> {1,2,3});
+    CHECK(name == "tanglotron");
+    CHECK(reader.isAtEnd());
+    CHECK_THROWS(reader.read(number));
+
+    // truncated buffer
+    std::vector<char> truncated(writer.getBuffer().begin(), writer.getBuffer().begin()+14);
+    CheckpointReader truncatedReader(truncated);
+    truncatedReader.read(number);
+    truncatedReader.read(value);
+    CHECK_THROWS(truncatedReader.readVector(values));
+
+    // file
+    writer.writeFile("test_checkpoint_io.chk");
+    CheckpointReader fileReader;
+    CHECK(fileReader.readFile("test_checkpoint_io.chk"));
+    fileReader.read(number);
+    CHECK(number == 42);
+    CHECK(fileReader.readFile("test_checkpoint_missing.chk") == false);
+    std::remove("test_checkpoint_io.chk");
+}
+
+TEST_CASE( "Checkpoint_blockAverageAccumulator" ) {
+    BlockAverageAccumulator Anna(2), Berta(2), Carla(3);
+    for(uint32_t n=0; n<100; n++){
+        const double sample[2]={ double(n%7), double(n%3) };
+        Anna.addSample(sample);
+    }
+
+    CheckpointWriter writer;
+    Anna.saveState(writer);
+    CheckpointReader reader(writer.getBuffer());
+    Berta.loadState(reader);
+    CHECK(reader.isAtEnd());
+
+    CHECK(Berta.getNumberOfSamples() == Anna.getNumberOfSamples());
+    CHECK(Berta.getNumberOfLevels() == Anna.getNumberOfLevels());
+    CHECK(Berta.getMean(0) == Anna.getMean(0));
+    CHECK(Berta.getError(1) == Anna.getError(1));
+
+    // both continue identically
+    const double sample[2]={ 1.0, 2.0 };
+    Anna.addSample(sample);
+    Berta.addSample(sample);
+    CHECK(Berta.getCovarianceOfMean(1,0,1) == Anna.getCovarianceOfMean(1,0,1));
+
+    CheckpointReader wrongReader(writer.getBuffer());
+    CHECK_THROWS(Carla.loadState(wrongReader));
+}
+
+TEST_CASE( "UpdaterCheckpoint_resume" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    const std::string filename("test_checkpoint_resume.chk");
+    std::remove(filename.c_str());
+
+    std::vector<uint32_t> selection {10};
+
+    // uninterrupted run writing a checkpoint after 60 mcs
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    UpdaterSimulatorForceSampling<IngredientsType> Simon(ingredients, 1, selection);
+    AnalyzerForce<IngredientsType> Anna(ingredients, selection, 0);
+    UpdaterCheckpoint<IngredientsType> Charly(ingredients, filename, 60, 100);
+    Charly.addComponent(&Simon);
+    Charly.addComponent(&Anna);
+    Simon.setSeed(42);
+    Simon.initialize();
+    Anna.initialize();
+    Charly.initialize();
+
+    uint32_t n(0);
+    while(Charly.execute()){
+        Simon.execute();
+        Anna.execute();
+        n++;
+    }
+    CHECK(n == 100);
+    CHECK(Charly.isRestored() == false);
+    CHECK(Charly.getEndAge() == 100);
+    CHECK(ingredients.getMolecules().getAge() == 100);
+
+    // resumed run from the same start configuration with another seed
+    IngredientsType resumed;
+    UpdaterCreateChainInSlit<IngredientsType> Secundus(resumed, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Secundus.initialize();
+
+    UpdaterSimulatorForceSampling<IngredientsType> Sam(resumed, 1, selection);
+    AnalyzerForce<IngredientsType> Berta(resumed, selection, 0);
+    UpdaterCheckpoint<IngredientsType> Chris(resumed, filename, 0, 100);
+    Chris.addComponent(&Sam);
+    Chris.addComponent(&Berta);
+    Sam.setSeed(7);
+    Sam.initialize();
+    Berta.initialize();
+    Chris.initialize();
+
+    n=0;
+    while(Chris.execute()){
+        Sam.execute();
+        Berta.execute();
+        n++;
+    }
+    CHECK(Chris.isRestored() == true);
+    CHECK(n == 40);
+    CHECK(resumed.getMolecules().getAge() == 100);
+
+    // bit-for-bit the same state
+    for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+        CHECK(resumed.getMolecules()[i] == ingredients.getMolecules()[i]);
+    }
+    CHECK(Berta.getCounterTries() == Anna.getCounterTries());
+    CHECK(Berta.getCounterPlus() == Anna.getCounterPlus());
+    CHECK(Berta.getCounterMinus() == Anna.getCounterMinus());
+    CHECK(Berta.getProbeStatistics(0).getNumberOfLevels() == Anna.getProbeStatistics(0).getNumberOfLevels());
+    CHECK(Berta.getProbeStatistics(0).getCovarianceOfMean(0,0,1) == Anna.getProbeStatistics(0).getCovarianceOfMean(0,0,1));
+    CHECK(Sam.getAttemptsPlus() == Simon.getAttemptsPlus());
+    CHECK(Sam.getCounterMinus() == Simon.getCounterMinus());
+
+    // a checkpoint of another selection is rejected
+    AnalyzerForce<IngredientsType> Carla(resumed, std::vector<uint32_t> {5}, 0);
+    UpdaterCheckpoint<IngredientsType> Chuck(resumed, filename, 0, 100);
+    Chuck.addComponent(&Sam);
+    Chuck.addComponent(&Carla);
+    CHECK_THROWS(Chuck.execute());
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "UpdaterCheckpoint_signal" ) {
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 4, 8, 16, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0);
+    Primus.initialize();
+
+    const std::string filename("test_checkpoint_signal.chk");
+    std::remove(filename.c_str());
+
+    UpdaterCheckpoint<IngredientsType> Charly(ingredients, filename, 0, 0);
+    Charly.initialize();
+    CHECK(Charly.execute() == true);
+    CHECK(Charly.getEndAge() == 0);
+
+    checkpointSignalHandler(SIGTERM);
+    CHECK(Charly.execute() == false);
+    CHECK(Charly.isInterrupted() == true);
+    checkpointSignalFlag()=0;
+
+    // the checkpoint is written on the way out
+    Charly.cleanup();
+    CheckpointReader reader;
+    CHECK(reader.readFile(filename));
+    std::remove(filename.c_str());
+}
+
+TEST_CASE( "UpdaterCheckpoint_phase" ) {
+    const std::string filename("test_checkpoint_phase.chk");
+    const std::string early("test_checkpoint_phase_early.chk");
+    const std::string reference("test_checkpoint_phase_reference.btr");
+    const std::string trajectory("test_checkpoint_phase.btr");
+    std::remove(filename.c_str());
+    std::remove(reference.c_str());
+    std::remove(trajectory.c_str());
+
+    // the save interval has to be a multiple of the phase period
+    IngredientsType ingredients;
+    CHECK_THROWS(UpdaterCheckpoint<IngredientsType>(ingredients, filename, 10, 60, 6));
+
+    // uninterrupted run of 60 cycles
+    createChain(ingredients);
+    const RunResult uninterrupted(runTasks(ingredients, "", reference, 42, 0));
+    CHECK(ingredients.getMolecules().getAge() == 60);
+
+    // the signal after 25 cycles stops the run at the next cycle in phase, cycle 30
+    IngredientsType interrupted;
+    createChain(interrupted);
+    runTasks(interrupted, filename, trajectory, 42, 25);
+    CHECK(interrupted.getMolecules().getAge() == 30);
+    copyFile(filename, early);
+
+    // resumed with another seed
+    IngredientsType resumed;
+    createChain(resumed);
+    const RunResult resumedResult(runTasks(resumed, filename, trajectory, 7, 0));
+    CHECK(resumed.getMolecules().getAge() == 60);
+    for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+        CHECK(resumed.getMolecules()[i] == ingredients.getMolecules()[i]);
+    }
+    CHECK(resumedResult.tries == uninterrupted.tries);
+    CHECK(resumedResult.plus == uninterrupted.plus);
+    CHECK(resumedResult.minus == uninterrupted.minus);
+    CHECK(resumedResult.attemptsPlus == uninterrupted.attemptsPlus);
+    CHECK(isSameTrajectory(trajectory, reference));
+
+    // a restart from the checkpoint at mcs 30 removes the frames written behind it
+    copyFile(early, filename);
+    IngredientsType restarted;
+    createChain(restarted);
+    const RunResult restartedResult(runTasks(restarted, filename, trajectory, 7, 0));
+    CHECK(restartedResult.tries == uninterrupted.tries);
+    CHECK(isSameTrajectory(trajectory, reference));
+
+    std::remove(filename.c_str());
+    std::remove(early.c_str());
+    std::remove(reference.c_str());
+    std::remove(trajectory.c_str());
+    std::remove("test_checkpoint_phase_force.dat");
+}
@@ -0,0 +1,162 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureLatticeBitPacked.h"
+#include "FeatureLatticeSlit.h"
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "LatticeProbeComparison.h"
+#include "ForceProbeKernel.h"
+#include "ForceProbeView.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticeBitPacked >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticeSlit <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) FeaturesSlit;
+typedef ConfigureSystem<VectorInt3,FeaturesSlit,4> ConfigSlit;
+typedef Ingredients<ConfigSlit> IngredientsTypeSlit;
+
+namespace {
+//! face check by four lattice reads as reference
+bool isFaceFreeReference(const FeatureLatticeBitPacked& lattice, const VectorInt3& pos, const VectorInt3& dir)
+{
+    const VectorInt3 perp1( (dir.getX()==0) ? 1 : 0, (dir.getX()!=0) ? 1 : 0, 0);
+    const VectorInt3 perp2( 0, (dir.getZ()==0) ? 0 : 1, (dir.getZ()==0) ? 1 : 0);
+    VectorInt3 face(pos+dir);
+    if(dir.getX()>0 || dir.getY()>0 || dir.getZ()>0){
+        face+=dir;
+    }
+    return !( lattice.getLatticeEntry(face) || lattice.getLatticeEntry(face+perp1) ||
+              lattice.getLatticeEntry(face+perp2) || lattice.getLatticeEntry(face+perp1+perp2) );
+}
+}
+
+TEST_CASE( "FeatureLatticeBitPacked_sites" ) {
+    FeatureLatticeBitPacked lattice;
+    lattice.setupLattice(512,512,64,false);
+    CHECK(lattice.getNumberOfWords() == 512*512);
+
+    lattice.setupLattice(8,4,130,false);
+    CHECK(lattice.getNumberOfWords() == 8*4*3);
+
+    lattice.setLatticeEntry(VectorInt3(1,2,64),true);
+    lattice.setLatticeEntry(VectorInt3(1,2,63),true);
+    CHECK(lattice.getLatticeEntry(VectorInt3(1,2,64)));
+    CHECK(lattice.getLatticeEntry(1,2,63));
+    CHECK(!lattice.getLatticeEntry(1,2,62));
+    CHECK(!lattice.getLatticeEntry(1,2,65));
+    // folding in x and y
+    CHECK(lattice.getLatticeEntry(VectorInt3(9,-2,64)));
+    // no folding in z
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,-66)));
+    CHECK_THROWS_AS(lattice.setLatticeEntry(VectorInt3(1,2,130),true), std::runtime_error);
+
+    lattice.setLatticeEntry(VectorInt3(1,2,63),false);
+    CHECK(!lattice.getLatticeEntry(1,2,63));
+    CHECK(lattice.getLatticeEntry(1,2,64));
+
+    lattice.moveOnLattice(VectorInt3(1,2,64),VectorInt3(0,0,129));
+    CHECK(!lattice.getLatticeEntry(1,2,64));
+    CHECK(lattice.getLatticeEntry(0,0,129));
+
+    lattice.clearLattice();
+    CHECK(!lattice.getLatticeEntry(0,0,129));
+
+    lattice.setupLattice(4,4,5,true);
+    lattice.setLatticeEntry(VectorInt3(0,0,-1),true);
+    CHECK(lattice.getLatticeEntry(VectorInt3(4,4,4)));
+
+    CHECK_THROWS_AS(lattice.setupLattice(6,4,5,false), std::runtime_error);
+    CHECK_THROWS_AS(lattice.setupLattice(4,4,0,false), std::runtime_error);
+}
+
+TEST_CASE( "FeatureLatticeBitPacked_faceCheck" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    const VectorInt3 directions[6]={VectorInt3(1,0,0),VectorInt3(-1,0,0),VectorInt3(0,1,0),
+                                    VectorInt3(0,-1,0),VectorInt3(0,0,1),VectorInt3(0,0,-1)};
+
+    uint32_t mismatches(0);
+    for(int periodic=0; periodic<2; periodic++){
+        FeatureLatticeBitPacked lattice;
+        lattice.setupLattice(8,8,130,periodic==1);
+
+        // sparse random occupation
+        for(uint32_t n=0; n<800; n++){
+            lattice.setLatticeEntry(VectorInt3(randomNumbers.r250_rand32()%8, randomNumbers.r250_rand32()%8, randomNumbers.r250_rand32()%130), true);
+        }
+
+        // all cube positions including the word boundaries and the box boundaries in z
+        for(int32_t x=-1; x<9; x++){
+            for(int32_t y=-1; y<9; y++){
+                for(int32_t z=-2; z<131; z++){
+                    for(int d=0; d<6; d++){
+                        if(lattice.isFaceFree(VectorInt3(x,y,z),directions[d]) !=
+                           isFaceFreeReference(lattice,VectorInt3(x,y,z),directions[d])){
+                            mismatches++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE( "FeatureLatticeBitPacked_forceProbe" ) {
+    CHECK(HasFaceCheck<IngredientsType>::value);
+    CHECK(HasFaceCheck< ForceProbeView<IngredientsType> >::value);
+    CHECK(!HasFaceCheck<IngredientsTypeSlit>::value);
+    CHECK(!HasFaceCheck< ForceProbeView<IngredientsTypeSlit> >::value);
+
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0, bool compactBox_=false);
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 9, 16, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0, true);
+    Primus.initialize();
+    REQUIRE(ingredients.getBoxZ() == 9);
+
+    // the face check of the lattice gives the same results as a copy of the system
+    compareLatticeProbeWithCopy(ingredients, allMonomers(ingredients), 20, 20);
+}
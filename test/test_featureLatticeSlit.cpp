@@ -0,0 +1,125 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureLatticeSlit.h"
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "LatticeProbeComparison.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticeSlit <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+//! checks that all monomers stay inside of the non-periodic slit of 17 planes
+struct CheckInsideSlit
+{
+    template<class IngredientsType>
+    void operator()(const IngredientsType& ingredients) const
+    {
+        for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+            REQUIRE(ingredients.getMolecules()[i].getZ() >= 0);
+            REQUIRE(ingredients.getMolecules()[i].getZ() <= 15);
+        }
+    }
+};
+
+TEST_CASE( "FeatureLatticeSlit_nonPeriodic" ) {
+    FeatureLatticeSlit<bool> lattice;
+    lattice.setupLattice(8,16,17,false);
+    CHECK(lattice.getLatticeSize() == 8*16*17);
+
+    lattice.setLatticeEntry(VectorInt3(1,2,16),true);
+    CHECK(lattice.getLatticeEntry(VectorInt3(1,2,16)));
+    CHECK(lattice.getLatticeEntry(1,2,16));
+    // folding in x and y
+    CHECK(lattice.getLatticeEntry(VectorInt3(9,-14,16)));
+    // no folding in z
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,-1)));
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,33)));
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,17)));
+    CHECK_THROWS_AS(lattice.setLatticeEntry(VectorInt3(1,2,17),true), std::runtime_error);
+    CHECK_THROWS_AS(lattice.setLatticeEntry(VectorInt3(1,2,-1),true), std::runtime_error);
+
+    lattice.moveOnLattice(VectorInt3(1,2,16),VectorInt3(1,2,0));
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,16)));
+    CHECK(lattice.getLatticeEntry(VectorInt3(1,2,0)));
+
+    lattice.clearLattice();
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,0)));
+
+    CHECK_THROWS_AS(lattice.setupLattice(12,16,17,false), std::runtime_error);
+    CHECK_THROWS_AS(lattice.setupLattice(16,12,17,false), std::runtime_error);
+    CHECK_THROWS_AS(lattice.setupLattice(16,16,0,false), std::runtime_error);
+}
+
+TEST_CASE( "FeatureLatticeSlit_periodic" ) {
+    FeatureLatticeSlit<uint8_t> lattice;
+    lattice.setupLattice(4,4,5,true);
+
+    lattice.setLatticeEntry(VectorInt3(0,0,4),3);
+    CHECK(lattice.getLatticeEntry(VectorInt3(0,0,-1)) == 3);
+    CHECK(lattice.getLatticeEntry(VectorInt3(0,0,9)) == 3);
+    CHECK(lattice.getLatticeEntry(VectorInt3(4,-4,-11)) == 3);
+    CHECK(lattice.getLatticeEntry(VectorInt3(0,0,5)) == 0);
+
+    lattice.setLatticeEntry(VectorInt3(0,0,-5),7);
+    CHECK(lattice.getLatticeEntry(VectorInt3(0,0,0)) == 7);
+}
+
+TEST_CASE( "FeatureLatticeSlit_compactChainInSlit" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0, bool compactBox_=false);
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 20, 17, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0, true);
+    Primus.initialize();
+
+    CHECK(ingredients.getBoxZ() == 17);
+    CHECK(ingredients.getWalls().empty());
+    CHECK(!ingredients.isPeriodicZ());
+    CHECK(ingredients.getMolecules().size() == 20);
+    CHECK(ingredients.getMolecules()[0].getMovableTag() == false);
+    CHECK(ingredients.getMolecules()[19].getMovableTag() == false);
+    CHECK(ingredients.getMolecules()[19].getZ() == 15);
+
+    // the copy of the system used by PROBE_INCREMENTAL_COPY is periodic in z
+    CHECK(compareLatticeProbeWithCopy(ingredients, std::vector<uint32_t>(1,10), 100, 10, CheckInsideSlit()) == 11);
+}
@@ -0,0 +1,155 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <map>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureLatticeSparse.h"
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "LatticeProbeComparison.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticeSparse<bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+TEST_CASE( "FeatureLatticeSparse_sites" ) {
+    FeatureLatticeSparse<bool> lattice;
+    lattice.setupLattice(100,30,17,false);
+    CHECK(lattice.getNumberOfEntries() == 0);
+
+    lattice.setLatticeEntry(VectorInt3(1,2,16),true);
+    CHECK(lattice.getNumberOfEntries() == 1);
+    CHECK(lattice.getLatticeEntry(VectorInt3(1,2,16)));
+    CHECK(lattice.getLatticeEntry(1,2,16));
+    // periodic folding in x and y for any box size
+    CHECK(lattice.getLatticeEntry(VectorInt3(101,-28,16)));
+    CHECK(lattice.getLatticeEntry(VectorInt3(-199,62,16)));
+    // no folding in z
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,-1)));
+    CHECK(!lattice.getLatticeEntry(VectorInt3(1,2,33)));
+    CHECK_THROWS_AS(lattice.setLatticeEntry(VectorInt3(1,2,17),true), std::runtime_error);
+
+    // setting a site to false removes it
+    lattice.setLatticeEntry(VectorInt3(1,2,16),false);
+    CHECK(lattice.getNumberOfEntries() == 0);
+    lattice.setLatticeEntry(VectorInt3(5,5,5),false);
+    CHECK(lattice.getNumberOfEntries() == 0);
+
+    lattice.setLatticeEntry(VectorInt3(1,2,3),true);
+    lattice.moveOnLattice(VectorInt3(1,2,3),VectorInt3(1,2,4));
+    CHECK(!lattice.getLatticeEntry(1,2,3));
+    CHECK(lattice.getLatticeEntry(1,2,4));
+    CHECK(lattice.getNumberOfEntries() == 1);
+
+    lattice.clearLattice();
+    CHECK(lattice.getNumberOfEntries() == 0);
+    CHECK(!lattice.getLatticeEntry(1,2,4));
+
+    lattice.setupLattice(7,7,7,true);
+    lattice.setLatticeEntry(VectorInt3(-1,-1,-1),true);
+    CHECK(lattice.getLatticeEntry(6,6,6));
+    CHECK(lattice.getLatticeEntry(13,-8,20));
+
+    CHECK_THROWS_AS(lattice.setupLattice(0,16,16,false), std::runtime_error);
+    CHECK_THROWS_AS(lattice.setupLattice(16,16,(1u<<21)+1,false), std::runtime_error);
+}
+
+TEST_CASE( "FeatureLatticeSparse_randomAccess" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    // huge box, the table only grows with the number of entries
+    FeatureLatticeSparse<uint8_t> lattice;
+    lattice.setupLattice(4096,4096,4096,true);
+
+    // reference with the same folding into a small region to force collisions and removals
+    std::map<uint64_t,uint8_t> reference;
+    uint32_t mismatches(0);
+    for(uint32_t n=0; n<200000; n++){
+        const int32_t x(randomNumbers.r250_rand32()%64);
+        const int32_t y(randomNumbers.r250_rand32()%64);
+        const int32_t z(randomNumbers.r250_rand32()%16);
+        const uint8_t value( (randomNumbers.r250_rand32()%3==0) ? 0 : 1+randomNumbers.r250_rand32()%5 );
+        const uint64_t key(uint64_t(x)+64*(uint64_t(y)+64*uint64_t(z)));
+
+        lattice.setLatticeEntry(VectorInt3(x,y,z),value);
+        if(value==0){
+            reference.erase(key);
+        }else{
+            reference[key]=value;
+        }
+
+        const int32_t xr(randomNumbers.r250_rand32()%64);
+        const int32_t yr(randomNumbers.r250_rand32()%64);
+        const int32_t zr(randomNumbers.r250_rand32()%16);
+        std::map<uint64_t,uint8_t>::const_iterator it(reference.find(uint64_t(xr)+64*(uint64_t(yr)+64*uint64_t(zr))));
+        if(lattice.getLatticeEntry(xr,yr,zr) != ((it==reference.end()) ? 0 : it->second)){
+            mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(lattice.getNumberOfEntries() == reference.size());
+
+    // all stored entries are found
+    for(std::map<uint64_t,uint8_t>::const_iterator it=reference.begin(); it!=reference.end(); ++it){
+        const int32_t x(it->first%64), y((it->first/64)%64), z(it->first/4096);
+        if(lattice.getLatticeEntry(x+4096,y-4096,z+4096) != it->second){
+            mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+    CHECK(lattice.getCapacity() <= 4*64*64*16);
+}
+
+TEST_CASE( "FeatureLatticeSparse_chainInHugeBox" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0, bool compactBox_=false);
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 32, 1000, 8192, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0, true);
+    Primus.initialize();
+    REQUIRE(ingredients.getMolecules().size() == 32);
+    CHECK(ingredients.getNumberOfEntries() == 8*32);
+    CHECK(ingredients.getCapacity() <= 1024);
+
+    compareLatticeProbeWithCopy(ingredients, allMonomers(ingredients), 50, 10);
+    CHECK(ingredients.getNumberOfEntries() == 8*32);
+}
@@ -0,0 +1,136 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureLatticeTiled.h"
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "LatticeProbeComparison.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticeTiled<bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+// lattice of the executables built with TANGLOTRON_TILED_LATTICE, one cache line per tile
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticeTiled<uint8_t> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) FeaturesByte;
+typedef ConfigureSystem<VectorInt3,FeaturesByte,4> ConfigByte;
+typedef Ingredients<ConfigByte> IngredientsTypeByte;
+
+TEST_CASE( "FeatureLatticeTiled_layout" ) {
+    FeatureLatticeTiled<uint32_t> lattice;
+    lattice.setupLattice(16,8,13,false);
+    // z is padded to 16
+    CHECK(lattice.getLatticeSize() == 16*8*16);
+
+    // every site has its own storage index
+    uint32_t value(1), mismatches(0);
+    for(int32_t z=0; z<13; z++){
+        for(int32_t y=0; y<8; y++){
+            for(int32_t x=0; x<16; x++){
+                lattice.setLatticeEntry(VectorInt3(x,y,z),value++);
+            }
+        }
+    }
+    value=1;
+    for(int32_t z=0; z<13; z++){
+        for(int32_t y=0; y<8; y++){
+            for(int32_t x=0; x<16; x++){
+                if(lattice.getLatticeEntry(x,y,z) != value++){
+                    mismatches++;
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    // the sites of one tile are contiguous
+    CHECK(lattice.getStorageIndex(0,0,0) == 0);
+    CHECK(lattice.getStorageIndex(3,3,3) == 63);
+    CHECK(lattice.getStorageIndex(4,0,0) == 64);
+    CHECK(lattice.getStorageIndex(0,4,0) == 4*64);
+    CHECK(lattice.getStorageIndex(0,0,4) == 8*64);
+
+    // folding
+    CHECK(lattice.getLatticeEntry(17,-8,0) == lattice.getLatticeEntry(1,0,0));
+    CHECK(lattice.getLatticeEntry(0,0,13) == 0);
+    CHECK(lattice.getLatticeEntry(0,0,-1) == 0);
+    CHECK_THROWS_AS(lattice.setLatticeEntry(VectorInt3(0,0,13),1), std::runtime_error);
+
+    lattice.moveOnLattice(VectorInt3(1,0,0),VectorInt3(2,7,12));
+    CHECK(lattice.getLatticeEntry(1,0,0) == 0);
+    CHECK(lattice.getLatticeEntry(2,7,12) == 2);
+
+    lattice.setupLattice(4,4,6,true);
+    lattice.setLatticeEntry(VectorInt3(-1,-1,-1),5);
+    CHECK(lattice.getLatticeEntry(3,3,5) == 5);
+    CHECK(lattice.getLatticeEntry(7,-5,11) == 5);
+
+    lattice.clearLattice();
+    CHECK(lattice.getLatticeEntry(3,3,5) == 0);
+
+    CHECK_THROWS_AS(lattice.setupLattice(2,16,16,false), std::runtime_error);
+    CHECK_THROWS_AS(lattice.setupLattice(16,12,16,false), std::runtime_error);
+    CHECK_THROWS_AS(lattice.setupLattice(16,16,0,false), std::runtime_error);
+}
+
+TEST_CASE( "FeatureLatticeTiled_forceProbe" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0, bool compactBox_=false);
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 11, 16, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0, true);
+    Primus.initialize();
+    REQUIRE(ingredients.getBoxZ() == 11);
+
+    compareLatticeProbeWithCopy(ingredients, allMonomers(ingredients), 20, 20);
+}
+
+TEST_CASE( "FeatureLatticeTiled_forceProbeByte" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsTypeByte ingredients;
+
+    UpdaterCreateChainInSlit<IngredientsTypeByte> Primus(ingredients, 16, 11, 16, UpdaterCreateChainInSlit<IngredientsTypeByte>::SINGLE_FIXPOINT_BOTTOM, 0, true);
+    Primus.initialize();
+    REQUIRE(ingredients.getBoxZ() == 11);
+
+    compareLatticeProbeWithCopy(ingredients, allMonomers(ingredients), 20, 20);
+}
@@ -0,0 +1,229 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
+#include <LeMonADE/updater/UpdaterReadBfmFile.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) WallFeatures;
+typedef ConfigureSystem<VectorInt3,WallFeatures,4> WallConfig;
+typedef Ingredients<WallConfig> WallIngredientsType;
+
+TEST_CASE( "FeatureSlitConfinement_bounds" ) {
+    FeatureSlitConfinement slit;
+    CHECK(!slit.hasLowerBound());
+    CHECK(!slit.hasUpperBound());
+    CHECK(slit.getWalls().empty());
+    CHECK(slit.isInside(-1000000));
+    CHECK(slit.isInside(1000000));
+
+    slit.setSlit(0,6);
+    CHECK(slit.hasLowerBound());
+    CHECK(slit.hasUpperBound());
+    CHECK(!slit.isInside(-1));
+    CHECK(slit.isInside(0));
+    CHECK(slit.isInside(4));
+    CHECK(!slit.isInside(5));
+
+    CHECK_THROWS_AS(slit.setSlit(3,4), std::runtime_error);
+    CHECK(slit.getLowerZ()==0);
+    CHECK(slit.getUpperZ()==6);
+
+    slit.clearSlit();
+    CHECK(!slit.hasLowerBound());
+    CHECK(!slit.hasUpperBound());
+}
+
+TEST_CASE( "FeatureSlitConfinement_walls" ) {
+    FeatureSlitConfinement slit;
+
+    Wall top;
+    top.setBase(0,0,14);
+    top.setNormal(0,0,1);
+    slit.addWall(top);
+    CHECK(!slit.hasLowerBound());
+    CHECK(slit.getUpperZ()==14);
+    CHECK(slit.isInside(12));
+    CHECK(!slit.isInside(13));
+
+    Wall bottom;
+    bottom.setBase(0,0,3);
+    bottom.setNormal(0,0,-1);
+    slit.addWall(bottom);
+    CHECK(slit.getLowerZ()==4);
+    CHECK(!slit.isInside(3));
+    CHECK(slit.isInside(4));
+
+    // a looser bound does not widen the slit
+    top.setBase(0,0,20);
+    slit.addWall(top);
+    CHECK(slit.getUpperZ()==14);
+
+    // the walls reproduce the slit
+    REQUIRE(slit.getWalls().size()==2);
+    FeatureSlitConfinement copy;
+    for(size_t w=0; w<slit.getWalls().size(); w++){
+        copy.addWall(slit.getWalls()[w]);
+    }
+    CHECK(copy.getLowerZ()==4);
+    CHECK(copy.getUpperZ()==14);
+
+    Wall side;
+    side.setBase(3,0,0);
+    side.setNormal(1,0,0);
+    CHECK_THROWS_AS(slit.addWall(side), std::runtime_error);
+
+    bottom.setBase(0,0,12);
+    CHECK_THROWS_AS(slit.addWall(bottom), std::runtime_error);
+    CHECK(slit.getLowerZ()==4);
+}
+
+TEST_CASE( "FeatureSlitConfinement_moves" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0);
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 1, 5, 16, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0);
+    Primus.initialize();
+    ingredients.modifyMolecules()[0].setMovableTag(true);
+    ingredients.synchronize();
+
+    REQUIRE(ingredients.getBoxZ()==8);
+    REQUIRE(ingredients.getWalls().size()==1);
+    CHECK(ingredients.getUpperZ()==5);
+
+    // the monomer cube may move up to z=3, the cube at z=4 would touch the wall
+    MoveLocalSc move;
+    for(int32_t z=1; z<=3; z++){
+        move.init(ingredients,0,VectorInt3(0,0,1));
+        CHECK(move.check(ingredients));
+        move.apply(ingredients);
+    }
+    CHECK(ingredients.getMolecules()[0].getZ()==3);
+    move.init(ingredients,0,VectorInt3(0,0,1));
+    CHECK(!move.check(ingredients));
+
+    // moves in xy are not affected
+    move.init(ingredients,0,VectorInt3(1,0,0));
+    CHECK(move.check(ingredients));
+    move.init(ingredients,0,VectorInt3(0,-1,0));
+    CHECK(move.check(ingredients));
+
+    // adding a monomer
+    MoveAddMonomerSc<int32_t> addMove;
+    addMove.init();
+    addMove.setPosition(VectorInt3(4,4,4));
+    CHECK(!addMove.check(ingredients));
+    addMove.setPosition(VectorInt3(4,4,3));
+    CHECK(addMove.check(ingredients));
+}
+
+TEST_CASE( "FeatureSlitConfinement_io" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    const std::string filename("test_slitconfinement_io.bfm");
+
+    SECTION("files written with FeatureWall"){
+        // a slit which is no power of two is stored as !add_wall by FeatureWall
+        WallIngredientsType walled;
+        UpdaterCreateChainInSlit<WallIngredientsType> Primus(walled, 16, 14, 16, UpdaterCreateChainInSlit<WallIngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+        Primus.initialize();
+        Wall bottom;
+        bottom.setBase(0,0,-1);
+        bottom.setNormal(0,0,-1);
+        walled.addWall(bottom);
+        REQUIRE(walled.getWalls().size()==2);
+
+        AnalyzerWriteBfmFile<WallIngredientsType> Walter(filename, walled, AnalyzerWriteBfmFile<WallIngredientsType>::NEWFILE);
+        Walter.initialize();
+        Walter.execute();
+
+        IngredientsType ingredients;
+        UpdaterReadBfmFile<IngredientsType> Rudi(filename, ingredients, UpdaterReadBfmFile<IngredientsType>::READ_LAST_CONFIG_SAVE);
+        Rudi.initialize();
+        CHECK(ingredients.getLowerZ()==0);
+        CHECK(ingredients.getUpperZ()==14);
+        REQUIRE(ingredients.getMolecules().size()==walled.getMolecules().size());
+        for(uint32_t n=0; n<ingredients.getMolecules().size(); n++){
+            CHECK(ingredients.getMolecules()[n].getVector3D()==walled.getMolecules()[n].getVector3D());
+        }
+    }
+
+    SECTION("files written with FeatureSlitConfinement"){
+        IngredientsType ingredients;
+        UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+        Primus.initialize();
+        ingredients.setSlit(-3,14);
+
+        AnalyzerWriteBfmFile<IngredientsType> Walter(filename, ingredients, AnalyzerWriteBfmFile<IngredientsType>::NEWFILE);
+        Walter.initialize();
+        Walter.execute();
+
+        IngredientsType copy;
+        UpdaterReadBfmFile<IngredientsType> Rudi(filename, copy, UpdaterReadBfmFile<IngredientsType>::READ_LAST_CONFIG_SAVE);
+        Rudi.initialize();
+        CHECK(copy.getLowerZ()==-3);
+        CHECK(copy.getUpperZ()==14);
+    }
+
+    SECTION("walls which are no slit"){
+        std::ofstream file(filename.c_str());
+        file << "!number_of_monomers=1\n!box_x=16\n!box_y=16\n!box_z=16\n\n!add_wall\nb(4,0,0) n(1,0,0)\n\n!mcs=0\n0 0 0\n\n";
+        file.close();
+
+        IngredientsType ingredients;
+        UpdaterReadBfmFile<IngredientsType> Rudi(filename, ingredients, UpdaterReadBfmFile<IngredientsType>::READ_LAST_CONFIG_SAVE);
+        CHECK_THROWS_AS(Rudi.initialize(), std::runtime_error);
+    }
+
+    std::remove(filename.c_str());
+}
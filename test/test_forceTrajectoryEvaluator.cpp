@@ -0,0 +1,176 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "UpdaterSimulatorForceSampling.h"
+#include "AnalyzerWriteBinaryTrajectory.h"
+#include "ForceTrajectoryEvaluator.h"
+#include "BfmTrajectory.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+// the frames of bfm files are parsed without lattice
+typedef LOKI_TYPELIST_4(FeatureMoleculesIO, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) ReadFeatures;
+typedef ConfigureSystem<VectorInt3,ReadFeatures,4> ReadConfig;
+typedef Ingredients<ReadConfig> ReadIngredientsType;
+
+TEST_CASE( "ForceTrajectoryEvaluator_run" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    // simulate a trajectory and probe the force on the fly as reference
+    std::vector<uint32_t> selection {3,8,12};
+    UpdaterSimulatorForceSampling<IngredientsType> simulator(ingredients, 2, std::vector<uint32_t>());
+    simulator.setSeed(7);
+    simulator.setVerbose(false);
+    simulator.initialize();
+
+    AnalyzerWriteBinaryTrajectory<IngredientsType> writer("test_evaluator.btr", ingredients, AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE);
+    writer.initialize();
+    std::remove("test_evaluator.bfm");
+    std::remove(BfmFrameIndex::getIndexFilename("test_evaluator.bfm").c_str());
+    AnalyzerWriteBfmFile<IngredientsType> bfmWriter("test_evaluator.bfm", ingredients, AnalyzerWriteBfmFile<IngredientsType>::APPEND);
+    bfmWriter.initialize();
+    AnalyzerForce<IngredientsType> reference(ingredients, selection, 0);
+    AnalyzerForce<IngredientsType> referenceEvery(ingredients, selection, 0);
+    for(uint32_t n=0; n<40; n++){
+        simulator.execute();
+        writer.execute();
+        bfmWriter.execute();
+        if(n == 0){
+            reference.initialize();
+        }else{
+            reference.execute();
+        }
+        if(n == 1){
+            referenceEvery.initialize();
+        }else if(n > 1 && (n-1)%3 == 0){
+            referenceEvery.execute();
+        }
+    }
+    writer.cleanup();
+    bfmWriter.cleanup();
+
+    MappedBinaryTrajectory trajectory("test_evaluator.btr");
+    REQUIRE(trajectory.getNumberOfFrames() == 40);
+
+    CHECK_THROWS(ForceTrajectoryEvaluator<IngredientsType>(trajectory, selection, 0));
+    CHECK_THROWS(ForceTrajectoryEvaluator<IngredientsType>(trajectory, std::vector<uint32_t>(1,16), 7));
+
+    ForceTrajectoryEvaluator<IngredientsType> Eva(trajectory, selection, 7);
+    ForceTrajectoryEvaluator<IngredientsType> Emma(trajectory, selection, 7);
+    Eva.setFilename("test_evaluator_force.dat");
+    CHECK_THROWS(Eva.getMergedForce());
+
+    Eva.run(1);
+    Emma.run(3);
+    CHECK(Eva.getNumberOfEvaluatedFrames() == 40);
+    CHECK(Eva.getNumberOfChunks() == 6);
+    CHECK(Eva.getIngredients().getMolecules().getAge() == ingredients.getMolecules().getAge());
+
+    // the lattice of the chunks is updated incrementally, the counters equal the ones on the fly
+    const AnalyzerForce<IngredientsType>& merged(Eva.getMergedForce());
+    CHECK(merged.getCounterTries() == 40);
+    CHECK(merged.getCounterPlus() == reference.getCounterPlus());
+    CHECK(merged.getCounterMinus() == reference.getCounterMinus());
+    CHECK(merged.getFilename() == "test_evaluator_force.dat");
+
+    // the result does not depend on the number of threads
+    CHECK(Emma.getMergedForce().getCounterPlus() == merged.getCounterPlus());
+    CHECK(Emma.getMergedForce().getCounterMinus() == merged.getCounterMinus());
+    for(uint32_t i=0; i<selection.size(); i++){
+        CHECK(Emma.getMergedForce().getProbeStatistics(i).getCovarianceOfMean(1,0,1) == merged.getProbeStatistics(i).getCovarianceOfMean(1,0,1));
+        CHECK(Emma.getMergedForce().getProbeStatistics(i).getNumberOfSamples() == 40);
+    }
+
+    // the probes of the chunks are replayed in frame order, so the blocking analysis
+    // equals the serial one on the fly and does not depend on the chunk size
+    ForceTrajectoryEvaluator<IngredientsType> Finn(trajectory, selection, 3);
+    Finn.run(2);
+    CHECK(Finn.getNumberOfChunks() == 14);
+    for(uint32_t i=0; i<selection.size(); i++){
+        const BlockAverageAccumulator& serial(reference.getProbeStatistics(i));
+        for(const AnalyzerForce<IngredientsType>* force : { &merged, &(Finn.getMergedForce()) }){
+            const BlockAverageAccumulator& statistics(force->getProbeStatistics(i));
+            REQUIRE(statistics.getNumberOfLevels() == serial.getNumberOfLevels());
+            for(uint32_t l=0; l<serial.getNumberOfLevels(); l++){
+                CHECK(statistics.getNumberOfBlocks(l) == serial.getNumberOfBlocks(l));
+                CHECK(statistics.getCovarianceOfMean(l,0,1) == Approx(serial.getCovarianceOfMean(l,0,1)));
+                CHECK(statistics.getCovarianceOfMean(l,1,1) == Approx(serial.getCovarianceOfMean(l,1,1)));
+            }
+        }
+    }
+
+    // every third frame starting at frame 1
+    Emma.run(2, 1, 3);
+    CHECK(Emma.getNumberOfEvaluatedFrames() == 13);
+    CHECK(Emma.getNumberOfChunks() == 2);
+    CHECK(Emma.getMergedForce().getCounterPlus() == referenceEvery.getCounterPlus());
+    CHECK(Emma.getMergedForce().getCounterMinus() == referenceEvery.getCounterMinus());
+    CHECK_THROWS(Emma.run(2, 0, 0));
+
+    // the frames of the bfm file are read through its index and give the same counters
+    BfmTrajectory<ReadIngredientsType> bfmTrajectory("test_evaluator.bfm");
+    REQUIRE(bfmTrajectory.getNumberOfFrames() == 40);
+    CHECK(bfmTrajectory.getStructure().bonds == trajectory.getStructure().bonds);
+    ForceTrajectoryEvaluator<IngredientsType, BfmTrajectory<ReadIngredientsType> > Bea(bfmTrajectory, selection, 7);
+    Bea.run(3);
+    CHECK(Bea.getNumberOfChunks() == 6);
+    CHECK(Bea.getIngredients().getMolecules().getAge() == ingredients.getMolecules().getAge());
+    CHECK(Bea.getMergedForce().getCounterTries() == 40);
+    CHECK(Bea.getMergedForce().getCounterPlus() == reference.getCounterPlus());
+    CHECK(Bea.getMergedForce().getCounterMinus() == reference.getCounterMinus());
+
+    trajectory.close();
+    std::remove("test_evaluator.btr");
+    std::remove("test_evaluator.bfm");
+    std::remove(BfmFrameIndex::getIndexFilename("test_evaluator.bfm").c_str());
+}
@@ -0,0 +1,268 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/analyzer/AnalyzerWriteBfmFile.h>
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "FeatureSlitConfinement.h"
+#include "UpdaterCreateChainInSlit.h"
+#include "AnalyzerWriteBinaryTrajectory.h"
+#include "UpdaterReadBinaryTrajectory.h"
+#include "MappedBinaryTrajectory.h"
+#include "UpdaterReadBfmFileIndexed.h"
+#include "BfmFrameIndex.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureSlitConfinement, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+namespace{
+  //! write nFrames frames of a chain moving in x and y
+  void writeTrajectory(IngredientsType& ing, const std::string& filename, uint32_t nFrames, bool compression)
+  {
+    AnalyzerWriteBinaryTrajectory<IngredientsType> writer(filename, ing, AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE, compression);
+    writer.initialize();
+    for(uint32_t n=0; n<nFrames; n++){
+      for(uint32_t i=0; i<ing.getMolecules().size(); i++){
+        const VectorInt3 pos(ing.getMolecules()[i]);
+        ing.modifyMolecules()[i].setAllCoordinates(pos.getX()+(n%2),pos.getY()+((n+1)%2),pos.getZ());
+      }
+      ing.modifyMolecules().setAge(ing.getMolecules().getAge()+10);
+      writer.execute();
+    }
+    writer.cleanup();
+  }
+}
+
+TEST_CASE( "MappedBinaryTrajectory_frames" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    const bool compression(BinaryTrajectoryCodec::isCompressionAvailable());
+    writeTrajectory(ingredients, "test_mapped.btr", 30, compression);
+
+    MappedBinaryTrajectory Mia("test_mapped.btr");
+    CHECK(Mia.isOpen());
+    CHECK(Mia.hasIndex());
+    CHECK(Mia.getStructure().nMonomers == ingredients.getMolecules().size());
+    REQUIRE(Mia.getNumberOfFrames() == 30);
+    CHECK(Mia.end()-Mia.begin() == 30);
+
+    // the mapped frames equal the frames of the stream reader
+    BinaryTrajectoryReader Rita;
+    Rita.open("test_mapped.btr");
+    std::vector<VectorInt3> expected;
+
+    BinaryTrajectoryFrameDecoder decoder;
+    const VectorInt3* buffer(0);
+    uint64_t n(0), nMismatches(0), nReallocations(0);
+    for(MappedBinaryTrajectory::const_iterator it=Mia.begin(); it!=Mia.end(); ++it, ++n){
+        const MappedBinaryTrajectory::FrameView frame(*it);
+        CHECK(frame.getIndex() == n);
+        CHECK(frame.getMcs() == 10*(n+1));
+
+        const std::vector<VectorInt3>& positions(decoder.decode(frame, Mia.getStructure().nMonomers));
+        Rita.readFrame(n, expected);
+        nMismatches+=(positions != expected);
+
+        // the decoder reuses its buffer
+        nReallocations+=(buffer != 0 && buffer != positions.data());
+        buffer=positions.data();
+    }
+    CHECK(n == 30);
+    CHECK(nMismatches == 0);
+    CHECK(nReallocations == 0);
+
+    // frames as input of a system with the structure of the trajectory
+    IngredientsType copy;
+    UpdaterReadBinaryTrajectory<IngredientsType>::createSystem(Mia.getStructure(), copy);
+    decoder.apply(Mia.getFrame(29), copy.modifyMolecules());
+    copy.synchronize();
+    CHECK(copy.getMolecules().getAge() == ingredients.getMolecules().getAge());
+    for(uint32_t i=0; i<copy.getMolecules().size(); i++){
+        CHECK(copy.getMolecules()[i] == ingredients.getMolecules()[i]);
+        CHECK(copy.getMolecules().getNumLinks(i) == ingredients.getMolecules().getNumLinks(i));
+    }
+    CHECK(copy.getUpperZ() == ingredients.getUpperZ());
+
+    // random access through the iterator
+    CHECK((*(Mia.begin()+7)).getMcs() == 80);
+    CHECK(Mia.begin()[12].getMcs() == 130);
+    CHECK_THROWS(Mia.getFrame(30));
+
+    Mia.close();
+    CHECK(!Mia.isOpen());
+    CHECK(Mia.getNumberOfFrames() == 0);
+
+    std::remove("test_mapped.btr");
+}
+
+TEST_CASE( "MappedBinaryTrajectory_withoutIndex" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    writeTrajectory(ingredients, "test_mapped_raw.btr", 8, false);
+
+    // cut off the index and half of the last frame
+    std::vector<char> content;
+    {
+        std::ifstream in("test_mapped_raw.btr", std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        std::ofstream out("test_mapped_cut.btr", std::ios::binary | std::ios::trunc);
+        out.write(content.data(), content.size()-8*16-24-10);
+    }
+
+    MappedBinaryTrajectory Mia("test_mapped_cut.btr");
+    CHECK(!Mia.hasIndex());
+    REQUIRE(Mia.getNumberOfFrames() == 7);
+    CHECK(Mia.getFrame(6).getMcs() == 70);
+    CHECK(!Mia.getFrame(6).isCompressed());
+
+    BinaryTrajectoryFrameDecoder decoder;
+    BinaryTrajectoryReader Rita;
+    Rita.open("test_mapped_raw.btr");
+    std::vector<VectorInt3> expected;
+    Rita.readFrame(6, expected);
+    CHECK(decoder.decode(Mia.getFrame(6), Mia.getStructure().nMonomers) == expected);
+
+    // a file which is not a binary trajectory
+    {
+        std::ofstream out("test_mapped_text.btr", std::ios::trunc);
+        out << "!number_of_monomers=16\n!box_x=16\n";
+    }
+    CHECK_THROWS(Mia.open("test_mapped_text.btr"));
+    CHECK(!Mia.isOpen());
+    CHECK_THROWS(MappedBinaryTrajectory("test_mapped_missing.btr"));
+
+    // an index with offsets out of order is rebuilt by both readers
+    {
+        std::vector<char> damaged(content);
+        const size_t entries(damaged.size()-24-8*16);
+        std::memcpy(&damaged[entries+16], &damaged[entries], sizeof(uint64_t));
+        std::ofstream out("test_mapped_damaged.btr", std::ios::binary | std::ios::trunc);
+        out.write(damaged.data(), damaged.size());
+    }
+    Mia.open("test_mapped_damaged.btr");
+    CHECK(!Mia.hasIndex());
+    CHECK(Mia.getNumberOfFrames() == 8);
+    Rita.open("test_mapped_damaged.btr");
+    CHECK(!Rita.hasIndex());
+    CHECK(Rita.getNumberOfFrames() == 8);
+    CHECK(Rita.getFrameOffset(1) == Mia.getFrame(1).getData()-Mia.getFrame(0).getData()+Rita.getFrameOffset(0));
+
+    std::remove("test_mapped_raw.btr");
+    std::remove("test_mapped_cut.btr");
+    std::remove("test_mapped_text.btr");
+    std::remove("test_mapped_damaged.btr");
+}
+
+TEST_CASE( "MappedBinaryTrajectory_fromBfm" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    const std::string bfmFilename("test_mapped_source.bfm");
+    std::remove(bfmFilename.c_str());
+    std::remove(BfmFrameIndex::getIndexFilename(bfmFilename).c_str());
+
+    std::vector< std::vector<VectorInt3> > frames;
+    AnalyzerWriteBfmFile<IngredientsType> Bert(bfmFilename, ingredients, AnalyzerWriteBfmFile<IngredientsType>::APPEND);
+    Bert.initialize();
+    for(uint32_t n=0; n<5; n++){
+        std::vector<VectorInt3> positions;
+        for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+            const VectorInt3 pos(ingredients.getMolecules()[i]);
+            ingredients.modifyMolecules()[i].setAllCoordinates(pos.getX()+1,pos.getY()+(n%2),pos.getZ());
+            positions.push_back(VectorInt3(ingredients.getMolecules()[i]));
+        }
+        frames.push_back(positions);
+        ingredients.modifyMolecules().setAge(ingredients.getMolecules().getAge()+10);
+        Bert.execute();
+    }
+    Bert.cleanup();
+
+    // convert as convertBinaryTrajectory does: the first frame sets up the system,
+    // the following frames only set the positions
+    BfmFrameIndex Ivan(bfmFilename);
+    Ivan.update();
+    REQUIRE(Ivan.getNumberOfFrames() == 5);
+    IngredientsType converted;
+    UpdaterReadBfmFileIndexed<IngredientsType>::readFrame(Ivan, 0, converted);
+    REQUIRE(converted.getMolecules().size() == ingredients.getMolecules().size());
+    AnalyzerWriteBinaryTrajectory<IngredientsType> Willy("test_mapped_converted.btr", converted, AnalyzerWriteBinaryTrajectory<IngredientsType>::NEWFILE, false);
+    Willy.initialize();
+    Willy.execute();
+    for(uint64_t n=1; n<Ivan.getNumberOfFrames(); n++){
+        UpdaterReadBfmFileIndexed<IngredientsType>::readFrame(Ivan, n, converted);
+        Willy.execute();
+    }
+    Willy.cleanup();
+
+    MappedBinaryTrajectory Mia("test_mapped_converted.btr");
+    const BinaryTrajectoryStructure expected(AnalyzerWriteBinaryTrajectory<IngredientsType>::getStructure(ingredients));
+    CHECK(Mia.getStructure().nMonomers == expected.nMonomers);
+    CHECK(std::equal(expected.box, expected.box+3, Mia.getStructure().box));
+    CHECK(Mia.getStructure().bonds == expected.bonds);
+    REQUIRE(Mia.getNumberOfFrames() == 5);
+    BinaryTrajectoryFrameDecoder decoder;
+    for(MappedBinaryTrajectory::const_iterator it=Mia.begin(); it!=Mia.end(); ++it){
+        CHECK((*it).getMcs() == 10*((*it).getIndex()+1));
+        CHECK(decoder.decode(*it, Mia.getStructure().nMonomers) == frames[(*it).getIndex()]);
+    }
+
+    std::remove(bfmFilename.c_str());
+    std::remove(BfmFrameIndex::getIndexFilename(bfmFilename).c_str());
+    std::remove("test_mapped_converted.btr");
+}
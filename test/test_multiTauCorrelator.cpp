@@ -0,0 +1,162 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "MultiTauCorrelator.h"
+
+TEST_CASE( "MultiTauCorrelator_constructor" ) {
+    MultiTauCorrelator Tom(3,16,2);
+    CHECK(Tom.getDimension() == 3);
+    CHECK(Tom.getPointsPerLevel() == 16);
+    CHECK(Tom.getAveraging() == 2);
+    CHECK(Tom.getNumberOfSamples() == 0);
+    CHECK(Tom.getNumberOfLevels() == 0);
+    CHECK(Tom.getIntegratedTime() == 0.0);
+
+    CHECK_THROWS_AS(MultiTauCorrelator(0), std::runtime_error);
+    CHECK_THROWS_AS(MultiTauCorrelator(1,16,1), std::runtime_error);
+    CHECK_THROWS_AS(MultiTauCorrelator(1,15,2), std::runtime_error);
+}
+
+TEST_CASE( "MultiTauCorrelator_firstLevel" ) {
+    // the lags below pointsPerLevel are correlated exactly
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> uniform(-1.0,1.0);
+    std::vector<double> series(12);
+    MultiTauCorrelator Tim(1,8,2);
+    for(uint32_t t=0; t<series.size(); t++){
+        series[t]=uniform(generator);
+        Tim.addSample(series[t]);
+    }
+    CHECK(Tim.getNumberOfSamples() == 12);
+
+    double mean(0.0), meanSquares(0.0);
+    for(uint32_t t=0; t<series.size(); t++){
+        mean+=series[t]/12.0;
+        meanSquares+=series[t]*series[t]/12.0;
+    }
+    CHECK(Tim.getMean(0) == Approx(mean));
+    CHECK(Tim.getVariance() == Approx(meanSquares-mean*mean));
+
+    std::vector<uint64_t> lags;
+    std::vector<double> correlation;
+    Tim.getCorrelation(lags,correlation);
+    REQUIRE(lags.size() >= 8);
+    CHECK(correlation[0] == Approx(1.0));
+    for(uint32_t j=0; j<8; j++){
+        REQUIRE(lags[j] == j);
+        double product(0.0);
+        for(uint32_t t=j; t<series.size(); t++){
+            product+=series[t]*series[t-j];
+        }
+        product/=double(series.size()-j);
+        CHECK(correlation[j] == Approx((product-mean*mean)/(meanSquares-mean*mean)));
+    }
+
+    // lags of the higher levels are multiples of their block length
+    for(uint32_t n=8; n<lags.size(); n++){
+        CHECK(lags[n] > lags[n-1]);
+        CHECK(lags[n] % 2 == 0);
+    }
+}
+
+TEST_CASE( "MultiTauCorrelator_levels" ) {
+    // a constant series has no fluctuations to correlate
+    MultiTauCorrelator Tara(1,16,2);
+    for(uint32_t t=0; t<(1<<16); t++){
+        Tara.addSample(1.0);
+    }
+    CHECK(Tara.getMean(0) == Approx(1.0));
+    CHECK(Tara.getIntegratedTime() == 0.0);
+
+    // memory grows with the logarithm of the number of samples, level l holds 2^(16-l) blocks
+    CHECK(Tara.getNumberOfLevels() == 17);
+    std::vector<uint64_t> lags;
+    std::vector<double> correlation;
+    Tara.getCorrelation(lags,correlation);
+    // levels with at least 16 blocks reach the lags 8 to 15 in their block length
+    CHECK(lags.size() == 16+12*8);
+    CHECK(lags.back() == 15*(uint64_t(1)<<12));
+
+    // the number of levels is limited
+    MultiTauCorrelator Tess(1,4,2,3);
+    for(uint32_t t=0; t<1000; t++){
+        Tess.addSample(double(t % 7));
+    }
+    CHECK(Tess.getNumberOfLevels() == 3);
+
+    Tess.clear();
+    CHECK(Tess.getNumberOfSamples() == 0);
+    CHECK(Tess.getNumberOfLevels() == 0);
+}
+
+TEST_CASE( "MultiTauCorrelator_correlatedSeries" ) {
+    // AR(1) process x_t = phi x_{t-1} + noise with C(t)=phi^t and integrated time (1+phi)/(2(1-phi))
+    std::mt19937 generator(1234);
+    std::normal_distribution<double> noise(0.0,1.0);
+    const double phi(0.9);
+
+    MultiTauCorrelator Theo(1);
+    MultiTauCorrelator Vera(3);
+    double x(0.0);
+    double vector[3]={0.0,0.0,0.0};
+    for(uint32_t t=0; t<(1<<20); t++){
+        x=phi*x+noise(generator);
+        Theo.addSample(x+5.0);
+        for(uint32_t k=0; k<3; k++){
+            vector[k]=phi*vector[k]+noise(generator);
+        }
+        Vera.addSample(vector);
+    }
+    CHECK(Theo.getMean(0) == Approx(5.0).epsilon(0.01));
+    CHECK(Theo.getNumberOfLevels() <= 21);
+
+    std::vector<uint64_t> lags;
+    std::vector<double> correlation;
+    Theo.getCorrelation(lags,correlation);
+    CHECK(correlation[1] == Approx(phi).epsilon(0.01));
+    CHECK(correlation[10] == Approx(std::pow(phi,10)).epsilon(0.05));
+    CHECK(Theo.getIntegratedTime() == Approx(0.5*(1.0+phi)/(1.0-phi)).epsilon(0.1));
+
+    // the scalar product of independent components has the same correlation
+    Vera.getCorrelation(lags,correlation);
+    CHECK(correlation[1] == Approx(phi).epsilon(0.01));
+    CHECK(Vera.getIntegratedTime() == Approx(0.5*(1.0+phi)/(1.0-phi)).epsilon(0.1));
+
+    // uncorrelated samples have an integrated time of 1/2
+    MultiTauCorrelator Wade(1);
+    for(uint32_t t=0; t<(1<<16); t++){
+        Wade.addSample(noise(generator));
+    }
+    CHECK(Wade.getIntegratedTime() == Approx(0.5).margin(0.05));
+}
@@ -0,0 +1,113 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <vector>
+
+#include "Philox4x32.h"
+
+TEST_CASE( "Philox4x32_knownAnswers" ) {
+    // known answer tests of Random123 for philox4x32-10
+    uint32_t counter0[4]={0,0,0,0};
+    const uint32_t key0[2]={0,0};
+    Philox4x32::block(counter0,key0);
+    CHECK(counter0[0] == 0x6627e8d5u);
+    CHECK(counter0[1] == 0xe169c58du);
+    CHECK(counter0[2] == 0xbc57ac4cu);
+    CHECK(counter0[3] == 0x9b00dbd8u);
+
+    uint32_t counter1[4]={0xffffffffu,0xffffffffu,0xffffffffu,0xffffffffu};
+    const uint32_t key1[2]={0xffffffffu,0xffffffffu};
+    Philox4x32::block(counter1,key1);
+    CHECK(counter1[0] == 0x408f276du);
+    CHECK(counter1[1] == 0x41c83b0eu);
+    CHECK(counter1[2] == 0xa20bc7c6u);
+    CHECK(counter1[3] == 0x6d5451fdu);
+
+    uint32_t counter2[4]={0x243f6a88u,0x85a308d3u,0x13198a2eu,0x03707344u};
+    const uint32_t key2[2]={0xa4093822u,0x299f31d0u};
+    Philox4x32::block(counter2,key2);
+    CHECK(counter2[0] == 0xd16cfe09u);
+    CHECK(counter2[1] == 0x94fdccebu);
+    CHECK(counter2[2] == 0x5001e420u);
+    CHECK(counter2[3] == 0x24126ea1u);
+
+    // the first numbers of seed 0 and stream 0 are the block of counter 0
+    Philox4x32 Phil;
+    CHECK(Phil() == 0x6627e8d5u);
+    CHECK(Phil() == 0xe169c58du);
+}
+
+TEST_CASE( "Philox4x32_streams" ) {
+    Philox4x32 Anna(1234,0), Berta(1234,1), Carla(1234,0,1), Dora(1234,0);
+
+    uint32_t equalAB(0), equalAC(0);
+    for(uint32_t i=0; i<1000; i++){
+        const uint32_t a(Anna()), b(Berta()), c(Carla());
+        if(a == b) equalAB++;
+        if(a == c) equalAC++;
+    }
+    CHECK(equalAB < 2);
+    CHECK(equalAC < 2);
+
+    // batches give the same sequence as single numbers, also with a partly used buffer
+    std::vector<uint32_t> batch(1001);
+    Dora();
+    Dora.fill(&batch[1],1000);
+    Dora.setSeed(1234,0);
+    batch[0]=Dora();
+    Anna.setSeed(1234,0);
+    for(uint32_t i=0; i<batch.size(); i++){
+        CHECK(batch[i] == Anna());
+    }
+
+    // the state can be stored and restored
+    const Philox4x32::State state(Anna.getState());
+    const uint32_t next(Anna());
+    Anna();
+    Anna.setState(state);
+    CHECK(Anna() == next);
+}
+
+TEST_CASE( "Philox4x32_scale" ) {
+    CHECK(Philox4x32::scale(0,6) == 0);
+    CHECK(Philox4x32::scale(0xffffffffu,6) == 5);
+    CHECK(Philox4x32::scale(0x80000000u,100) == 50);
+
+    // uniform directions
+    Philox4x32 Phil(42);
+    std::vector<uint32_t> histogram(6,0);
+    for(uint32_t i=0; i<60000; i++){
+        histogram[Philox4x32::scale(Phil(),6)]++;
+    }
+    for(uint32_t d=0; d<6; d++){
+        CHECK(histogram[d] > 9500);
+        CHECK(histogram[d] < 10500);
+    }
+}
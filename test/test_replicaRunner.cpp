@@ -0,0 +1,112 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "UpdaterCreateChainInSlit.h"
+#include "ReplicaRunner.h"
+#include "ThreadPool.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+TEST_CASE( "ThreadPool_run" ) {
+    ThreadPool pool(3);
+    CHECK(pool.getNumberOfThreads() == 3);
+    CHECK(ThreadPool().getNumberOfThreads() > 0);
+
+    std::vector<uint32_t> done(100,0);
+    pool.run(100, [&](uint32_t i){ done[i]+=i; });
+    for(uint32_t i=0; i<done.size(); i++){
+        CHECK(done[i] == i);
+    }
+
+    // exceptions of the tasks are passed to the caller
+    CHECK_THROWS(pool.run(10, [](uint32_t i){ if(i == 5) throw std::runtime_error("task failed"); }));
+}
+
+TEST_CASE( "ReplicaRunner_merge" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    std::vector<uint32_t> selection {5,10};
+    ReplicaRunner<IngredientsType> Rita(ingredients, 4, selection, 42);
+    ReplicaRunner<IngredientsType> Rosa(ingredients, 4, selection, 42);
+    Rita.setReplicaFilenamePrefix("test_replica_rita");
+    Rosa.setReplicaFilenamePrefix("test_replica_rosa");
+    CHECK(Rita.getNumberOfReplicas() == 4);
+    CHECK_THROWS(Rita.getMergedForce());
+    CHECK_THROWS(ReplicaRunner<IngredientsType>(ingredients, 0, selection, 42));
+
+    Rita.run(1, 30, 2, 0);
+    Rosa.run(3, 30, 2, 0);
+
+    // every replica is a complete copy and runs on its own
+    uint64_t sumTries(0), sumPlus(0);
+    for(uint32_t r=0; r<Rita.getNumberOfReplicas(); r++){
+        CHECK(Rita.getReplicaIngredients(r).getMolecules().size() == ingredients.getMolecules().size());
+        CHECK(Rita.getReplicaIngredients(r).getMolecules().getAge() == 60);
+        CHECK(Rita.getReplicaIngredients(r).getWalls().size() == ingredients.getWalls().size());
+        CHECK(Rita.getReplicaForce(r).getFilename() == "test_replica_rita"+std::to_string(r)+".dat");
+        sumTries+=Rita.getReplicaForce(r).getCounterTries();
+        sumPlus+=Rita.getReplicaForce(r).getCounterPlus().at(1);
+    }
+    CHECK(ingredients.getMolecules().getAge() == 0);
+
+    const AnalyzerForce<IngredientsType>& merged(Rita.getMergedForce());
+    CHECK(merged.getCounterTries() == sumTries);
+    CHECK(merged.getCounterPlus().at(1) == sumPlus);
+    CHECK(merged.getProbeStatistics(1).getNumberOfSamples() == sumTries);
+
+    // the result does not depend on the number of threads
+    CHECK(Rosa.getMergedForce().getCounterPlus() == merged.getCounterPlus());
+    CHECK(Rosa.getMergedForce().getCounterMinus() == merged.getCounterMinus());
+    for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+        CHECK(Rosa.getReplicaIngredients(3).getMolecules()[i] == Rita.getReplicaIngredients(3).getMolecules()[i]);
+    }
+
+    for(uint32_t r=0; r<4; r++){
+        std::remove(("test_replica_rita"+std::to_string(r)+".dat").c_str());
+        std::remove(("test_replica_rosa"+std::to_string(r)+".dat").c_str());
+    }
+}
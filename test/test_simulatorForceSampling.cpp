@@ -0,0 +1,156 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include "UpdaterCreateChainInSlit.h"
+#include "UpdaterSimulatorForceSampling.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+TEST_CASE( "UpdaterSimulatorForceSampling_singleMonomer" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0);
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 1, 5, 16, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0);
+    Primus.initialize();
+
+    UpdaterSimulatorForceSampling<IngredientsType> Simon(ingredients, 300, std::vector<uint32_t> (1,0));
+    REQUIRE(Simon.getAttemptsPlus().size() == 1);
+    REQUIRE(Simon.getAttemptsMinus().size() == 1);
+    Simon.initialize();
+    Simon.execute();
+
+    // fixed monomer does not move
+    CHECK(ingredients.getMolecules()[0] == VectorInt3(0,0,0));
+    CHECK(ingredients.getMolecules().getAge() == 300);
+
+    // every z jump of a free monomer is possible when fixation and walls are ignored
+    CHECK(Simon.getAttemptsPlus().at(0) > 0);
+    CHECK(Simon.getAttemptsMinus().at(0) > 0);
+    CHECK(Simon.getAttemptsPlus().at(0)+Simon.getAttemptsMinus().at(0) < 300);
+    CHECK(Simon.getCounterPlus().at(0) == Simon.getAttemptsPlus().at(0));
+    CHECK(Simon.getCounterMinus().at(0) == Simon.getAttemptsMinus().at(0));
+}
+
+TEST_CASE( "UpdaterSimulatorForceSampling_blockedMonomer" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+    ingredients.setBoxX(16);
+    ingredients.setBoxY(16);
+    ingredients.setBoxZ(16);
+    ingredients.setPeriodicX(true);
+    ingredients.setPeriodicY(true);
+    ingredients.setPeriodicZ(false);
+    ingredients.modifyBondset().addBFMclassicBondset();
+
+    // fixed monomer with fixed neighbor on top: only jumps down are possible
+    ingredients.modifyMolecules().addMonomer(0,0,4);
+    ingredients.modifyMolecules().addMonomer(0,0,6);
+    ingredients.modifyMolecules().connect(0,1);
+    ingredients.modifyMolecules()[0].setMovableTag(false);
+    ingredients.modifyMolecules()[1].setMovableTag(false);
+    ingredients.synchronize();
+
+    UpdaterSimulatorForceSampling<IngredientsType> Simon(ingredients, 100, std::vector<uint32_t> {0,1}, "test_force_sampling_blocked.dat");
+    Simon.initialize();
+    Simon.execute();
+
+    CHECK(Simon.getAttemptsPlus().at(0) > 0);
+    CHECK(Simon.getAttemptsMinus().at(0) > 0);
+    CHECK(Simon.getCounterPlus().at(0) == 0);
+    CHECK(Simon.getCounterMinus().at(0) == Simon.getAttemptsMinus().at(0));
+
+    // upper monomer can only jump up
+    CHECK(Simon.getCounterPlus().at(1) == Simon.getAttemptsPlus().at(1));
+    CHECK(Simon.getCounterMinus().at(1) == 0);
+
+    // without jumps in one direction the force is undefined instead of infinite
+    Simon.cleanup();
+    std::ifstream result("test_force_sampling_blocked.dat");
+    REQUIRE(result.good());
+    std::string content((std::istreambuf_iterator<char>(result)),std::istreambuf_iterator<char>());
+    CHECK(content.find("nan") != std::string::npos);
+    CHECK(content.find("inf") == std::string::npos);
+    result.close();
+    std::remove("test_force_sampling_blocked.dat");
+}
+
+TEST_CASE( "UpdaterSimulatorForceSampling_activeMonomers" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // grafted chain: monomer 0 is fixed at the bottom wall
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 8, 16, 16, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0);
+    Primus.initialize();
+    REQUIRE(ingredients.getMolecules()[0].getMovableTag() == false);
+
+    // immobile monomers are not drawn
+    UpdaterSimulatorForceSampling<IngredientsType> Simon(ingredients, 10, std::vector<uint32_t>());
+    Simon.initialize();
+    CHECK(Simon.getActiveMonomers().size() == ingredients.getMolecules().size()-1);
+    for(uint32_t i=0; i<Simon.getActiveMonomers().size(); i++){
+        CHECK(Simon.getActiveMonomers()[i] != 0);
+    }
+
+    const VectorInt3 anchor(ingredients.getMolecules()[0]);
+    Simon.execute();
+    CHECK(ingredients.getMolecules()[0] == anchor);
+    CHECK(ingredients.getMolecules().getAge() == 10);
+
+    // immobile monomers are drawn if they are sampled
+    UpdaterSimulatorForceSampling<IngredientsType> Sam(ingredients, 100, std::vector<uint32_t> {0});
+    Sam.initialize();
+    CHECK(Sam.getActiveMonomers().size() == ingredients.getMolecules().size());
+    Sam.execute();
+    CHECK(Sam.getAttemptsPlus().at(0)+Sam.getAttemptsMinus().at(0) > 0);
+    CHECK(ingredients.getMolecules()[0] == anchor);
+}
@@ -0,0 +1,118 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+// use the catch file but do not add the #define CATCH_CONFIG_MAIN !!
+#include "catch.hpp"
+
+#include <LeMonADE/core/Ingredients.h>
+#include <LeMonADE/feature/FeatureMoleculesIO.h>
+#include <LeMonADE/feature/FeatureExcludedVolumeSc.h>
+#include <LeMonADE/feature/FeatureAttributes.h>
+#include <LeMonADE/feature/FeatureWall.h>
+#include <LeMonADE/feature/FeatureFixedMonomers.h>
+
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+
+#include <LeMonADE/updater/UpdaterSimpleSimulator.h>
+
+#include "UpdaterCreateChainInSlit.h"
+#include "AnalyzerForce.h"
+#include "UpdaterForceConvergence.h"
+
+typedef LOKI_TYPELIST_5(FeatureMoleculesIO, FeatureExcludedVolumeSc< FeatureLatticePowerOfTwo <bool> >, FeatureWall, FeatureAttributes, FeatureFixedMonomers) Features;
+typedef ConfigureSystem<VectorInt3,Features,4> Config;
+typedef Ingredients<Config> IngredientsType;
+
+TEST_CASE( "UpdaterForceConvergence_converged" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    // every probe of a single monomer succeeds in both directions, so the error vanishes
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 1, 5, 16, UpdaterCreateChainInSlit<IngredientsType>::SINGLE_FIXPOINT_BOTTOM, 0);
+    Primus.initialize();
+
+    AnalyzerForce<IngredientsType> Anna(ingredients, std::vector<uint32_t> (1,0), 0);
+    Anna.initialize();
+
+    UpdaterForceConvergence<IngredientsType> Conny(Anna, 0.1, 0.0, 50);
+    CHECK(Conny.getTargetError() == 0.1);
+    CHECK(Conny.getWallTime() == 0.0);
+    Conny.initialize();
+
+    CHECK_THROWS(UpdaterForceConvergence<IngredientsType>(Anna, -1.0));
+
+    UpdaterSimpleSimulator<IngredientsType,MoveLocalSc> simulator(ingredients,1);
+    uint32_t n(0);
+    while(Conny.execute() && n<1000){
+        CHECK(Conny.getStopReason() == UpdaterForceConvergence<IngredientsType>::NOT_STOPPED);
+        simulator.execute();
+        Anna.execute();
+        n++;
+    }
+
+    // the run stops as soon as the minimum number of probes is reached
+    CHECK(n <= 50);
+    CHECK(Anna.getCounterTries() == 50);
+    CHECK(Anna.getForceError(0) == 0.0);
+    CHECK(Conny.isConverged() == true);
+    CHECK(Conny.getStopReason() == UpdaterForceConvergence<IngredientsType>::STOP_CONVERGED);
+}
+
+TEST_CASE( "UpdaterForceConvergence_notConverged" ) {
+    RandomNumberGenerators randomNumbers;
+    randomNumbers.seedAll();
+
+    IngredientsType ingredients;
+
+    UpdaterCreateChainInSlit<IngredientsType> Primus(ingredients, 16, 14, 16, UpdaterCreateChainInSlit<IngredientsType>::DOUBLE_FIXED_AT_WALLS, 0);
+    Primus.initialize();
+
+    std::vector<uint32_t> selection {5,10};
+    AnalyzerForce<IngredientsType> Anna(ingredients, selection, 0);
+    Anna.initialize();
+
+    // unreachable target and a wall time which is used up at once
+    UpdaterForceConvergence<IngredientsType> strict(Anna, 1.0e-6, 0.0, 10);
+    UpdaterForceConvergence<IngredientsType> budget(Anna, 0.0, 1.0e-12);
+    strict.initialize();
+    budget.initialize();
+
+    UpdaterSimpleSimulator<IngredientsType,MoveLocalSc> simulator(ingredients,1);
+    for(uint32_t n=0; n<200; n++){
+        CHECK(strict.execute() == true);
+        simulator.execute();
+        Anna.execute();
+    }
+
+    CHECK(strict.isConverged() == false);
+    CHECK(strict.getStopReason() == UpdaterForceConvergence<IngredientsType>::NOT_STOPPED);
+
+    CHECK(budget.execute() == false);
+    CHECK(budget.getStopReason() == UpdaterForceConvergence<IngredientsType>::STOP_WALLTIME);
+}
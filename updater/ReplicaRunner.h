@@ -0,0 +1,241 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef LEMONADE_REPLICA_RUNNER_H
+#define LEMONADE_REPLICA_RUNNER_H
+/**
+ * @file
+ *
+ * @class ReplicaRunner
+ *
+ * @brief Run independent replicas of a system in one process and merge their force statistics.
+ *
+ * @details Every replica is a copy of the source system with its own Ingredients, its own
+ * UpdaterSimulatorForceSampling drawing from the Philox4x32 stream of the master seed with
+ * the replica index as stream id, and its own AnalyzerForce. The replicas are distributed over the
+ * threads of a ThreadPool and do not synchronize until the end of run(), so the run time
+ * scales with the number of cores as long as the replicas fit into memory.
+ *
+ * The copy contains molecules, box, periodicity, bondset and walls of the source system.
+ * The source system is read from the bfm file once.
+ *
+ * After run() the statistics of all replicas are merged into an AnalyzerForce of the
+ * source system. The random number streams of the replicas do not depend on the
+ * number of threads, so the merged result does not either.
+ *
+ * @tparam IngredientsType
+ **/
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "UpdaterSimulatorForceSampling.h"
+#include "AnalyzerForce.h"
+#include "ThreadPool.h"
+
+
+template<class IngredientsType>
+class ReplicaRunner
+{
+public:
+  ReplicaRunner(const IngredientsType& source_, uint32_t nReplicas_, std::vector<uint32_t> selectedMonomers_, uint64_t masterSeed_);
+
+  //! run all replicas for nCycles cycles of simulatorInterval mcs followed by a force probe
+  void run(uint32_t nThreads, uint32_t nCycles, uint32_t simulatorInterval, uint64_t beginCalculation);
+
+  uint32_t getNumberOfReplicas() const { return replicas.size(); }
+  const IngredientsType& getReplicaIngredients(uint32_t r) const { return *(replicas.at(r).ingredients); }
+  const AnalyzerForce<IngredientsType>& getReplicaForce(uint32_t r) const { return *(replicas.at(r).analyzer); }
+
+  //! force statistics of all replicas, available after run()
+  const AnalyzerForce<IngredientsType>& getMergedForce() const;
+
+  //! output file of the replica analyzers is prefix + replica index + .dat
+  void setReplicaFilenamePrefix(const std::string& prefix){ replicaFilenamePrefix=prefix; }
+
+  //! optional measurements of the replica analyzers, see AnalyzerForce::setOptions()
+  void setForceOptions(const AnalyzerForceOptions& forceOptions_){ forceOptions=forceOptions_; }
+
+private:
+
+  //! everything owned by a single replica
+  struct Replica{
+    std::unique_ptr<IngredientsType> ingredients;
+    std::unique_ptr<UpdaterSimulatorForceSampling<IngredientsType> > simulator;
+    std::unique_ptr<AnalyzerForce<IngredientsType> > analyzer;
+  };
+
+  //! system the replicas are copied from
+  const IngredientsType& source;
+
+  //! monomers the force is measured for
+  const std::vector<uint32_t> selectedMonomers;
+
+  //! seed of the replica random number streams
+  uint64_t masterSeed;
+
+  //! all replicas
+  std::vector<Replica> replicas;
+
+  //! merged force statistics of all replicas
+  std::unique_ptr<AnalyzerForce<IngredientsType> > mergedForce;
+
+  //! prefix of the output files of the replica analyzers
+  std::string replicaFilenamePrefix;
+
+  //! optional measurements of the analyzers
+  AnalyzerForceOptions forceOptions;
+
+  //! helper function: copy the source system to ing
+  void copySystem(IngredientsType& ing) const;
+
+  //! helper function: run a single replica
+  void runReplica(uint32_t r, uint32_t nCycles);
+};
+
+/**
+* @brief Constructor copying the source system into every replica
+*
+* @param source_ system the replicas are copied from
+* @param nReplicas_ number of replicas
+* @param selectedMonomers_ monomers the force is measured for
+* @param masterSeed_ seed of the replica random number streams
+*/
+template<class IngredientsType>
+ReplicaRunner<IngredientsType>::ReplicaRunner(const IngredientsType& source_, uint32_t nReplicas_, std::vector<uint32_t> selectedMonomers_, uint64_t masterSeed_)
+:source(source_),selectedMonomers(selectedMonomers_),masterSeed(masterSeed_),replicas(nReplicas_),replicaFilenamePrefix("force_replica"),forceOptions()
+{
+  if(nReplicas_ == 0){
+    throw std::runtime_error("ReplicaRunner: number of replicas must be positive");
+  }
+}
+
+/**
+* @details The replicas are set up in the calling thread on the first call. Every
+* replica probes the force once in AnalyzerForce::initialize() and after every cycle,
+* and writes its own results in AnalyzerForce::cleanup().
+*
+* @param nThreads number of threads, 0 uses the number of cores
+* @param nCycles number of cycles
+* @param simulatorInterval mcs per cycle
+* @param beginCalculation age of the system at which the force probes begin, as in AnalyzerForce
+*/
+template<class IngredientsType>
+void ReplicaRunner<IngredientsType>::run(uint32_t nThreads, uint32_t nCycles, uint32_t simulatorInterval, uint64_t beginCalculation)
+{
+  mergedForce.reset();
+
+  for(uint32_t r=0; r<replicas.size(); r++){
+    if(replicas[r].ingredients){
+      continue;
+    }
+
+    replicas[r].ingredients.reset(new IngredientsType);
+    copySystem(*(replicas[r].ingredients));
+
+    replicas[r].simulator.reset(new UpdaterSimulatorForceSampling<IngredientsType>(*(replicas[r].ingredients),simulatorInterval,std::vector<uint32_t>()));
+    replicas[r].simulator->setSeed(masterSeed,r);
+    replicas[r].simulator->setVerbose(false);
+
+    std::stringstream filename;
+    filename << replicaFilenamePrefix << r << ".dat";
+    replicas[r].analyzer.reset(new AnalyzerForce<IngredientsType>(*(replicas[r].ingredients),selectedMonomers,beginCalculation));
+    replicas[r].analyzer->setFilename(filename.str());
+    replicas[r].analyzer->setOptions(forceOptions);
+  }
+
+  ThreadPool pool(nThreads);
+  std::cout<<"ReplicaRunner: run "<<replicas.size()<<" replicas on "<<pool.getNumberOfThreads()<<" threads"<<std::endl;
+  pool.run(replicas.size(), [&](uint32_t r){ runReplica(r,nCycles); });
+
+  mergedForce.reset(new AnalyzerForce<IngredientsType>(source,selectedMonomers,beginCalculation));
+  mergedForce->setOptions(forceOptions);
+  for(uint32_t r=0; r<replicas.size(); r++){
+    mergedForce->merge(*(replicas[r].analyzer));
+  }
+}
+
+template<class IngredientsType>
+const AnalyzerForce<IngredientsType>& ReplicaRunner<IngredientsType>::getMergedForce() const
+{
+  if(!mergedForce){
+    throw std::runtime_error("ReplicaRunner: merged force is only available after run()");
+  }
+  return *mergedForce;
+}
+
+/**
+* @details Monomer attributes, fixation and bonds are part of the molecules.
+*
+* @param ing empty system to copy the source system to
+*/
+template<class IngredientsType>
+void ReplicaRunner<IngredientsType>::copySystem(IngredientsType& ing) const
+{
+  ing.modifyMolecules()=source.getMolecules();
+
+  ing.setBoxX(source.getBoxX());
+  ing.setBoxY(source.getBoxY());
+  ing.setBoxZ(source.getBoxZ());
+
+  ing.setPeriodicX(source.isPeriodicX());
+  ing.setPeriodicY(source.isPeriodicY());
+  ing.setPeriodicZ(source.isPeriodicZ());
+
+  ing.modifyBondset()=source.getBondset();
+
+  for(uint32_t w=0; w<source.getWalls().size(); w++){
+    ing.addWall(source.getWalls()[w]);
+  }
+
+  ing.synchronize();
+}
+
+/**
+* @details Runs in a thread of the pool and touches the data of replica r only.
+*/
+template<class IngredientsType>
+void ReplicaRunner<IngredientsType>::runReplica(uint32_t r, uint32_t nCycles)
+{
+  Replica& replica(replicas[r]);
+  replica.simulator->initialize();
+  replica.analyzer->initialize();
+
+  for(uint32_t n=0; n<nCycles; n++){
+    replica.simulator->execute();
+    replica.analyzer->execute();
+  }
+
+  replica.simulator->cleanup();
+  replica.analyzer->cleanup();
+}
+
+#endif /* LEMONADE_REPLICA_RUNNER_H */
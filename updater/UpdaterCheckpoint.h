@@ -0,0 +1,391 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef LEMONADE_UPDATER_CHECKPOINT_H
+#define LEMONADE_UPDATER_CHECKPOINT_H
+/**
+ * @file
+ *
+ * @class UpdaterCheckpoint
+ *
+ * @brief Updater writing and restoring binary checkpoints of a run.
+ *
+ * @details A checkpoint holds the monomer positions, the age, the age the run ends at and
+ * the state of all registered components, e.g. the random number generator of the
+ * simulator and the counters of the analyzers. The topology is not stored, it is read
+ * from the bfm file as usual.
+ *
+ * The updater has to be added behind the UpdaterReadBfmFile and in front of the
+ * simulator. On its first execute() an existing checkpoint is restored, so all other
+ * tasks are initialized already and the run continues exactly where the checkpoint was
+ * written. Checkpoints are written every saveInterval calls of execute(), in cleanup()
+ * and when checkpointSignalFlag() is set, e.g. by SIGTERM. In the last case execute()
+ * returns false to end the run.
+ *
+ * A resumed TaskManager starts counting its cycles at zero, so analyzers running every
+ * n-th cycle are only in phase with the interrupted run if the checkpoint is taken on a
+ * cycle which is a multiple of n. The phase period, the least common multiple of these
+ * periods, has to divide saveInterval. A signal stops the run on the next call in phase,
+ * and cleanup() writes the state of the last call in phase unless the end of the run is
+ * reached.
+ *
+ * Trajectories registered with addTrajectory() are cut back to the age of the checkpoint
+ * in initialize(), in front of the initialization of their writers, so frames written
+ * after the checkpoint are not duplicated by the resumed run.
+ *
+ * The run ends at the age it would have reached without interruptions: execute() returns
+ * false once the age stored as end of the run is reached.
+ *
+ * @tparam IngredientsType
+ **/
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/updater/AbstractUpdater.h>
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "BfmFrameIndex.h"
+#include "BinaryTrajectory.h"
+#include "Checkpoint.h"
+
+
+template<class IngredientsType>
+class UpdaterCheckpoint: public AbstractUpdater
+{
+public:
+  UpdaterCheckpoint(IngredientsType& ingredients_, std::string filename_, uint32_t saveInterval_, uint64_t runLength_, uint32_t phasePeriod_=1);
+
+  virtual void initialize();
+  virtual bool execute();
+  virtual void cleanup();
+
+  //! add a component whose state is part of the checkpoint, the order must not change between runs
+  void addComponent(AbstractCheckpointable* component){ components.push_back(component); }
+
+  //! add a bfm or binary (.btr) trajectory whose frames behind the checkpoint are removed on a restart
+  void addTrajectory(const std::string& trajectory){ trajectories.push_back(trajectory); }
+
+  //! remove the frames with an age above age from a bfm or binary (.btr) trajectory, returns their number
+  static uint64_t truncateTrajectory(const std::string& trajectory, uint64_t age);
+
+  //! write the checkpoint file
+  void save() const;
+  //! restore the checkpoint file, returns false if there is no checkpoint
+  bool restore();
+
+  //functions to get private variable for tests
+  uint64_t getEndAge() const { return endAge; }
+  bool isRestored() const { return restored; }
+  bool isInterrupted() const { return interrupted; }
+
+private:
+  //! write the current state to buffer
+  void writeState(CheckpointWriter& buffer) const;
+
+  //! read the checkpoint file up to the age, returns false if there is no checkpoint
+  bool readHeader(CheckpointReader& checkpoint, uint64_t& age) const;
+
+  //! reference to the simulated system
+  IngredientsType& ingredients;
+
+  //! checkpoint file
+  std::string filename;
+
+  //! number of calls of execute() between two checkpoints, 0 writes in cleanup() only
+  uint32_t saveInterval;
+
+  //! number of mcs of the run
+  uint64_t runLength;
+
+  //! age the run ends at, set on the first execute() or restored from the checkpoint
+  uint64_t endAge;
+
+  //! number of calls of execute() between two calls in phase with all periodic tasks
+  uint32_t phasePeriod;
+
+  //! components saved after the configuration
+  std::vector<AbstractCheckpointable*> components;
+
+  //! trajectories cut back to the age of the checkpoint on a restart
+  std::vector<std::string> trajectories;
+
+  //! state of the last call of execute() in phase
+  CheckpointWriter inPhaseState;
+
+  //! number of calls of execute()
+  uint64_t counterExecute;
+
+  //! true if the state was restored from a checkpoint
+  bool restored;
+
+  //! true if the run was ended by checkpointSignalFlag()
+  bool interrupted;
+
+  //! identifier and version of the file format, version 2 stores the Philox4x32 state of the simulator, version 3 the direction counters and the profile of AnalyzerForce
+  static const uint64_t magicNumber=0x54504b434c474e54ULL;
+  static const uint32_t version=3;
+};
+
+/**
+* @brief Constructor handling the checkpoint parameters
+*
+* @param ingredients_ a reference to the IngredientsType - mainly the system
+* @param filename_ checkpoint file
+* @param saveInterval_ number of calls of execute() between two checkpoints, 0 writes in cleanup() only
+* @param runLength_ number of mcs of the complete run, 0 for no limit
+* @param phasePeriod_ least common multiple of the periods of all tasks, in calls of execute()
+*/
+template<class IngredientsType>
+UpdaterCheckpoint<IngredientsType>::UpdaterCheckpoint(IngredientsType& ingredients_, std::string filename_, uint32_t saveInterval_, uint64_t runLength_, uint32_t phasePeriod_)
+:ingredients(ingredients_),filename(filename_),saveInterval(saveInterval_),runLength(runLength_),
+endAge(0),phasePeriod(phasePeriod_),counterExecute(0),restored(false),interrupted(false)
+{
+  if(phasePeriod == 0 || saveInterval % phasePeriod != 0){
+    throw std::runtime_error("UpdaterCheckpoint: the save interval has to be a multiple of the phase period");
+  }
+}
+
+/**
+* @brief Cut the registered trajectories back to the age of an existing checkpoint
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterCheckpoint<IngredientsType>::initialize(){
+  if(trajectories.empty()){
+    return;
+  }
+  CheckpointReader checkpoint;
+  uint64_t age(0);
+  if(!readHeader(checkpoint,age)){
+    return;
+  }
+  for(uint32_t t=0; t<trajectories.size(); t++){
+    const uint64_t nRemoved(truncateTrajectory(trajectories[t],age));
+    if(nRemoved > 0){
+      std::cout<<"UpdaterCheckpoint: removed "<<nRemoved<<" frames behind mcs "<<age<<" from "<<trajectories[t]<<std::endl;
+    }
+  }
+}
+
+/**
+* @brief Restore on the first call, write checkpoints and check for the end of the run
+*
+* @return false if the run should stop
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+bool UpdaterCheckpoint<IngredientsType>::execute(){
+  if(counterExecute == 0){
+    endAge=(runLength > 0) ? ingredients.getMolecules().getAge()+runLength : 0;
+    restored=restore();
+  }
+
+  const bool inPhase((counterExecute % phasePeriod) == 0);
+  if(inPhase){
+    inPhaseState.clear();
+    writeState(inPhaseState);
+    if(counterExecute > 0 && saveInterval > 0 && (counterExecute % saveInterval) == 0){
+      inPhaseState.writeFile(filename);
+    }
+  }
+  counterExecute++;
+
+  if(checkpointSignalFlag() != 0 && inPhase){
+    std::cout<<"UpdaterCheckpoint: signal received, write checkpoint at mcs "<<ingredients.getMolecules().getAge()<<std::endl;
+    interrupted=true;
+    return false;
+  }
+
+  if(endAge > 0 && ingredients.getMolecules().getAge() >= endAge){
+    return false;
+  }
+
+  return true;
+}
+
+/**
+* @brief Write the final checkpoint
+*
+* @details At the end of the run the final state is written. A run stopped earlier, by
+* a signal or another task, is written in the state of the last call in phase.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterCheckpoint<IngredientsType>::cleanup(){
+  if(counterExecute == 0){
+    return;
+  }
+  if(endAge > 0 && ingredients.getMolecules().getAge() >= endAge){
+    save();
+  }else{
+    inPhaseState.writeFile(filename);
+  }
+}
+
+/**
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterCheckpoint<IngredientsType>::save() const{
+  CheckpointWriter checkpoint;
+  writeState(checkpoint);
+  checkpoint.writeFile(filename);
+}
+
+/**
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterCheckpoint<IngredientsType>::writeState(CheckpointWriter& checkpoint) const{
+  checkpoint.write(uint64_t(magicNumber));
+  checkpoint.write(uint32_t(version));
+
+  checkpoint.write(uint64_t(ingredients.getMolecules().getAge()));
+  checkpoint.write(endAge);
+
+  const uint32_t nMonomers(ingredients.getMolecules().size());
+  checkpoint.write(nMonomers);
+  for(uint32_t i=0; i<nMonomers; i++){
+    checkpoint.write(int32_t(ingredients.getMolecules()[i].getX()));
+    checkpoint.write(int32_t(ingredients.getMolecules()[i].getY()));
+    checkpoint.write(int32_t(ingredients.getMolecules()[i].getZ()));
+  }
+
+  checkpoint.write(uint32_t(components.size()));
+  for(uint32_t c=0; c<components.size(); c++){
+    components[c]->saveState(checkpoint);
+  }
+}
+
+/**
+* @details The positions are set and the system is synchronized before the components
+* are restored. The checkpoint has to match the number of monomers of the system and
+* the number of registered components.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+bool UpdaterCheckpoint<IngredientsType>::restore(){
+  CheckpointReader checkpoint;
+  uint64_t age(0);
+  if(!readHeader(checkpoint,age)){
+    return false;
+  }
+
+  uint32_t nMonomers(0);
+  checkpoint.read(endAge);
+  checkpoint.read(nMonomers);
+  if(nMonomers != ingredients.getMolecules().size()){
+    throw std::runtime_error("UpdaterCheckpoint: number of monomers in checkpoint does not match the system");
+  }
+
+  for(uint32_t i=0; i<nMonomers; i++){
+    int32_t x(0), y(0), z(0);
+    checkpoint.read(x);
+    checkpoint.read(y);
+    checkpoint.read(z);
+    ingredients.modifyMolecules()[i].setAllCoordinates(x,y,z);
+  }
+  ingredients.modifyMolecules().setAge(age);
+  ingredients.synchronize();
+
+  uint32_t nComponents(0);
+  checkpoint.read(nComponents);
+  if(nComponents != components.size()){
+    throw std::runtime_error("UpdaterCheckpoint: number of components in checkpoint does not match");
+  }
+  for(uint32_t c=0; c<components.size(); c++){
+    components[c]->loadState(checkpoint);
+  }
+
+  if(!checkpoint.isAtEnd()){
+    throw std::runtime_error("UpdaterCheckpoint: unexpected data at the end of "+filename);
+  }
+
+  std::cout<<"UpdaterCheckpoint: restored "<<filename<<" at mcs "<<age<<std::endl;
+  return true;
+}
+
+/**
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+bool UpdaterCheckpoint<IngredientsType>::readHeader(CheckpointReader& checkpoint, uint64_t& age) const{
+  if(!checkpoint.readFile(filename)){
+    return false;
+  }
+
+  uint64_t savedMagicNumber(0);
+  uint32_t savedVersion(0);
+  checkpoint.read(savedMagicNumber);
+  checkpoint.read(savedVersion);
+  if(savedMagicNumber != magicNumber || savedVersion != version){
+    throw std::runtime_error("UpdaterCheckpoint: "+filename+" is no checkpoint of this version");
+  }
+
+  checkpoint.read(age);
+  return true;
+}
+
+/**
+* @details A missing trajectory is skipped. Binary trajectories are recognized by the
+* extension .btr, all other files are read as bfm files.
+*
+* @param trajectory file name
+* @param age age of the last frame kept
+*/
+template<class IngredientsType>
+uint64_t UpdaterCheckpoint<IngredientsType>::truncateTrajectory(const std::string& trajectory, uint64_t age){
+  std::ifstream test(trajectory.c_str(), std::ios::binary | std::ios::ate);
+  if(!test.is_open() || test.tellg() <= 0){
+    return 0;
+  }
+  test.close();
+
+  const std::string extension(".btr");
+  if(trajectory.size() >= extension.size() && trajectory.compare(trajectory.size()-extension.size(),extension.size(),extension) == 0){
+    BinaryTrajectoryReader reader;
+    reader.open(trajectory);
+    BinaryTrajectoryWriter writer;
+    writer.open(trajectory,reader.getStructure(),true);
+    const uint64_t nRemoved(writer.removeFramesAfter(age));
+    writer.close();
+    return nRemoved;
+  }
+
+  BfmFrameIndex index(trajectory);
+  return index.removeFramesAfter(age);
+}
+
+#endif /* LEMONADE_UPDATER_CHECKPOINT_H */
@@ -34,6 +34,11 @@ along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
  *
  * @brief Updater setting up a simple system containing a linear chain in a slit with different monomer fixes
  *
+ * @details By default the box in z is rounded up to the next power of two and a wall at
+ * z=slitSize closes the slit. With compactBox the box in z is exactly slitSize and the
+ * non-periodic box itself is the slit, which requires a lattice supporting arbitrary
+ * z extents like FeatureLatticeSlit.
+ *
  * @tparam IngredientsType
  *
  **/
@@ -48,7 +53,7 @@ class UpdaterCreateChainInSlit: public UpdaterAbstractCreate<IngredientsType>
   typedef UpdaterAbstractCreate<IngredientsType> BaseClass;
   
 public:
-  UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0);
+  UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_=0, bool compactBox_=false);
 
   enum FIX_TYPE{
     SINGLE_FIXPOINT_BOTTOM=0,
@@ -90,6 +95,9 @@ private:
 
   //! in case of FIXED_AT_WALL_AND_IN_SPACE: distance of fixed monomer in space to the wall
   uint32_t distanceFixpointWall;
+
+  //! use a box of exactly slitSize in z without additional wall
+  bool compactBox;
   
   //! bool for execution
   bool isInitialized;
@@ -111,11 +119,12 @@ private:
 * @param boxXY_ boxsize in xy direction
 * @param fixType_ type of system setup using FIX_TYPE
 * @param distanceFixpointWall_ distance between fixpoint of chain end (FIXED_AT_WALL_AND_IN_SPACE) and wall
+* @param compactBox_ use slitSize_ as boxsize in z instead of the next power of two
 */
 template < class IngredientsType >
-UpdaterCreateChainInSlit<IngredientsType>::UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_):
+UpdaterCreateChainInSlit<IngredientsType>::UpdaterCreateChainInSlit(IngredientsType& ingredients_, uint32_t chainLength_, uint32_t slitSize_, uint32_t boxXY_, int fixType_, uint32_t distanceFixpointWall_, bool compactBox_):
 BaseClass(ingredients_), chainLength(chainLength_), slitSize(slitSize_), boxXY(boxXY_), fixType(fixType_),distanceFixpointWall(distanceFixpointWall_),
-isInitialized(false), isExecuted(false)
+compactBox(compactBox_), isInitialized(false), isExecuted(false)
 {}
 
 /**
@@ -132,8 +141,12 @@ void UpdaterCreateChainInSlit<IngredientsType>::initialize(){
     // setup box
     ingredients.setBoxX(boxXY);
     ingredients.setBoxY(boxXY);
-    // adjust the z boxsize to next power of two
-    ingredients.setBoxZ(pow2roundup(slitSize));
+    // adjust the z boxsize to next power of two unless the lattice supports any size
+    if(compactBox){
+      ingredients.setBoxZ(slitSize);
+    }else{
+      ingredients.setBoxZ(pow2roundup(slitSize));
+    }
 
     // add the flexible wall
     if(ingredients.getBoxZ()!=slitSize){
@@ -0,0 +1,192 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef LEMONADE_UPDATER_FORCE_CONVERGENCE_H
+#define LEMONADE_UPDATER_FORCE_CONVERGENCE_H
+/**
+ * @file
+ *
+ * @class UpdaterForceConvergence
+ *
+ * @brief Updater stopping the TaskManager once the force of all selected monomers is
+ * known to a requested accuracy or a wall-clock budget is used up.
+ *
+ * @details The updater does not change the system. It reads the statistics of an
+ * AnalyzerForce and returns false from execute() if
+ * - the error of log(n-/n+) is below targetError for every selected monomer, which is the
+ *   relative error of the ratio n-/n+, and the blocking analysis of every monomer is converged, or
+ * - more than wallTime seconds passed since initialize().
+ *
+ * A value of 0 disables the respective criterion. The TaskManager stops running if an
+ * updater returns false, so the regular cleanup() of all tasks is still done afterwards.
+ * It should be added with the period of the simulator behind it.
+ *
+ * @tparam IngredientsType
+ **/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <LeMonADE/updater/AbstractUpdater.h>
+
+#include "AnalyzerForce.h"
+
+
+template<class IngredientsType>
+class UpdaterForceConvergence: public AbstractUpdater
+{
+public:
+  UpdaterForceConvergence(const AnalyzerForce<IngredientsType>& analyzer_, double targetError_, double wallTime_=0.0, uint64_t minTries_=100);
+
+  enum STOP_REASON{
+    NOT_STOPPED=0,
+    STOP_CONVERGED=1,
+    STOP_WALLTIME=2
+  };
+
+  virtual void initialize();
+  virtual bool execute();
+  virtual void cleanup();
+
+  //! check if the force of all selected monomers reached the target error
+  bool isConverged() const;
+
+  //functions to get private variable for tests
+  int getStopReason() const { return stopReason; }
+  double getTargetError() const { return targetError; }
+  double getWallTime() const { return wallTime; }
+
+private:
+  //! analyzer providing the force statistics
+  const AnalyzerForce<IngredientsType>& analyzer;
+
+  //! target error of log(n-/n+), 0 disables the criterion
+  double targetError;
+
+  //! wall-clock budget in seconds, 0 disables the criterion
+  double wallTime;
+
+  //! minimum number of probes before the error is trusted
+  uint64_t minTries;
+
+  //! start of the wall-clock budget
+  std::chrono::steady_clock::time_point startTime;
+
+  //! reason for returning false from execute()
+  int stopReason;
+};
+
+/**
+* @brief Constructor handling the stopping criteria
+*
+* @param analyzer_ analyzer providing the force statistics
+* @param targetError_ target error of log(n-/n+) for every selected monomer, 0 disables the criterion
+* @param wallTime_ wall-clock budget in seconds, 0 disables the criterion
+* @param minTries_ minimum number of probes before the convergence is checked
+*/
+template<class IngredientsType>
+UpdaterForceConvergence<IngredientsType>::UpdaterForceConvergence(const AnalyzerForce<IngredientsType>& analyzer_, double targetError_, double wallTime_, uint64_t minTries_)
+:analyzer(analyzer_),targetError(targetError_),wallTime(wallTime_),minTries(minTries_),
+startTime(std::chrono::steady_clock::now()),stopReason(NOT_STOPPED)
+{
+  if(targetError < 0.0 || wallTime < 0.0){
+    throw std::runtime_error("UpdaterForceConvergence: target error and wall time must not be negative");
+  }
+}
+
+/**
+* @brief Start the wall-clock budget
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterForceConvergence<IngredientsType>::initialize(){
+  startTime=std::chrono::steady_clock::now();
+  stopReason=NOT_STOPPED;
+}
+
+/**
+* @brief Check the stopping criteria
+*
+* @return false if the run should stop
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+bool UpdaterForceConvergence<IngredientsType>::execute(){
+  if(targetError > 0.0 && isConverged()){
+    stopReason=STOP_CONVERGED;
+    std::cout<<"UpdaterForceConvergence: force converged after "<<analyzer.getCounterTries()<<" probes"<<std::endl;
+    return false;
+  }
+
+  if(wallTime > 0.0){
+    const std::chrono::duration<double> elapsed(std::chrono::steady_clock::now()-startTime);
+    if(elapsed.count() > wallTime){
+      stopReason=STOP_WALLTIME;
+      std::cout<<"UpdaterForceConvergence: wall time of "<<wallTime<<" s used up after "<<analyzer.getCounterTries()<<" probes"<<std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template<class IngredientsType>
+void UpdaterForceConvergence<IngredientsType>::cleanup(){
+}
+
+/**
+* @details A monomer is converged if it jumped at least once in both directions, the
+* blocking analysis found its plateau and the error is below targetError. Without
+* jumps in one direction log(n-/n+) is not defined yet.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+bool UpdaterForceConvergence<IngredientsType>::isConverged() const{
+  if(analyzer.getCounterTries() < minTries){
+    return false;
+  }
+
+  const uint32_t nSelected(analyzer.getSelectedMonomers().size());
+  for(uint32_t i=0; i<nSelected; i++){
+    if(!analyzer.isForceDefined(i) || !analyzer.isForceErrorConverged(i)){
+      return false;
+    }
+    const double error(analyzer.getForceError(i));
+    if(!std::isfinite(error) || error > targetError){
+      return false;
+    }
+  }
+  return true;
+}
+
+#endif /* LEMONADE_UPDATER_FORCE_CONVERGENCE_H */
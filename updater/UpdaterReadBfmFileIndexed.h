@@ -0,0 +1,240 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef LEMONADE_UPDATER_READ_BFM_FILE_INDEXED_H
+#define LEMONADE_UPDATER_READ_BFM_FILE_INDEXED_H
+/**
+ * @file
+ *
+ * @class UpdaterReadBfmFileIndexed
+ *
+ * @brief Read the last or the n-th frame of a bfm trajectory without scanning it.
+ *
+ * @details Replacement of UpdaterReadBfmFile with READ_LAST_CONFIG_SAVE for long
+ * trajectories. The frame is looked up in the sidecar index of the file, see
+ * BfmFrameIndex, which is created or brought up to date if necessary. Header and frame
+ * are copied to a temporary file, which is read by UpdaterReadBfmFile, so all features
+ * read their commands as usual. readFrame() does the same for any frame of an index,
+ * e.g. to convert or evaluate a bfm trajectory frame by frame. The temporary file is
+ * created with mkstemps in TMPDIR or /tmp, so it is unique per call: many jobs started
+ * from the same input file, several threads reading one file and bfm files in
+ * read-only directories do not interfere.
+ *
+ * If the file has no frame or the temporary file cannot be written, the complete file
+ * is read by UpdaterReadBfmFile with READ_LAST_CONFIG_SAVE as before.
+ *
+ * @tparam IngredientsType
+ **/
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <LeMonADE/updater/AbstractUpdater.h>
+#include <LeMonADE/updater/UpdaterReadBfmFile.h>
+
+#include "BfmFrameIndex.h"
+
+
+template<class IngredientsType>
+class UpdaterReadBfmFileIndexed: public AbstractUpdater
+{
+public:
+
+  enum READ_MODE{
+    READ_LAST_CONFIG=0,
+    READ_NTH_CONFIG=1
+  };
+
+  UpdaterReadBfmFileIndexed(const std::string& filename_, IngredientsType& ingredients_, int mode_=READ_LAST_CONFIG, uint64_t frame_=0);
+
+  //! read the requested frame
+  virtual void initialize();
+  //! nothing to do, the frame is read in initialize()
+  virtual bool execute(){ return false; }
+  virtual void cleanup(){}
+
+  const BfmFrameIndex& getIndex() const { return index; }
+
+  //! read frame n of an up to date index into ing
+  static void readFrame(const BfmFrameIndex& index, uint64_t n, IngredientsType& ing);
+
+private:
+  //! create an empty temporary file for a frame and return its name
+  static std::string createFrameFile();
+
+  //! read an extracted frame into ing and remove its file
+  static void readExtractedFrame(const std::string& frameFilename, IngredientsType& ing);
+
+  //! reference to the system
+  IngredientsType& ingredients;
+
+  //! name of the bfm file
+  std::string filename;
+
+  //! READ_LAST_CONFIG or READ_NTH_CONFIG
+  int mode;
+
+  //! frame read with READ_NTH_CONFIG
+  uint64_t frame;
+
+  BfmFrameIndex index;
+};
+
+
+/**
+ * @param filename_ bfm file
+ * @param ingredients_ system
+ * @param mode_ READ_LAST_CONFIG or READ_NTH_CONFIG
+ * @param frame_ index of the frame read with READ_NTH_CONFIG, starting at 0
+ */
+template<class IngredientsType>
+UpdaterReadBfmFileIndexed<IngredientsType>::UpdaterReadBfmFileIndexed(const std::string& filename_, IngredientsType& ingredients_, int mode_, uint64_t frame_)
+:ingredients(ingredients_)
+,filename(filename_)
+,mode(mode_)
+,frame(frame_)
+,index(filename_)
+{
+  if(mode != READ_LAST_CONFIG && mode != READ_NTH_CONFIG){
+    throw std::runtime_error("UpdaterReadBfmFileIndexed: unknown read mode");
+  }
+}
+
+template<class IngredientsType>
+void UpdaterReadBfmFileIndexed<IngredientsType>::initialize()
+{
+  index.update();
+
+  if(mode == READ_NTH_CONFIG && frame >= index.getNumberOfFrames()){
+    throw std::runtime_error("UpdaterReadBfmFileIndexed: "+filename+" has less frames than requested");
+  }
+
+  if(index.getNumberOfFrames() > 0){
+    const uint64_t n((mode == READ_LAST_CONFIG) ? index.getNumberOfFrames()-1 : frame);
+    std::string frameFilename;
+
+    bool extracted(false);
+    try{
+      frameFilename=createFrameFile();
+      index.extractFrame(n,frameFilename);
+      extracted=true;
+    }catch(std::runtime_error& err){
+      if(!frameFilename.empty()){
+        std::remove(frameFilename.c_str());
+      }
+      std::cerr << err.what() << ", reading the complete file" << std::endl;
+    }
+
+    if(extracted){
+      std::cout << "UpdaterReadBfmFileIndexed: read frame " << n << " at mcs " << index.getMcs(n) << " of " << filename << std::endl;
+      readExtractedFrame(frameFilename,ingredients);
+      return;
+    }
+  }
+
+  UpdaterReadBfmFile<IngredientsType> reader(filename,ingredients,UpdaterReadBfmFile<IngredientsType>::READ_LAST_CONFIG_SAVE);
+  reader.initialize();
+}
+
+/**
+ * @details An empty system is set up from the frame. A system read before, e.g. from
+ * the first frame, only gets the positions and the age of the frame, so a trajectory
+ * can be stepped through with one system, which is not synchronized here. Unlike initialize() there is no fallback to
+ * reading the complete file, an error writing the temporary file is thrown.
+ *
+ * @param index index of the bfm file, brought up to date by the caller
+ * @param n index of the frame
+ * @param ing empty system or system with the structure of the bfm file
+ */
+template<class IngredientsType>
+void UpdaterReadBfmFileIndexed<IngredientsType>::readFrame(const BfmFrameIndex& index, uint64_t n, IngredientsType& ing)
+{
+  const std::string frameFilename(createFrameFile());
+  try{
+    index.extractFrame(n,frameFilename);
+  }catch(...){
+    std::remove(frameFilename.c_str());
+    throw;
+  }
+  if(ing.getMolecules().size() == 0){
+    readExtractedFrame(frameFilename,ing);
+    return;
+  }
+
+  IngredientsType frameIngredients;
+  readExtractedFrame(frameFilename,frameIngredients);
+  if(frameIngredients.getMolecules().size() != ing.getMolecules().size()){
+    throw std::runtime_error("UpdaterReadBfmFileIndexed: frame of "+index.getBfmFilename()+" has a different number of monomers than the system");
+  }
+  for(uint32_t i=0; i<ing.getMolecules().size(); i++){
+    const VectorInt3 pos(frameIngredients.getMolecules()[i]);
+    ing.modifyMolecules()[i].setAllCoordinates(pos.getX(),pos.getY(),pos.getZ());
+  }
+  ing.modifyMolecules().setAge(frameIngredients.getMolecules().getAge());
+}
+
+/**
+ * @details The name is <TMPDIR or /tmp>/bfmframe<random>.bfm. The file is created
+ * exclusively, so no other process or thread gets the same name.
+ */
+template<class IngredientsType>
+std::string UpdaterReadBfmFileIndexed<IngredientsType>::createFrameFile()
+{
+  const char* tmpdir(std::getenv("TMPDIR"));
+  const std::string pattern(std::string((tmpdir != 0 && *tmpdir != '\0') ? tmpdir : "/tmp")+"/bfmframeXXXXXX.bfm");
+
+  std::vector<char> name(pattern.begin(),pattern.end());
+  name.push_back('\0');
+  const int fd(mkstemps(name.data(),4));
+  if(fd < 0){
+    throw std::runtime_error("UpdaterReadBfmFileIndexed: cannot create the temporary file "+pattern);
+  }
+  close(fd);
+  return std::string(name.data());
+}
+
+template<class IngredientsType>
+void UpdaterReadBfmFileIndexed<IngredientsType>::readExtractedFrame(const std::string& frameFilename, IngredientsType& ing)
+{
+  try{
+    UpdaterReadBfmFile<IngredientsType> reader(frameFilename,ing,UpdaterReadBfmFile<IngredientsType>::READ_LAST_CONFIG_SAVE);
+    reader.initialize();
+  }catch(...){
+    std::remove(frameFilename.c_str());
+    throw;
+  }
+  std::remove(frameFilename.c_str());
+}
+
+#endif //LEMONADE_UPDATER_READ_BFM_FILE_INDEXED_H
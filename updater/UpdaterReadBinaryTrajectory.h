@@ -0,0 +1,202 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef LEMONADE_UPDATER_READ_BINARY_TRAJECTORY_H
+#define LEMONADE_UPDATER_READ_BINARY_TRAJECTORY_H
+/**
+ * @file
+ *
+ * @class UpdaterReadBinaryTrajectory
+ *
+ * @brief Updater reading a binary trajectory written by AnalyzerWriteBinaryTrajectory.
+ *
+ * @details initialize() sets up the system from the structure in the header: box,
+ * periodicity, the classic BFM bondset, monomers with attributes and movable tags,
+ * bonds and walls. The system has to be empty. Then a frame is read according to the
+ * mode:
+ * - READ_LAST_CONFIG reads the last frame, execute() does nothing and returns false
+ * - READ_STEPWISE reads the first frame, every execute() reads the next one and returns
+ *   false behind the last frame
+ *
+ * Thanks to the frame index any frame can be read directly with readFrame().
+ * createSystem() sets up a system from a structure alone, e.g. for the frames of a
+ * MappedBinaryTrajectory.
+ *
+ * @tparam IngredientsType
+ **/
+
+#include <stdexcept>
+#include <string>
+
+#include <LeMonADE/updater/AbstractUpdater.h>
+#include <LeMonADE/feature/FeatureWall.h>
+
+#include "BinaryTrajectory.h"
+
+
+template<class IngredientsType>
+class UpdaterReadBinaryTrajectory: public AbstractUpdater
+{
+public:
+
+  enum READ_MODE{
+    READ_LAST_CONFIG=0,
+    READ_STEPWISE=1
+  };
+
+  UpdaterReadBinaryTrajectory(const std::string& filename_, IngredientsType& ingredients_, int mode_=READ_LAST_CONFIG);
+
+  virtual void initialize();
+  virtual bool execute();
+  virtual void cleanup(){}
+
+  //! set the positions and the age of the system to frame n
+  void readFrame(uint64_t n);
+
+  uint64_t getNumberOfFrames() const { return reader.getNumberOfFrames(); }
+
+  //! index of the frame read last
+  uint64_t getCurrentFrame() const { return currentFrame; }
+
+  const BinaryTrajectoryReader& getReader() const { return reader; }
+
+  //! set up an empty system with the structure of a binary trajectory, without positions
+  static void createSystem(const BinaryTrajectoryStructure& structure, IngredientsType& ing);
+
+private:
+  //! reference to the system
+  IngredientsType& ingredients;
+
+  //! name of the input file
+  std::string filename;
+
+  //! READ_LAST_CONFIG or READ_STEPWISE
+  int mode;
+
+  BinaryTrajectoryReader reader;
+
+  uint64_t currentFrame;
+};
+
+
+/**
+ * @param filename_ binary trajectory
+ * @param ingredients_ empty system
+ * @param mode_ READ_LAST_CONFIG or READ_STEPWISE
+ */
+template<class IngredientsType>
+UpdaterReadBinaryTrajectory<IngredientsType>::UpdaterReadBinaryTrajectory(const std::string& filename_, IngredientsType& ingredients_, int mode_)
+:ingredients(ingredients_)
+,filename(filename_)
+,mode(mode_)
+,currentFrame(0)
+{
+  if(mode != READ_LAST_CONFIG && mode != READ_STEPWISE){
+    throw std::runtime_error("UpdaterReadBinaryTrajectory: unknown read mode");
+  }
+}
+
+template<class IngredientsType>
+void UpdaterReadBinaryTrajectory<IngredientsType>::initialize()
+{
+  reader.open(filename);
+  if(reader.getNumberOfFrames() == 0){
+    throw std::runtime_error("UpdaterReadBinaryTrajectory: "+filename+" contains no frame");
+  }
+  if(ingredients.getMolecules().size() != 0){
+    throw std::runtime_error("UpdaterReadBinaryTrajectory: the system is not empty");
+  }
+
+  createSystem(reader.getStructure(),ingredients);
+
+  currentFrame=(mode == READ_LAST_CONFIG) ? reader.getNumberOfFrames()-1 : 0;
+  reader.readFrame(currentFrame,ingredients.modifyMolecules());
+  ingredients.synchronize();
+}
+
+template<class IngredientsType>
+bool UpdaterReadBinaryTrajectory<IngredientsType>::execute()
+{
+  if(mode == READ_LAST_CONFIG || currentFrame+1 >= reader.getNumberOfFrames()){
+    return false;
+  }
+  readFrame(currentFrame+1);
+  return true;
+}
+
+/**
+ * @details Call synchronize() after setting the positions.
+ *
+ * @param structure structure of a binary trajectory
+ * @param ing empty system
+ */
+template<class IngredientsType>
+void UpdaterReadBinaryTrajectory<IngredientsType>::createSystem(const BinaryTrajectoryStructure& structure, IngredientsType& ing)
+{
+  ing.setBoxX(structure.box[0]);
+  ing.setBoxY(structure.box[1]);
+  ing.setBoxZ(structure.box[2]);
+
+  ing.setPeriodicX(structure.periodic[0] != 0);
+  ing.setPeriodicY(structure.periodic[1] != 0);
+  ing.setPeriodicZ(structure.periodic[2] != 0);
+
+  ing.modifyBondset().addBFMclassicBondset();
+
+  ing.modifyMolecules().resize(structure.nMonomers);
+  for(uint32_t i=0; i<structure.nMonomers; i++){
+    ing.modifyMolecules()[i].setAttributeTag(structure.attributes[i]);
+    ing.modifyMolecules()[i].setMovableTag(structure.movable[i] != 0);
+  }
+  for(uint32_t b=0; b<structure.bonds.size(); b+=2){
+    ing.modifyMolecules().connect(structure.bonds[b],structure.bonds[b+1]);
+  }
+
+  for(uint32_t w=0; w<structure.walls.size(); w+=6){
+    Wall wall;
+    wall.setBase(structure.walls[w],structure.walls[w+1],structure.walls[w+2]);
+    wall.setNormal(structure.walls[w+3],structure.walls[w+4],structure.walls[w+5]);
+    ing.addWall(wall);
+  }
+}
+
+/**
+ * @details The system is synchronized for every frame, which refills a lattice of
+ * the features. Converters which only copy the frames use an IngredientsType without
+ * lattice, as convertBinaryTrajectory does.
+ *
+ * @param n index of the frame
+ */
+template<class IngredientsType>
+void UpdaterReadBinaryTrajectory<IngredientsType>::readFrame(uint64_t n)
+{
+  reader.readFrame(n,ingredients.modifyMolecules());
+  currentFrame=n;
+  ingredients.synchronize();
+}
+
+#endif //LEMONADE_UPDATER_READ_BINARY_TRAJECTORY_H
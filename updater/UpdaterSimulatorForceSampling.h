@@ -0,0 +1,370 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef LEMONADE_UPDATER_SIMULATOR_FORCE_SAMPLING_H
+#define LEMONADE_UPDATER_SIMULATOR_FORCE_SAMPLING_H
+/**
+ * @file
+ *
+ * @class UpdaterSimulatorForceSampling
+ *
+ * @brief Simple simulator with local moves recording the jumps in z direction of
+ * selected monomers on the fly.
+ *
+ * @details The simulator works like UpdaterSimpleSimulator with MoveLocalSc. Every
+ * attempted move of a selected monomer in +z or -z direction is additionally checked
+ * with the ForceProbeKernel, i.e. for free lattice sites and valid bonds with the
+ * fixation and the walls ignored. Attempts and successful probes are counted for both
+ * directions and written to a file in cleanup(). The ratio of the probabilities
+ * p-/p+ = (n-/attempts-)/(n+/attempts+) gives the same force estimate as AnalyzerForce
+ * from a much larger sample. As in AnalyzerForce the estimate is NaN for monomers
+ * without an attempt or a jump in one of the directions.
+ *
+ * The moves are drawn from an own counter-based Philox4x32 stream instead of the static
+ * generator of RandomNumberGenerators, whose state can neither be stored nor be shared
+ * between threads. The stream is seeded from RandomNumberGenerators on construction, or
+ * with a master seed and stream ids in setSeed(). The random numbers of a complete mcs
+ * are generated in one batch. Together with the counters the state of the stream is
+ * part of the checkpoint, so a resumed run draws exactly the same moves.
+ *
+ * Monomers with movable tag false are never moved, so only the movable and the sampled
+ * monomers are drawn. One mcs is one attempt per drawn monomer on average, which keeps
+ * the time scale of the movable monomers. The system needs FeatureFixedMonomers.
+ *
+ * If the system uses the classic BFM bondset, moves breaking a bond are rejected with
+ * a BondMoveTable lookup before the feature checks of the move are run.
+ *
+ * @tparam IngredientsType
+ **/
+
+#include <ctime>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/updater/AbstractUpdater.h>
+#include <LeMonADE/updater/moves/MoveLocalSc.h>
+#include <LeMonADE/utility/RandomNumberGenerators.h>
+#include <LeMonADE/utility/ResultFormattingTools.h>
+
+#include "BondMoveTable.h"
+#include "ForceProbeKernel.h"
+#include "ForceProbeView.h"
+#include "Checkpoint.h"
+#include "Philox4x32.h"
+
+
+template<class IngredientsType>
+class UpdaterSimulatorForceSampling: public AbstractUpdater, public AbstractCheckpointable
+{
+public:
+  UpdaterSimulatorForceSampling(IngredientsType& ingredients_, uint32_t steps_, std::vector<uint32_t> sampledMonomers_, std::string filename_="force_sampling.dat");
+
+  virtual void initialize();
+  virtual bool execute();
+  virtual void cleanup();
+
+  //! seed the random number stream of the moves, e.g. with the replica index as stream0
+  void setSeed(uint64_t seed, uint32_t stream0=0, uint32_t stream1=0){ rng.setSeed(seed,stream0,stream1); }
+
+  //! switch the progress output of execute() on or off
+  void setVerbose(bool verbose_){ verbose=verbose_; }
+
+  //! append random number generator and counters to a checkpoint
+  virtual void saveState(CheckpointWriter& checkpoint) const;
+  //! restore random number generator and counters from a checkpoint
+  virtual void loadState(CheckpointReader& checkpoint);
+
+  //functions to get private variable for tests
+  const std::vector<uint64_t>& getAttemptsPlus() const { return attemptsPlus; }
+  const std::vector<uint64_t>& getAttemptsMinus() const { return attemptsMinus; }
+  const std::vector<uint64_t>& getCounterPlus() const { return counterPlus; }
+  const std::vector<uint64_t>& getCounterMinus() const { return counterMinus; }
+  const std::vector<uint32_t>& getActiveMonomers() const { return activeMonomers; }
+  bool getUseBondMoveTable() const { return useBondMoveTable; }
+
+private:
+  //! reference to the simulated system
+  IngredientsType& ingredients;
+
+  //! move used for the simulation
+  MoveLocalSc move;
+
+  //! random number stream for the moves
+  Philox4x32 rng;
+
+  //! random numbers of one mcs, monomer index and direction for every move
+  std::vector<uint32_t> randomBuffer;
+
+  //! indices of the monomers moves are attempted for: movable and sampled monomers
+  std::vector<uint32_t> activeMonomers;
+
+  //! the six possible jump directions
+  VectorInt3 steps[6];
+
+  //! moves keeping the bonds in the classic bondset, in the order of steps
+  BondMoveTable bondMoves;
+
+  //! true if the bondset of the system is the classic one and bondMoves can reject moves
+  bool useBondMoveTable;
+
+  //! print the progress in execute()
+  bool verbose;
+
+  //! number of mcs per execute
+  uint32_t nsteps;
+
+  //! monomer indices to sample
+  const std::vector<uint32_t> sampledMonomers;
+
+  //! output file for the results
+  std::string filename;
+
+  //! position in sampledMonomers for every monomer, -1 if not sampled
+  std::vector<int32_t> sampleSlot;
+
+  //! counters for attempted jumps and successful probes up and down for every sampled monomer
+  std::vector<uint64_t> attemptsPlus;
+  std::vector<uint64_t> attemptsMinus;
+  std::vector<uint64_t> counterPlus;
+  std::vector<uint64_t> counterMinus;
+
+  //! kernel and view for probing the jumps
+  ForceProbeKernel probeKernel;
+  ForceProbeView<IngredientsType> probeView;
+
+  //! helper function: record the current move if it is a z jump of a sampled monomer
+  void sampleMove();
+};
+
+/**
+* @brief Constructor handling the new systems paramters
+*
+* @param ingredients_ a reference to the IngredientsType - mainly the system
+* @param steps_ number of mcs per execute
+* @param sampledMonomers_ monomer indices to record the jumps in z direction for
+* @param filename_ output file for the jump statistics
+*/
+template<class IngredientsType>
+UpdaterSimulatorForceSampling<IngredientsType>::UpdaterSimulatorForceSampling(IngredientsType& ingredients_, uint32_t steps_, std::vector<uint32_t> sampledMonomers_, std::string filename_)
+:ingredients(ingredients_),useBondMoveTable(false),verbose(true),nsteps(steps_),sampledMonomers(sampledMonomers_),filename(filename_),
+attemptsPlus(sampledMonomers_.size()),attemptsMinus(sampledMonomers_.size()),
+counterPlus(sampledMonomers_.size()),counterMinus(sampledMonomers_.size()),
+probeView(ingredients_)
+{
+  RandomNumberGenerators randomNumbers;
+  const uint64_t seedHigh(randomNumbers.r250_rand32());
+  rng.setSeed((seedHigh<<32) | randomNumbers.r250_rand32());
+
+  steps[0]=VectorInt3( 1, 0, 0);
+  steps[1]=VectorInt3(-1, 0, 0);
+  steps[2]=VectorInt3( 0, 1, 0);
+  steps[3]=VectorInt3( 0,-1, 0);
+  steps[4]=VectorInt3( 0, 0, 1);
+  steps[5]=VectorInt3( 0, 0,-1);
+}
+
+/**
+* @brief Setup the lookup table from monomer index to sampled monomer and the list of
+* monomers to move
+*
+* @details Immobile monomers which are sampled stay in the list, their jump attempts are
+* part of the force estimate.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterSimulatorForceSampling<IngredientsType>::initialize(){
+  sampleSlot.assign(ingredients.getMolecules().size(),-1);
+  for(uint32_t i=0; i<sampledMonomers.size(); i++){
+    if(sampledMonomers[i] >= ingredients.getMolecules().size()){
+      throw std::runtime_error("UpdaterSimulatorForceSampling: sampled monomer index out of range");
+    }
+    sampleSlot[sampledMonomers[i]]=i;
+  }
+
+  activeMonomers.clear();
+  for(uint32_t i=0; i<ingredients.getMolecules().size(); i++){
+    if(ingredients.getMolecules()[i].getMovableTag() || sampleSlot[i] >= 0){
+      activeMonomers.push_back(i);
+    }
+  }
+
+  // the early rejection is only exact for the classic bondset
+  useBondMoveTable=(ingredients.getBondset().size() == 108);
+  for(int32_t x=-3; x<=3 && useBondMoveTable; x++){
+    for(int32_t y=-3; y<=3 && useBondMoveTable; y++){
+      for(int32_t z=-3; z<=3 && useBondMoveTable; z++){
+        const VectorInt3 bond(x,y,z);
+        if(bondMoves.isClassicBond(bond) && !ingredients.getBondset().isValid(bond)){
+          useBondMoveTable=false;
+        }
+      }
+    }
+  }
+}
+
+/**
+* @brief Run nsteps mcs and record the jumps of the sampled monomers
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+bool UpdaterSimulatorForceSampling<IngredientsType>::execute(){
+  if(sampleSlot.size() != ingredients.getMolecules().size()){
+    initialize();
+  }
+
+  time_t startTimer = time(NULL);
+  if(verbose){
+    std::cout<<"mcs "<<ingredients.getMolecules().getAge() << " passed time " << ((difftime(time(NULL), startTimer)) ) <<std::endl;
+  }
+
+  const uint32_t nActive(activeMonomers.size());
+  randomBuffer.resize(2*nActive);
+
+  for(uint32_t n=0; n<nsteps; n++){
+    if(nActive > 0){
+      rng.fill(&randomBuffer[0], randomBuffer.size());
+    }
+    for(uint32_t m=0; m<nActive; m++){
+      const uint32_t index(activeMonomers[Philox4x32::scale(randomBuffer[2*m], nActive)]);
+      const uint32_t direction(Philox4x32::scale(randomBuffer[2*m+1], 6));
+      move.init(ingredients, index, steps[direction]);
+      sampleMove();
+      if(useBondMoveTable && ((bondMoves.getAllowedMoves(ingredients.getMolecules(), index) >> direction) & 1)==0){
+        continue;
+      }
+      if(move.check(ingredients)==true){
+        move.apply(ingredients);
+      }
+    }
+  }
+  ingredients.modifyMolecules().setAge(ingredients.getMolecules().getAge()+nsteps);
+
+  if(verbose){
+    std::cout<<"mcs "<<ingredients.getMolecules().getAge() << " with " << (((1.0*nsteps)*nActive)/(difftime(time(NULL), startTimer)) ) << " [attempted moves/s]" <<std::endl;
+  }
+
+  return true;
+}
+
+/**
+* @brief Write the jump statistics of the sampled monomers
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterSimulatorForceSampling<IngredientsType>::cleanup(){
+  if(sampledMonomers.empty()){
+    return;
+  }
+
+  std::vector<std::vector<double> > tmpResults(6,std::vector<double>());
+
+  for(uint32_t i=0; i<sampledMonomers.size(); i++){
+    tmpResults[0].push_back(sampledMonomers.at(i));
+    tmpResults[1].push_back(attemptsMinus.at(i));
+    tmpResults[2].push_back(counterMinus.at(i));
+    tmpResults[3].push_back(attemptsPlus.at(i));
+    tmpResults[4].push_back(counterPlus.at(i));
+    const bool isDefined(counterMinus.at(i) > 0 && counterPlus.at(i) > 0);
+    tmpResults[5].push_back(isDefined ? log( (double(counterMinus.at(i))/double(attemptsMinus.at(i))) / (double(counterPlus.at(i))/double(attemptsPlus.at(i))) )
+                                      : std::numeric_limits<double>::quiet_NaN());
+  }
+
+  std::stringstream comment;
+  comment << "# Force sampled in UpdaterSimulatorForceSampling" << std::endl
+          << "# jump attempts in z direction of sampled monomers during the simulation" << std::endl
+          << "# log(p-/p+) is nan for monomers without jumps in one direction" << std::endl
+          << "# idxMonomer\tattempts-\tn-\tattempts+\tn+\tlog(p-/p+)";
+
+  ResultFormattingTools::writeResultFile(filename, ingredients, tmpResults, comment.str());
+}
+
+/**
+* @details The probe runs before the move is checked, i.e. on the configuration the
+* move is attempted from.
+*
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+inline void UpdaterSimulatorForceSampling<IngredientsType>::sampleMove(){
+  const int32_t slot(sampleSlot[move.getIndex()]);
+  if(slot < 0 || move.getDir().getZ() == 0){
+    return;
+  }
+
+  if(move.getDir().getZ() > 0){
+    attemptsPlus[slot]++;
+    if(probeKernel.checkJump(probeView, move.getIndex(), move.getDir())){
+      counterPlus[slot]++;
+    }
+  }else{
+    attemptsMinus[slot]++;
+    if(probeKernel.checkJump(probeView, move.getIndex(), move.getDir())){
+      counterMinus[slot]++;
+    }
+  }
+}
+
+/**
+* @tparam IngredientsType Features used in the system. See Ingredients.
+*/
+template<class IngredientsType>
+void UpdaterSimulatorForceSampling<IngredientsType>::saveState(CheckpointWriter& checkpoint) const{
+  checkpoint.write(rng.getState());
+
+  checkpoint.writeVector(sampledMonomers);
+  checkpoint.writeVector(attemptsPlus);
+  checkpoint.writeVector(attemptsMinus);
+  checkpoint.writeVector(counterPlus);
+  checkpoint.writeVector(counterMinus);
+}
+
+template<class IngredientsType>
+void UpdaterSimulatorForceSampling<IngredientsType>::loadState(CheckpointReader& checkpoint){
+  Philox4x32::State rngState;
+  checkpoint.read(rngState);
+  rng.setState(rngState);
+
+  std::vector<uint32_t> savedMonomers;
+  checkpoint.readVector(savedMonomers);
+  if(savedMonomers != sampledMonomers){
+    throw std::runtime_error("UpdaterSimulatorForceSampling: checkpoint was written for different sampled monomers");
+  }
+  checkpoint.readVector(attemptsPlus);
+  checkpoint.readVector(attemptsMinus);
+  checkpoint.readVector(counterPlus);
+  checkpoint.readVector(counterMinus);
+}
+
+#endif /* LEMONADE_UPDATER_SIMULATOR_FORCE_SAMPLING_H */
@@ -0,0 +1,350 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef BFM_FRAME_INDEX_H
+#define BFM_FRAME_INDEX_H
+/**
+* @file
+*
+* @class BfmFrameIndex
+*
+* @brief Byte offsets and mcs of the frames of a text bfm trajectory.
+*
+* @details A frame of a bfm file starts with a line !mcs=<age>, everything in front of
+* the first frame is the header. The index is kept in a sidecar file <bfm file>.idx,
+* which holds a magic number followed by offset and mcs of every frame, so new frames
+* are appended to it without rewriting it.
+*
+* update() makes the index match the bfm file:
+* - a missing or unreadable sidecar is rebuilt by a scan of the complete bfm file
+* - a stale sidecar, e.g. of a replaced bfm file, is detected by checking that the first
+*   and the last indexed offset hold the indexed !mcs line, and is rebuilt
+* - frames appended behind the last indexed frame are added by a scan of the new
+*   part of the file only
+*
+* The sidecar is a cache: if it cannot be written the index still works in memory.
+**/
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+class BfmFrameIndex
+{
+public:
+
+    explicit BfmFrameIndex(const std::string& bfmFilename_);
+
+    //! name of the sidecar file of a bfm file
+    static std::string getIndexFilename(const std::string& bfmFilename) { return bfmFilename+".idx"; }
+
+    //! read, check and extend the index, returns the number of frames added
+    uint64_t update();
+
+    //! scan the complete bfm file and replace the sidecar
+    void rebuild();
+
+    //! cut the bfm file behind the last frame with mcs not larger than mcs, returns the number of removed frames
+    uint64_t removeFramesAfter(uint64_t mcs);
+
+    uint64_t getNumberOfFrames() const { return frameOffsets.size(); }
+
+    //! offset of the !mcs line of frame n
+    uint64_t getOffset(uint64_t n) const { return frameOffsets.at(n); }
+
+    //! mcs of frame n
+    uint64_t getMcs(uint64_t n) const { return frameMcs.at(n); }
+
+    //! offset behind frame n
+    uint64_t getFrameEnd(uint64_t n) const { return (n+1 < frameOffsets.size()) ? frameOffsets[n+1] : scannedEnd; }
+
+    //! size of the header in front of the first frame
+    uint64_t getHeaderSize() const { return frameOffsets.empty() ? scannedEnd : frameOffsets[0]; }
+
+    //! index of the last frame with mcs not larger than mcs, throws if there is none
+    uint64_t findFrame(uint64_t mcs) const;
+
+    //! true if the last update() read a valid sidecar instead of rebuilding it
+    bool isSidecarUsed() const { return sidecarUsed; }
+
+    //! write header and frame n of the bfm file to filename, a bfm file with one frame
+    void extractFrame(uint64_t n, const std::string& filename) const;
+
+    const std::string& getBfmFilename() const { return bfmFilename; }
+
+private:
+
+    //! read the sidecar, returns false if it is missing or damaged
+    bool loadSidecar();
+
+    //! check the first and the last indexed frame against the bfm file
+    bool isConsistent() const;
+
+    //! add the frames starting behind offset begin, returns the number of frames added
+    uint64_t scan(uint64_t begin);
+
+    //! append the frames from index first on to the sidecar, replace it if truncate is set
+    void writeSidecar(uint64_t first, bool truncate) const;
+
+    //! helper function: true if the line at offset is !mcs=mcs
+    bool isFrameStart(std::ifstream& file, uint64_t offset, uint64_t mcs) const;
+
+    //! helper function: parse a line !mcs=<age>, returns false for other lines
+    static bool parseMcsLine(const std::string& line, uint64_t& mcs);
+
+    static const uint64_t sidecarMagic=0x31305844494d4642ull;  // "BFMIDX01"
+
+    std::string bfmFilename;
+
+    std::vector<uint64_t> frameOffsets;
+    std::vector<uint64_t> frameMcs;
+
+    //! offset behind the last complete line scanned
+    uint64_t scannedEnd;
+
+    bool sidecarUsed;
+};
+
+
+inline BfmFrameIndex::BfmFrameIndex(const std::string& bfmFilename_)
+:bfmFilename(bfmFilename_)
+,scannedEnd(0)
+,sidecarUsed(false)
+{
+}
+
+/**
+* @details Without a sidecar or after an earlier update() only the part of the bfm
+* file behind the last indexed frame is read.
+*/
+inline uint64_t BfmFrameIndex::update()
+{
+    if(scannedEnd == 0){
+        sidecarUsed=(loadSidecar() && isConsistent());
+        if(!sidecarUsed){
+            rebuild();
+            return frameOffsets.size();
+        }
+        // the last indexed frame is scanned again to find its end
+        scannedEnd=frameOffsets.empty() ? 0 : frameOffsets.back();
+    }else if(!isConsistent()){
+        rebuild();
+        return frameOffsets.size();
+    }
+
+    const uint64_t nIndexed(frameOffsets.size());
+    const uint64_t nAdded(scan(scannedEnd));
+    if(nAdded > 0){
+        writeSidecar(nIndexed, false);
+    }
+    return nAdded;
+}
+
+inline void BfmFrameIndex::rebuild()
+{
+    frameOffsets.clear();
+    frameMcs.clear();
+    scannedEnd=0;
+    scan(0);
+    writeSidecar(0, true);
+}
+
+/**
+* @details The index is brought up to date first, the sidecar is replaced afterwards.
+* Used to discard the frames written after a checkpoint of the run.
+*
+* @param mcs age of the last frame kept
+*/
+inline uint64_t BfmFrameIndex::removeFramesAfter(uint64_t mcs)
+{
+    update();
+    const uint64_t nKept(std::upper_bound(frameMcs.begin(), frameMcs.end(), mcs)-frameMcs.begin());
+    const uint64_t nRemoved(frameOffsets.size()-nKept);
+    if(nRemoved == 0){
+        return 0;
+    }
+
+    const uint64_t end(frameOffsets[nKept]);
+    if(::truncate(bfmFilename.c_str(), end) != 0){
+        throw std::runtime_error("BfmFrameIndex: cannot truncate "+bfmFilename);
+    }
+    frameOffsets.resize(nKept);
+    frameMcs.resize(nKept);
+    scannedEnd=end;
+    writeSidecar(0, true);
+    return nRemoved;
+}
+
+/**
+* @param mcs age to search for
+*/
+inline uint64_t BfmFrameIndex::findFrame(uint64_t mcs) const
+{
+    const std::vector<uint64_t>::const_iterator it(std::upper_bound(frameMcs.begin(), frameMcs.end(), mcs));
+    if(it == frameMcs.begin()){
+        throw std::runtime_error("BfmFrameIndex: no frame of "+bfmFilename+" up to the requested mcs");
+    }
+    return (it-frameMcs.begin())-1;
+}
+
+/**
+* @details Frames of the bfm files of this project contain the complete positions, so
+* header and one frame make up a valid bfm file.
+*
+* @param n index of the frame
+* @param filename output file, it is replaced
+*/
+inline void BfmFrameIndex::extractFrame(uint64_t n, const std::string& filename) const
+{
+    const uint64_t begin(getOffset(n)), end(getFrameEnd(n));
+
+    std::ifstream in(bfmFilename.c_str(), std::ios::binary);
+    std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+    if(!in.is_open() || !out.is_open()){
+        throw std::runtime_error("BfmFrameIndex: cannot copy frame of "+bfmFilename+" to "+filename);
+    }
+
+    std::vector<char> buffer(std::max(getHeaderSize(), end-begin));
+    in.read(buffer.data(), getHeaderSize());
+    out.write(buffer.data(), getHeaderSize());
+    in.seekg(begin);
+    in.read(buffer.data(), end-begin);
+    out.write(buffer.data(), end-begin);
+
+    if(!in.good() || !out.good()){
+        throw std::runtime_error("BfmFrameIndex: cannot copy frame of "+bfmFilename+" to "+filename);
+    }
+}
+
+inline bool BfmFrameIndex::loadSidecar()
+{
+    frameOffsets.clear();
+    frameMcs.clear();
+    scannedEnd=0;
+
+    std::ifstream file(getIndexFilename(bfmFilename).c_str(), std::ios::binary);
+    uint64_t magic(0);
+    if(!file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) || magic != sidecarMagic){
+        return false;
+    }
+
+    uint64_t entry[2];
+    while(file.read(reinterpret_cast<char*>(entry), sizeof(entry))){
+        if(!frameOffsets.empty() && entry[0] <= frameOffsets.back()){
+            return false;
+        }
+        frameOffsets.push_back(entry[0]);
+        frameMcs.push_back(entry[1]);
+    }
+    // an incomplete entry of a killed writer is damage
+    return file.gcount() == 0;
+}
+
+inline bool BfmFrameIndex::isConsistent() const
+{
+    if(frameOffsets.empty()){
+        return false;
+    }
+    std::ifstream file(bfmFilename.c_str(), std::ios::binary);
+    return file.is_open() &&
+           isFrameStart(file, frameOffsets.front(), frameMcs.front()) &&
+           isFrameStart(file, frameOffsets.back(), frameMcs.back());
+}
+
+/**
+* @details Only lines terminated by a line break are taken, so a frame the writer is
+* still working on is found by the next scan.
+*
+* @param begin offset of a line start
+*/
+inline uint64_t BfmFrameIndex::scan(uint64_t begin)
+{
+    std::ifstream file(bfmFilename.c_str(), std::ios::binary);
+    if(!file.is_open()){
+        throw std::runtime_error("BfmFrameIndex: cannot open "+bfmFilename);
+    }
+    file.seekg(begin);
+
+    const uint64_t nIndexed(frameOffsets.size());
+    uint64_t offset(begin);
+    std::string line;
+    while(std::getline(file, line) && !file.eof()){
+        uint64_t mcs(0);
+        if(parseMcsLine(line, mcs) && (frameOffsets.empty() || offset > frameOffsets.back())){
+            frameOffsets.push_back(offset);
+            frameMcs.push_back(mcs);
+        }
+        offset+=line.size()+1;
+    }
+    scannedEnd=offset;
+    return frameOffsets.size()-nIndexed;
+}
+
+inline void BfmFrameIndex::writeSidecar(uint64_t first, bool truncate) const
+{
+    std::ofstream file(getIndexFilename(bfmFilename).c_str(), std::ios::binary | (truncate ? std::ios::trunc : std::ios::app));
+    if(!file.is_open()){
+        return;
+    }
+    if(truncate){
+        const uint64_t magic(sidecarMagic);
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    }
+    for(uint64_t n=first; n<frameOffsets.size(); n++){
+        const uint64_t entry[2]={frameOffsets[n], frameMcs[n]};
+        file.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+    }
+}
+
+inline bool BfmFrameIndex::isFrameStart(std::ifstream& file, uint64_t offset, uint64_t mcs) const
+{
+    file.clear();
+    file.seekg(offset);
+    std::string line;
+    uint64_t lineMcs(0);
+    return std::getline(file, line) && parseMcsLine(line, lineMcs) && lineMcs == mcs;
+}
+
+inline bool BfmFrameIndex::parseMcsLine(const std::string& line, uint64_t& mcs)
+{
+    if(line.compare(0, 5, "!mcs=") != 0){
+        return false;
+    }
+    char* end(0);
+    mcs=std::strtoull(line.c_str()+5, &end, 10);
+    return end != line.c_str()+5;
+}
+
+#endif //BFM_FRAME_INDEX_H
@@ -0,0 +1,145 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+#ifndef BFM_TRAJECTORY_H
+#define BFM_TRAJECTORY_H
+/**
+* @file
+*
+* @class BfmTrajectory
+*
+* @brief Frames of a bfm trajectory read through its frame index, for offline analysis.
+*
+* @details Counterpart of MappedBinaryTrajectory for bfm files, e.g. as trajectory of
+* ForceTrajectoryEvaluator. The frames are looked up in the sidecar index of the file,
+* see BfmFrameIndex, and read by UpdaterReadBfmFileIndexed::readFrame(), so any frame is
+* read without scanning the file. The structure is taken from the first frame.
+*
+* Every thread reads the frames with its own FrameReader, which keeps a system of
+* ReadIngredientsType the frames are parsed into. ReadIngredientsType needs the
+* features reading the bfm file but no lattice, so parsing a frame does not allocate
+* one.
+*
+* @tparam ReadIngredientsType
+**/
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "AnalyzerWriteBinaryTrajectory.h"
+#include "BfmFrameIndex.h"
+#include "BinaryTrajectory.h"
+#include "UpdaterReadBfmFileIndexed.h"
+
+
+template<class ReadIngredientsType>
+class BfmTrajectory
+{
+public:
+
+    /**
+    * @brief Read the positions of frames of a BfmTrajectory, one reader per thread.
+    **/
+    class FrameReader
+    {
+    public:
+        explicit FrameReader(const BfmTrajectory& trajectory_):trajectory(trajectory_){}
+
+        //! positions of frame n
+        const std::vector<VectorInt3>& read(uint64_t n);
+
+    private:
+        const BfmTrajectory& trajectory;
+
+        //! system the frames are parsed into, set up by the first frame
+        ReadIngredientsType ingredients;
+
+        std::vector<VectorInt3> positions;
+    };
+
+    //! index the bfm file and read its structure
+    explicit BfmTrajectory(const std::string& filename);
+
+    //! always true, the constructor throws if the file cannot be read
+    bool isOpen() const { return true; }
+
+    const BinaryTrajectoryStructure& getStructure() const { return structure; }
+
+    uint64_t getNumberOfFrames() const { return index.getNumberOfFrames(); }
+
+    //! mcs of frame n
+    uint64_t getMcs(uint64_t n) const { return index.getMcs(n); }
+
+    const BfmFrameIndex& getIndex() const { return index; }
+
+private:
+
+    BfmFrameIndex index;
+
+    BinaryTrajectoryStructure structure;
+};
+
+
+/**
+* @details The sidecar index is created or brought up to date.
+*
+* @param filename bfm file
+*/
+template<class ReadIngredientsType>
+BfmTrajectory<ReadIngredientsType>::BfmTrajectory(const std::string& filename)
+:index(filename)
+{
+    index.update();
+    if(index.getNumberOfFrames() == 0){
+        throw std::runtime_error("BfmTrajectory: "+filename+" contains no frame");
+    }
+    ReadIngredientsType ing;
+    UpdaterReadBfmFileIndexed<ReadIngredientsType>::readFrame(index, 0, ing);
+    structure=AnalyzerWriteBinaryTrajectory<ReadIngredientsType>::getStructure(ing);
+}
+
+/**
+* @param n index of the frame
+*/
+template<class ReadIngredientsType>
+const std::vector<VectorInt3>& BfmTrajectory<ReadIngredientsType>::FrameReader::read(uint64_t n)
+{
+    UpdaterReadBfmFileIndexed<ReadIngredientsType>::readFrame(trajectory.getIndex(), n, ingredients);
+    if(ingredients.getMolecules().size() != trajectory.getStructure().nMonomers){
+        throw std::runtime_error("BfmTrajectory: number of monomers differs from the first frame");
+    }
+    positions.resize(ingredients.getMolecules().size());
+    for(uint32_t i=0; i<positions.size(); i++){
+        positions[i]=VectorInt3(ingredients.getMolecules()[i]);
+    }
+    return positions;
+}
+
+#endif //BFM_TRAJECTORY_H
@@ -0,0 +1,968 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef BINARY_TRAJECTORY_H
+#define BINARY_TRAJECTORY_H
+/**
+* @file
+*
+* @brief Compact binary trajectory format for chains with classic BFM bonds.
+*
+* @details A binary trajectory (.btr) stores the structure of the system once and every
+* frame as the position of the first monomer followed by one byte per further monomer:
+* the code of the classic bond vector from the previous monomer, see BondVectorCode. If
+* the vector is not part of the classic bondset, e.g. between two chains, the escape code
+* is followed by the absolute position. For a linear chain a frame takes about one
+* byte per monomer instead of about 15 in the text bfm format.
+*
+* Layout of the file, all values in native byte order as in Checkpoint.h:
+* - header: fileMagic, version, size and content of the BinaryTrajectoryStructure
+* - frames: recordMagic, size of the raw frame, mcs, stored size, stored frame
+* - index: offset and mcs of every frame, offset of the index, number of frames, indexMagic
+*
+* A frame is compressed with zlib if compression is requested, the program is built with
+* TANGLOTRON_WITH_ZLIB and the frame gets smaller. It is stored raw otherwise, so stored
+* size and raw size tell if a frame has to be uncompressed.
+*
+* The index is written when the writer is closed. If it is missing, e.g. after a killed
+* run, BinaryTrajectoryReader rebuilds it by stepping through the frame records.
+**/
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef TANGLOTRON_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "BondMoveTable.h"
+#include "Checkpoint.h"
+
+
+/**
+* @class BondVectorCode
+*
+* @brief Numbering of the 108 classic BFM bond vectors by codes 0 to 107.
+*
+* @details The vectors are numbered in lexicographic order of (x,y,z). The numbering is
+* part of the file format and must not change.
+**/
+class BondVectorCode
+{
+public:
+
+    BondVectorCode();
+
+    //! code of bond vectors which are not part of the classic bondset
+    static const uint8_t escapeCode=127;
+
+    //! code of a bond vector, escapeCode if it is not classic
+    uint8_t encode(const VectorInt3& bond) const
+    {
+        return isInRange(bond) ? codes[index(bond)] : escapeCode;
+    }
+
+    //! bond vector of a code smaller than getNumberOfCodes()
+    const VectorInt3& decode(uint8_t code) const { return bonds[code]; }
+
+    uint32_t getNumberOfCodes() const { return bonds.size(); }
+
+private:
+
+    //! components in [-3,3]
+    static bool isInRange(const VectorInt3& bond)
+    {
+        return uint32_t(bond.getX()+3) <= 6 && uint32_t(bond.getY()+3) <= 6 && uint32_t(bond.getZ()+3) <= 6;
+    }
+
+    static uint32_t index(const VectorInt3& bond)
+    {
+        return uint32_t(bond.getX()+3) + 7*uint32_t(bond.getY()+3) + 49*uint32_t(bond.getZ()+3);
+    }
+
+    //! codes indexed by index()
+    std::vector<uint8_t> codes;
+
+    //! bond vectors indexed by code
+    std::vector<VectorInt3> bonds;
+};
+
+
+/**
+* @class BinaryTrajectoryStructure
+*
+* @brief Constant part of a system stored in the header of a binary trajectory.
+*
+* @details The bondset is not stored, a binary trajectory always uses the classic
+* BFM bondset.
+**/
+class BinaryTrajectoryStructure
+{
+public:
+
+    BinaryTrajectoryStructure():nMonomers(0)
+    {
+        box[0]=box[1]=box[2]=0;
+        periodic[0]=periodic[1]=periodic[2]=1;
+    }
+
+    uint32_t nMonomers;
+    int32_t box[3];
+    uint8_t periodic[3];
+
+    //! pairs of connected monomers
+    std::vector<uint32_t> bonds;
+
+    //! attribute tag of every monomer
+    std::vector<int32_t> attributes;
+
+    //! movable tag of every monomer
+    std::vector<uint8_t> movable;
+
+    //! base and normal of every wall, six values per wall
+    std::vector<int32_t> walls;
+
+    void save(CheckpointWriter& buffer) const;
+    void load(CheckpointReader& buffer);
+
+    //! name of the first part differing from other, empty if the structures are equal
+    std::string difference(const BinaryTrajectoryStructure& other) const;
+};
+
+
+/**
+* @class BinaryTrajectoryCodec
+*
+* @brief Encoding, compression and constants shared by the reader and the writer.
+**/
+class BinaryTrajectoryCodec
+{
+public:
+
+    static const uint64_t fileMagic=0x31305254424d4642ull;   // "BFMBTR01"
+    static const uint64_t indexMagic=0x5845444e49525442ull;  // "BTRINDEX"
+    static const uint32_t recordMagic=0x454d5246u;           // "FRME"
+    static const uint32_t version=1;
+
+    //! size of the record header in front of every stored frame
+    static const uint32_t recordHeaderSize=20;
+
+    //! size of one index entry and of the trailer behind the index
+    static const uint32_t indexEntrySize=16;
+    static const uint32_t trailerSize=24;
+
+    //! true if the program is built with TANGLOTRON_WITH_ZLIB
+    static bool isCompressionAvailable();
+
+    //! encode the positions of molecules into raw
+    template<class MoleculesType>
+    void encode(const MoleculesType& molecules, std::vector<char>& raw) const;
+
+    //! decode a raw frame of nMonomers monomers into positions
+    void decode(const char* raw, size_t rawSize, uint32_t nMonomers, std::vector<VectorInt3>& positions) const;
+
+    //! compress raw into stored, returns false if the frame is stored raw
+    bool compress(const std::vector<char>& raw, std::vector<char>& stored) const;
+
+    //! uncompress a stored frame of known raw size
+    void uncompress(const char* stored, size_t storedSize, std::vector<char>& raw, size_t rawSize) const;
+
+private:
+
+    //! helper function: append three int32 values
+    static void appendPosition(std::vector<char>& raw, int32_t x, int32_t y, int32_t z)
+    {
+        const int32_t values[3]={x,y,z};
+        const char* bytes(reinterpret_cast<const char*>(values));
+        raw.insert(raw.end(), bytes, bytes+sizeof(values));
+    }
+
+    BondVectorCode bondCode;
+};
+
+
+/**
+* @class BinaryTrajectoryWriter
+*
+* @brief Write frames to a binary trajectory.
+**/
+class BinaryTrajectoryWriter
+{
+public:
+
+    BinaryTrajectoryWriter():nMonomers(0),compression(false),endOfFrames(0),nRawBytes(0),nStoredBytes(0){}
+
+    //! closes the file, errors are not reported
+    ~BinaryTrajectoryWriter();
+
+    //! create filename, or append to it if it exists and append is true
+    void open(const std::string& filename_, const BinaryTrajectoryStructure& structure, bool append);
+
+    //! compress the following frames, throws if zlib is not available
+    void setCompression(bool compression_);
+    bool getCompression() const { return compression; }
+
+    //! append the positions and the age of molecules as a frame
+    template<class MoleculesType>
+    void writeFrame(const MoleculesType& molecules);
+
+    //! write the index and close the file
+    void close();
+
+    //! remove the frames with an mcs larger than mcs from the open file, returns their number
+    uint64_t removeFramesAfter(uint64_t mcs);
+
+    bool isOpen() const { return file.is_open(); }
+
+    //! number of frames in the file including frames of earlier runs
+    uint64_t getNumberOfFrames() const { return frameOffsets.size(); }
+
+    //! bytes of the frames written by this writer before and after compression
+    uint64_t getRawBytes() const { return nRawBytes; }
+    uint64_t getStoredBytes() const { return nStoredBytes; }
+
+private:
+
+    std::string filename;
+    std::fstream file;
+
+    uint32_t nMonomers;
+    bool compression;
+
+    //! file position behind the last frame
+    uint64_t endOfFrames;
+
+    //! offset and mcs of every frame
+    std::vector<uint64_t> frameOffsets;
+    std::vector<uint64_t> frameMcs;
+
+    uint64_t nRawBytes;
+    uint64_t nStoredBytes;
+
+    BinaryTrajectoryCodec codec;
+
+    //! buffers reused for every frame
+    std::vector<char> raw;
+    std::vector<char> stored;
+};
+
+
+/**
+* @class BinaryTrajectoryFrameTable
+*
+* @brief Offset and mcs of every frame of a binary trajectory.
+*
+* @details The table is read from the index behind the frames or, if there is no valid
+* index, rebuilt by stepping through the frame records. Shared by BinaryTrajectoryReader
+* and MappedBinaryTrajectory, which provide the bytes of the file by a member
+* readBytes(offset,dest,n).
+**/
+class BinaryTrajectoryFrameTable
+{
+public:
+
+    BinaryTrajectoryFrameTable():endOfFrames(0){}
+
+    //! read the index or scan the frames, returns true if the index was found
+    template<class SourceType>
+    bool load(SourceType& source, uint64_t beginOfFrames, uint64_t fileSize);
+
+    //! file offset of the record of every frame
+    std::vector<uint64_t> offsets;
+
+    //! mcs of every frame
+    std::vector<uint64_t> mcs;
+
+    //! file position behind the last complete frame
+    uint64_t endOfFrames;
+
+private:
+
+    //! read the index behind the frames, returns false if there is no valid index
+    template<class SourceType>
+    bool readIndex(SourceType& source, uint64_t beginOfFrames, uint64_t fileSize);
+
+    //! step through the frame records
+    template<class SourceType>
+    void scanFrames(SourceType& source, uint64_t beginOfFrames, uint64_t fileSize);
+};
+
+
+/**
+* @class BinaryTrajectoryReader
+*
+* @brief Read frames of a binary trajectory in any order.
+**/
+class BinaryTrajectoryReader
+{
+public:
+
+    BinaryTrajectoryReader():indexFound(false),beginOfFrames(0),fileSize(0){}
+
+    //! read header and index, rebuild the index if it is missing
+    void open(const std::string& filename_);
+
+    const BinaryTrajectoryStructure& getStructure() const { return structure; }
+
+    uint64_t getNumberOfFrames() const { return frames.offsets.size(); }
+
+    //! mcs of frame n
+    uint64_t getMcs(uint64_t n) const { return frames.mcs.at(n); }
+
+    //! file offset of the record of frame n
+    uint64_t getFrameOffset(uint64_t n) const { return frames.offsets.at(n); }
+
+    //! true if the index was read from the file, false if it was rebuilt
+    bool hasIndex() const { return indexFound; }
+
+    //! file position behind the last complete frame
+    uint64_t getEndOfFrames() const { return frames.endOfFrames; }
+
+    //! file size at open()
+    uint64_t getFileSize() const { return fileSize; }
+
+    //! positions of frame n
+    void readFrame(uint64_t n, std::vector<VectorInt3>& positions);
+
+    //! set positions and age of molecules to frame n
+    template<class MoleculesType>
+    void readFrame(uint64_t n, MoleculesType& molecules);
+
+private:
+
+    friend class BinaryTrajectoryFrameTable;
+
+    //! helper function: read n bytes at offset
+    void readBytes(uint64_t offset, void* dest, size_t n);
+
+    std::string filename;
+    std::ifstream file;
+
+    BinaryTrajectoryStructure structure;
+
+    bool indexFound;
+    uint64_t beginOfFrames;
+    uint64_t fileSize;
+
+    BinaryTrajectoryFrameTable frames;
+
+    BinaryTrajectoryCodec codec;
+
+    //! buffers reused for every frame
+    std::vector<char> raw;
+    std::vector<char> stored;
+    std::vector<VectorInt3> positions;
+};
+
+
+/* ------------------------------------------------------------------------------ */
+
+inline BondVectorCode::BondVectorCode():codes(343,uint8_t(escapeCode))
+{
+    const BondMoveTable classic;
+    for(int32_t x=-3; x<=3; x++){
+        for(int32_t y=-3; y<=3; y++){
+            for(int32_t z=-3; z<=3; z++){
+                const VectorInt3 bond(x,y,z);
+                if(classic.isClassicBond(bond)){
+                    codes[index(bond)]=uint8_t(bonds.size());
+                    bonds.push_back(bond);
+                }
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------------ */
+
+inline void BinaryTrajectoryStructure::save(CheckpointWriter& buffer) const
+{
+    buffer.write(nMonomers);
+    for(uint32_t d=0; d<3; d++){
+        buffer.write(box[d]);
+        buffer.write(periodic[d]);
+    }
+    buffer.writeVector(bonds);
+    buffer.writeVector(attributes);
+    buffer.writeVector(movable);
+    buffer.writeVector(walls);
+}
+
+inline void BinaryTrajectoryStructure::load(CheckpointReader& buffer)
+{
+    buffer.read(nMonomers);
+    for(uint32_t d=0; d<3; d++){
+        buffer.read(box[d]);
+        buffer.read(periodic[d]);
+    }
+    buffer.readVector(bonds);
+    buffer.readVector(attributes);
+    buffer.readVector(movable);
+    buffer.readVector(walls);
+
+    if(attributes.size() != nMonomers || movable.size() != nMonomers || bonds.size()%2 != 0 || walls.size()%6 != 0){
+        throw std::runtime_error("BinaryTrajectoryStructure: inconsistent structure");
+    }
+    for(uint32_t b=0; b<bonds.size(); b++){
+        if(bonds[b] >= nMonomers){
+            throw std::runtime_error("BinaryTrajectoryStructure: bond to a monomer which does not exist");
+        }
+    }
+}
+
+/**
+* @param other structure to compare with
+* @return "number of monomers", "box", "periodicity", "bonds", "attributes", "movable
+* tags", "walls" or an empty string
+*/
+inline std::string BinaryTrajectoryStructure::difference(const BinaryTrajectoryStructure& other) const
+{
+    if(nMonomers != other.nMonomers){
+        return "number of monomers";
+    }
+    for(uint32_t d=0; d<3; d++){
+        if(box[d] != other.box[d]){
+            return "box";
+        }
+        if(periodic[d] != other.periodic[d]){
+            return "periodicity";
+        }
+    }
+    if(bonds != other.bonds){
+        return "bonds";
+    }
+    if(attributes != other.attributes){
+        return "attributes";
+    }
+    if(movable != other.movable){
+        return "movable tags";
+    }
+    if(walls != other.walls){
+        return "walls";
+    }
+    return std::string();
+}
+
+/* ------------------------------------------------------------------------------ */
+
+inline bool BinaryTrajectoryCodec::isCompressionAvailable()
+{
+#ifdef TANGLOTRON_WITH_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+* @param molecules positions to encode, monomers are taken in index order
+* @param raw buffer which is replaced by the frame
+*/
+template<class MoleculesType>
+inline void BinaryTrajectoryCodec::encode(const MoleculesType& molecules, std::vector<char>& raw) const
+{
+    raw.clear();
+    if(molecules.size() == 0){
+        return;
+    }
+
+    VectorInt3 previous(molecules[0]);
+    appendPosition(raw, previous.getX(), previous.getY(), previous.getZ());
+
+    for(uint32_t i=1; i<molecules.size(); i++){
+        const VectorInt3 current(molecules[i]);
+        const uint8_t code(bondCode.encode(current-previous));
+        raw.push_back(char(code));
+        if(code == BondVectorCode::escapeCode){
+            appendPosition(raw, current.getX(), current.getY(), current.getZ());
+        }
+        previous=current;
+    }
+}
+
+/**
+* @param raw raw frame
+* @param rawSize size of the raw frame
+* @param nMonomers number of monomers in the frame
+* @param positions replaced by the positions of the frame
+*/
+inline void BinaryTrajectoryCodec::decode(const char* raw, size_t rawSize, uint32_t nMonomers, std::vector<VectorInt3>& positions) const
+{
+    positions.resize(nMonomers);
+    if(nMonomers == 0){
+        return;
+    }
+
+    size_t pos(0);
+    int32_t values[3];
+
+    if(rawSize < sizeof(values)){
+        throw std::runtime_error("BinaryTrajectoryCodec: frame is too short");
+    }
+    std::memcpy(values, raw, sizeof(values));
+    pos+=sizeof(values);
+    positions[0].setAllCoordinates(values[0],values[1],values[2]);
+
+    for(uint32_t i=1; i<nMonomers; i++){
+        if(pos >= rawSize){
+            throw std::runtime_error("BinaryTrajectoryCodec: frame is too short");
+        }
+        const uint8_t code(uint8_t(raw[pos++]));
+        if(code < bondCode.getNumberOfCodes()){
+            positions[i]=positions[i-1]+bondCode.decode(code);
+        }else if(code == BondVectorCode::escapeCode && pos+sizeof(values) <= rawSize){
+            std::memcpy(values, raw+pos, sizeof(values));
+            pos+=sizeof(values);
+            positions[i].setAllCoordinates(values[0],values[1],values[2]);
+        }else{
+            throw std::runtime_error("BinaryTrajectoryCodec: invalid bond code");
+        }
+    }
+
+    if(pos != rawSize){
+        throw std::runtime_error("BinaryTrajectoryCodec: frame is too long");
+    }
+}
+
+/**
+* @param raw raw frame
+* @param stored compressed frame if the function returns true
+* @return true if the compressed frame is smaller than the raw frame
+*/
+inline bool BinaryTrajectoryCodec::compress(const std::vector<char>& raw, std::vector<char>& stored) const
+{
+#ifdef TANGLOTRON_WITH_ZLIB
+    if(raw.empty()){
+        return false;
+    }
+    uLongf storedSize(compressBound(raw.size()));
+    stored.resize(storedSize);
+    if(compress2(reinterpret_cast<Bytef*>(&stored[0]), &storedSize, reinterpret_cast<const Bytef*>(&raw[0]), raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK){
+        throw std::runtime_error("BinaryTrajectoryCodec: compression failed");
+    }
+    stored.resize(storedSize);
+    return stored.size() < raw.size();
+#else
+    (void)raw;
+    (void)stored;
+    return false;
+#endif
+}
+
+/**
+* @param stored compressed frame
+* @param storedSize size of the compressed frame
+* @param raw replaced by the raw frame
+* @param rawSize size of the raw frame
+*/
+inline void BinaryTrajectoryCodec::uncompress(const char* stored, size_t storedSize, std::vector<char>& raw, size_t rawSize) const
+{
+#ifdef TANGLOTRON_WITH_ZLIB
+    raw.resize(rawSize);
+    uLongf size(rawSize);
+    if(rawSize == 0 || ::uncompress(reinterpret_cast<Bytef*>(&raw[0]), &size, reinterpret_cast<const Bytef*>(stored), storedSize) != Z_OK || size != rawSize){
+        throw std::runtime_error("BinaryTrajectoryCodec: corrupt compressed frame");
+    }
+#else
+    (void)stored;
+    (void)storedSize;
+    (void)raw;
+    (void)rawSize;
+    throw std::runtime_error("BinaryTrajectoryCodec: compressed frame, but built without TANGLOTRON_WITH_ZLIB");
+#endif
+}
+
+/* ------------------------------------------------------------------------------ */
+
+inline BinaryTrajectoryWriter::~BinaryTrajectoryWriter()
+{
+    try{
+        close();
+    }catch(...){
+    }
+}
+
+/**
+* @details Appending to a file of a different structure fails. The index of
+* the existing file is invalidated first, so the file is readable by a scan if the run
+* is killed before close().
+*
+* @param filename_ output file
+* @param structure structure of the system, written to new files only
+* @param append continue an existing file instead of replacing it
+*/
+inline void BinaryTrajectoryWriter::open(const std::string& filename_, const BinaryTrajectoryStructure& structure, bool append)
+{
+    close();
+    filename=filename_;
+    nMonomers=structure.nMonomers;
+    frameOffsets.clear();
+    frameMcs.clear();
+    nRawBytes=0;
+    nStoredBytes=0;
+
+    bool exists(false);
+    if(append){
+        std::ifstream test(filename.c_str(), std::ios::binary | std::ios::ate);
+        exists=(test.is_open() && test.tellg() > 0);
+    }
+
+    if(exists){
+        BinaryTrajectoryReader reader;
+        reader.open(filename);
+        const std::string difference(reader.getStructure().difference(structure));
+        if(!difference.empty()){
+            throw std::runtime_error("BinaryTrajectoryWriter: cannot append to "+filename+" with a different "+difference);
+        }
+        for(uint64_t n=0; n<reader.getNumberOfFrames(); n++){
+            frameOffsets.push_back(reader.getFrameOffset(n));
+            frameMcs.push_back(reader.getMcs(n));
+        }
+        endOfFrames=reader.getEndOfFrames();
+
+        file.open(filename.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        if(reader.hasIndex()){
+            const uint64_t noMagic(0);
+            file.seekp(reader.getFileSize()-sizeof(noMagic));
+            file.write(reinterpret_cast<const char*>(&noMagic), sizeof(noMagic));
+            file.flush();
+        }
+        file.seekp(endOfFrames);
+    }else{
+        CheckpointWriter header;
+        header.write(uint64_t(BinaryTrajectoryCodec::fileMagic));
+        header.write(uint32_t(BinaryTrajectoryCodec::version));
+        CheckpointWriter content;
+        structure.save(content);
+        header.writeVector(content.getBuffer());
+
+        file.open(filename.c_str(), std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+        file.write(&header.getBuffer()[0], header.getBuffer().size());
+        endOfFrames=header.getBuffer().size();
+    }
+
+    if(!file.good()){
+        file.close();
+        throw std::runtime_error("BinaryTrajectoryWriter: cannot open "+filename);
+    }
+}
+
+inline void BinaryTrajectoryWriter::setCompression(bool compression_)
+{
+    if(compression_ && !BinaryTrajectoryCodec::isCompressionAvailable()){
+        throw std::runtime_error("BinaryTrajectoryWriter: compression needs a build with TANGLOTRON_WITH_ZLIB");
+    }
+    compression=compression_;
+}
+
+/**
+* @param molecules system to write, the mcs of the frame is molecules.getAge()
+*/
+template<class MoleculesType>
+inline void BinaryTrajectoryWriter::writeFrame(const MoleculesType& molecules)
+{
+    if(!file.is_open()){
+        throw std::runtime_error("BinaryTrajectoryWriter: no open file");
+    }
+    if(molecules.size() != nMonomers){
+        throw std::runtime_error("BinaryTrajectoryWriter: number of monomers differs from the structure");
+    }
+
+    codec.encode(molecules, raw);
+    const bool compressed(compression && codec.compress(raw, stored));
+    const std::vector<char>& frame(compressed ? stored : raw);
+
+    CheckpointWriter header;
+    header.write(uint32_t(BinaryTrajectoryCodec::recordMagic));
+    header.write(uint32_t(raw.size()));
+    header.write(uint64_t(molecules.getAge()));
+    header.write(uint32_t(frame.size()));
+
+    file.write(&header.getBuffer()[0], header.getBuffer().size());
+    if(!frame.empty()){
+        file.write(&frame[0], frame.size());
+    }
+    if(!file.good()){
+        throw std::runtime_error("BinaryTrajectoryWriter: cannot write to "+filename);
+    }
+
+    frameOffsets.push_back(endOfFrames);
+    frameMcs.push_back(molecules.getAge());
+    endOfFrames+=header.getBuffer().size()+frame.size();
+    nRawBytes+=raw.size();
+    nStoredBytes+=frame.size();
+}
+
+inline void BinaryTrajectoryWriter::close()
+{
+    if(!file.is_open()){
+        return;
+    }
+
+    CheckpointWriter index;
+    for(uint64_t n=0; n<frameOffsets.size(); n++){
+        index.write(frameOffsets[n]);
+        index.write(frameMcs[n]);
+    }
+    index.write(endOfFrames);
+    index.write(uint64_t(frameOffsets.size()));
+    index.write(uint64_t(BinaryTrajectoryCodec::indexMagic));
+
+    file.seekp(endOfFrames);
+    file.write(&index.getBuffer()[0], index.getBuffer().size());
+    file.flush();
+    const bool good(file.good());
+    file.close();
+    if(!good){
+        throw std::runtime_error("BinaryTrajectoryWriter: cannot write the index of "+filename);
+    }
+}
+
+/**
+* @details The file is cut behind the last kept frame, close() writes the index there.
+* Used to discard the frames written after a checkpoint of the run.
+*
+* @param mcs age of the last frame kept
+*/
+inline uint64_t BinaryTrajectoryWriter::removeFramesAfter(uint64_t mcs)
+{
+    if(!file.is_open()){
+        throw std::runtime_error("BinaryTrajectoryWriter: no open file");
+    }
+    const uint64_t nKept(std::upper_bound(frameMcs.begin(), frameMcs.end(), mcs)-frameMcs.begin());
+    const uint64_t nRemoved(frameOffsets.size()-nKept);
+    if(nRemoved == 0){
+        return 0;
+    }
+
+    endOfFrames=frameOffsets[nKept];
+    frameOffsets.resize(nKept);
+    frameMcs.resize(nKept);
+    file.flush();
+    if(!file.good() || ::truncate(filename.c_str(), endOfFrames) != 0){
+        throw std::runtime_error("BinaryTrajectoryWriter: cannot truncate "+filename);
+    }
+    file.seekp(endOfFrames);
+    return nRemoved;
+}
+
+/* ------------------------------------------------------------------------------ */
+
+inline void BinaryTrajectoryReader::open(const std::string& filename_)
+{
+    filename=filename_;
+    if(file.is_open()){
+        file.close();
+    }
+    file.clear();
+    file.open(filename.c_str(), std::ios::binary);
+    if(!file.is_open()){
+        throw std::runtime_error("BinaryTrajectoryReader: cannot open "+filename);
+    }
+    file.seekg(0, std::ios::end);
+    fileSize=file.tellg();
+
+    uint64_t magic(0);
+    uint32_t fileVersion(0);
+    uint64_t structureSize(0);
+    if(fileSize < sizeof(magic)+sizeof(fileVersion)+sizeof(structureSize)){
+        throw std::runtime_error("BinaryTrajectoryReader: "+filename+" is not a binary trajectory");
+    }
+    readBytes(0, &magic, sizeof(magic));
+    readBytes(sizeof(magic), &fileVersion, sizeof(fileVersion));
+    readBytes(sizeof(magic)+sizeof(fileVersion), &structureSize, sizeof(structureSize));
+    if(magic != BinaryTrajectoryCodec::fileMagic || fileVersion != BinaryTrajectoryCodec::version){
+        throw std::runtime_error("BinaryTrajectoryReader: "+filename+" is not a binary trajectory of version 1");
+    }
+
+    beginOfFrames=sizeof(magic)+sizeof(fileVersion)+sizeof(structureSize)+structureSize;
+    if(beginOfFrames > fileSize){
+        throw std::runtime_error("BinaryTrajectoryReader: header of "+filename+" is truncated");
+    }
+    std::vector<char> content(structureSize);
+    if(structureSize > 0){
+        readBytes(beginOfFrames-structureSize, &content[0], structureSize);
+    }
+    CheckpointReader contentReader(content);
+    structure.load(contentReader);
+
+    indexFound=frames.load(*this, beginOfFrames, fileSize);
+}
+
+/* ------------------------------------------------------------------------------ */
+
+/**
+* @param source object providing readBytes(offset,dest,n)
+* @param beginOfFrames file offset of the first frame record
+* @param fileSize size of the file
+* @return true if the index was found, false if the frames were scanned
+*/
+template<class SourceType>
+inline bool BinaryTrajectoryFrameTable::load(SourceType& source, uint64_t beginOfFrames, uint64_t fileSize)
+{
+    if(readIndex(source, beginOfFrames, fileSize)){
+        return true;
+    }
+    scanFrames(source, beginOfFrames, fileSize);
+    return false;
+}
+
+/**
+* @details The entries have to point to increasing offsets between the header and the
+* index. The records themselves are checked when a frame is read, so opening a large
+* file touches the index only.
+*/
+template<class SourceType>
+inline bool BinaryTrajectoryFrameTable::readIndex(SourceType& source, uint64_t beginOfFrames, uint64_t fileSize)
+{
+    offsets.clear();
+    mcs.clear();
+
+    if(fileSize < beginOfFrames+BinaryTrajectoryCodec::trailerSize){
+        return false;
+    }
+    uint64_t trailer[3];
+    source.readBytes(fileSize-BinaryTrajectoryCodec::trailerSize, trailer, sizeof(trailer));
+    const uint64_t indexOffset(trailer[0]), nFrames(trailer[1]);
+    if(trailer[2] != BinaryTrajectoryCodec::indexMagic || indexOffset < beginOfFrames ||
+       nFrames > (fileSize-indexOffset)/BinaryTrajectoryCodec::indexEntrySize ||
+       indexOffset+nFrames*BinaryTrajectoryCodec::indexEntrySize+BinaryTrajectoryCodec::trailerSize != fileSize){
+        return false;
+    }
+
+    std::vector<uint64_t> entries(2*nFrames);
+    if(nFrames > 0){
+        source.readBytes(indexOffset, &entries[0], nFrames*BinaryTrajectoryCodec::indexEntrySize);
+    }
+    for(uint64_t n=0; n<nFrames; n++){
+        const uint64_t offset(entries[2*n]);
+        if(offset < beginOfFrames || offset+BinaryTrajectoryCodec::recordHeaderSize > indexOffset ||
+           (n > 0 && offset <= offsets[n-1])){
+            offsets.clear();
+            mcs.clear();
+            return false;
+        }
+        offsets.push_back(offset);
+        mcs.push_back(entries[2*n+1]);
+    }
+    endOfFrames=indexOffset;
+    return true;
+}
+
+/**
+* @details Stops at the first incomplete record or at a record without recordMagic.
+*/
+template<class SourceType>
+inline void BinaryTrajectoryFrameTable::scanFrames(SourceType& source, uint64_t beginOfFrames, uint64_t fileSize)
+{
+    offsets.clear();
+    mcs.clear();
+
+    uint64_t offset(beginOfFrames);
+    while(offset+BinaryTrajectoryCodec::recordHeaderSize <= fileSize){
+        uint32_t magic(0), storedSize(0);
+        uint64_t frameMcs(0);
+        source.readBytes(offset, &magic, sizeof(magic));
+        source.readBytes(offset+8, &frameMcs, sizeof(frameMcs));
+        source.readBytes(offset+16, &storedSize, sizeof(storedSize));
+        if(magic != BinaryTrajectoryCodec::recordMagic || offset+BinaryTrajectoryCodec::recordHeaderSize+storedSize > fileSize){
+            break;
+        }
+        offsets.push_back(offset);
+        mcs.push_back(frameMcs);
+        offset+=BinaryTrajectoryCodec::recordHeaderSize+storedSize;
+    }
+    endOfFrames=offset;
+}
+
+/* ------------------------------------------------------------------------------ */
+
+/**
+* @param n index of the frame
+* @param positions_ replaced by the positions of the frame
+*/
+inline void BinaryTrajectoryReader::readFrame(uint64_t n, std::vector<VectorInt3>& positions_)
+{
+    const uint64_t offset(getFrameOffset(n));
+    uint32_t magic(0), rawSize(0), storedSize(0);
+    readBytes(offset, &magic, sizeof(magic));
+    readBytes(offset+4, &rawSize, sizeof(rawSize));
+    readBytes(offset+16, &storedSize, sizeof(storedSize));
+    if(magic != BinaryTrajectoryCodec::recordMagic){
+        throw std::runtime_error("BinaryTrajectoryReader: corrupt frame record in "+filename);
+    }
+
+    stored.resize(storedSize);
+    if(storedSize > 0){
+        readBytes(offset+BinaryTrajectoryCodec::recordHeaderSize, &stored[0], storedSize);
+    }
+
+    if(storedSize == rawSize){
+        codec.decode(stored.empty() ? 0 : &stored[0], storedSize, structure.nMonomers, positions_);
+    }else{
+        codec.uncompress(&stored[0], storedSize, raw, rawSize);
+        codec.decode(&raw[0], rawSize, structure.nMonomers, positions_);
+    }
+}
+
+/**
+* @param n index of the frame
+* @param molecules molecules with the number of monomers of the structure
+*/
+template<class MoleculesType>
+inline void BinaryTrajectoryReader::readFrame(uint64_t n, MoleculesType& molecules)
+{
+    if(molecules.size() != structure.nMonomers){
+        throw std::runtime_error("BinaryTrajectoryReader: number of monomers differs from the structure");
+    }
+    readFrame(n, positions);
+    for(uint32_t i=0; i<positions.size(); i++){
+        molecules[i].setAllCoordinates(positions[i].getX(), positions[i].getY(), positions[i].getZ());
+    }
+    molecules.setAge(getMcs(n));
+}
+
+inline void BinaryTrajectoryReader::readBytes(uint64_t offset, void* dest, size_t n)
+{
+    file.clear();
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(dest), n);
+    if(!file.good()){
+        throw std::runtime_error("BinaryTrajectoryReader: unexpected end of "+filename);
+    }
+}
+
+#endif //BINARY_TRAJECTORY_H
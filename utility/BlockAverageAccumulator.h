@@ -0,0 +1,354 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef BLOCK_AVERAGE_ACCUMULATOR_H
+#define BLOCK_AVERAGE_ACCUMULATOR_H
+/**
+* @file
+*
+* @class BlockAverageAccumulator
+*
+* @brief Online blocking analysis of a time series of one or more observables.
+*
+* @details Samples are added one by one. Level l holds the sums and the sums of
+* products of block averages over 2^l consecutive samples. Two neighboring blocks of
+* level l are averaged and passed to level l+1, so the memory is constant for a fixed
+* maximum number of levels and the cost per sample is constant on average.
+* The covariance of the mean estimated from level l includes the correlations
+* within blocks of length 2^l (Flyvbjerg and Petersen, J. Chem. Phys. 91, 461 (1989)).
+* The optimal level is chosen with the criterion of Lee, Needs and Towler
+* (Phys. Rev. B 83, 165112 (2011)): the smallest block length B with
+* B^3 > 2 n (sigma_B/sigma_1)^4.
+**/
+
+#include <stdint.h>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "Checkpoint.h"
+
+class BlockAverageAccumulator
+{
+public:
+
+    BlockAverageAccumulator(uint32_t nObservables_=1, uint32_t maxLevels_=48);
+
+    //! add one sample holding nObservables values
+    void addSample(const double* values);
+    //! add one sample for a single observable
+    void addSample(double value){ addSample(&value); }
+
+    //! number of observables per sample
+    uint32_t getNumberOfObservables() const { return nObservables; }
+    //! total number of samples
+    uint64_t getNumberOfSamples() const { return levels.empty() ? 0 : levels[0].count; }
+    //! mean of observable i over all samples
+    double getMean(uint32_t i) const;
+
+    //! number of levels holding at least one block
+    uint32_t getNumberOfLevels() const { return levels.size(); }
+    //! number of complete blocks at level l
+    uint64_t getNumberOfBlocks(uint32_t l) const { return levels.at(l).count; }
+    //! covariance of the means of observable i and j estimated from level l
+    double getCovarianceOfMean(uint32_t l, uint32_t i, uint32_t j) const;
+    //! standard error of the mean of observable i estimated from level l
+    double getErrorAtLevel(uint32_t l, uint32_t i) const { return std::sqrt(getCovarianceOfMean(l,i,i)); }
+
+    //! level of the plateau of the error of observable i, see isConverged()
+    uint32_t getOptimalLevel(uint32_t i) const;
+    //! true if the blocking criterion is fulfilled for observable i
+    bool isConverged(uint32_t i) const;
+    //! standard error of the mean of observable i without correlations
+    double getNaiveError(uint32_t i) const { return getErrorAtLevel(0,i); }
+    //! standard error of the mean of observable i including correlations
+    double getError(uint32_t i) const { return getErrorAtLevel(getOptimalLevel(i),i); }
+    //! integrated autocorrelation time of observable i in units of samples
+    double getCorrelationTime(uint32_t i) const;
+
+    //! reset all levels
+    void clear(){ levels.clear(); }
+
+    //! pool the blocks of an independent series of the same observables
+    void merge(const BlockAverageAccumulator& other);
+
+    //! append all levels to a checkpoint
+    void saveState(CheckpointWriter& checkpoint) const;
+    //! restore all levels from a checkpoint
+    void loadState(CheckpointReader& checkpoint);
+
+private:
+
+    //! sums of the block averages of one block length
+    struct Level {
+        uint64_t count;
+        bool hasPending;
+        std::vector<double> pending;
+        std::vector<double> sums;
+        std::vector<double> products;
+    };
+
+    //! number of observables per sample
+    uint32_t nObservables;
+
+    //! maximum number of levels, the last level collects all larger blocks
+    uint32_t maxLevels;
+
+    //! block data for block length 2^l
+    std::vector<Level> levels;
+
+    //! buffer for the average of two blocks
+    std::vector<double> blockBuffer;
+
+    //! helper function: add a block average to level l
+    void addToLevel(uint32_t l, const double* values);
+
+    //! helper function: index of the product of observable i and j
+    uint32_t productIndex(uint32_t i, uint32_t j) const { return (i<j) ? (j*(j+1))/2+i : (i*(i+1))/2+j; }
+};
+
+
+/**
+* @param nObservables_ number of observables per sample
+* @param maxLevels_ maximum number of levels, i.e. maximum block length 2^(maxLevels_-1)
+*/
+inline BlockAverageAccumulator::BlockAverageAccumulator(uint32_t nObservables_, uint32_t maxLevels_)
+:nObservables(nObservables_),maxLevels(maxLevels_),blockBuffer(nObservables_)
+{
+    if(nObservables==0 || maxLevels==0){
+        throw std::runtime_error("BlockAverageAccumulator: number of observables and levels must be positive");
+    }
+}
+
+/**
+* @param values array of nObservables values of this sample
+*/
+inline void BlockAverageAccumulator::addSample(const double* values)
+{
+    addToLevel(0,values);
+}
+
+inline void BlockAverageAccumulator::addToLevel(uint32_t l, const double* values)
+{
+    // new levels are only added on demand, so every level holds at least one block
+    if(l == levels.size()){
+        Level level;
+        level.count=0;
+        level.hasPending=false;
+        level.pending.assign(nObservables,0.0);
+        level.sums.assign(nObservables,0.0);
+        level.products.assign((nObservables*(nObservables+1))/2,0.0);
+        levels.push_back(level);
+    }
+
+    Level& level(levels[l]);
+    level.count++;
+    for(uint32_t i=0; i<nObservables; i++){
+        level.sums[i]+=values[i];
+        for(uint32_t j=0; j<=i; j++){
+            level.products[productIndex(i,j)]+=values[i]*values[j];
+        }
+    }
+
+    if(l+1 >= maxLevels){
+        return;
+    }
+
+    if(!level.hasPending){
+        for(uint32_t i=0; i<nObservables; i++){
+            level.pending[i]=values[i];
+        }
+        level.hasPending=true;
+    }else{
+        for(uint32_t i=0; i<nObservables; i++){
+            blockBuffer[i]=0.5*(level.pending[i]+values[i]);
+        }
+        level.hasPending=false;
+        // blockBuffer is copied on the next level before it is used again
+        addToLevel(l+1,&blockBuffer[0]);
+    }
+}
+
+inline double BlockAverageAccumulator::getMean(uint32_t i) const
+{
+    if(levels.empty()){
+        return 0.0;
+    }
+    return levels[0].sums.at(i)/double(levels[0].count);
+}
+
+/**
+* @details The sample covariance of the block averages of level l divided by the
+* number of blocks. Returns 0 if the level holds less than two blocks.
+*/
+inline double BlockAverageAccumulator::getCovarianceOfMean(uint32_t l, uint32_t i, uint32_t j) const
+{
+    const Level& level(levels.at(l));
+    if(level.count < 2){
+        return 0.0;
+    }
+    const double n(level.count);
+    const double covariance( (level.products[productIndex(i,j)] - level.sums.at(i)*level.sums.at(j)/n)/(n-1.0) );
+    return covariance/n;
+}
+
+/**
+* @details Returns the smallest level l with (2^l)^3 > 2 n (sigma_l/sigma_0)^4.
+* If no level fulfills the criterion, the highest level with at least two blocks is
+* returned and isConverged() is false.
+*/
+inline uint32_t BlockAverageAccumulator::getOptimalLevel(uint32_t i) const
+{
+    if(levels.empty()){
+        return 0;
+    }
+
+    const double n(levels[0].count);
+    const double variance0(getCovarianceOfMean(0,i,i));
+
+    uint32_t lastValid(0);
+    for(uint32_t l=0; l<levels.size(); l++){
+        if(levels[l].count < 2){
+            break;
+        }
+        lastValid=l;
+
+        // no fluctuations: every level is converged
+        if(variance0 <= 0.0){
+            return l;
+        }
+        const double ratio2(getCovarianceOfMean(l,i,i)/variance0);
+        const double blockLength(std::ldexp(1.0,l));
+        if(blockLength*blockLength*blockLength > 2.0*n*ratio2*ratio2){
+            return l;
+        }
+    }
+    return lastValid;
+}
+
+inline bool BlockAverageAccumulator::isConverged(uint32_t i) const
+{
+    if(levels.empty() || levels[0].count < 2){
+        return false;
+    }
+
+    const double n(levels[0].count);
+    const double variance0(getCovarianceOfMean(0,i,i));
+    if(variance0 <= 0.0){
+        return true;
+    }
+
+    const uint32_t l(getOptimalLevel(i));
+    const double ratio2(getCovarianceOfMean(l,i,i)/variance0);
+    const double blockLength(std::ldexp(1.0,l));
+    return (blockLength*blockLength*blockLength > 2.0*n*ratio2*ratio2);
+}
+
+/**
+* @details tau = 1/2 (sigma_opt/sigma_0)^2, i.e. tau=1/2 for uncorrelated samples.
+*/
+inline double BlockAverageAccumulator::getCorrelationTime(uint32_t i) const
+{
+    const double variance0(getCovarianceOfMean(0,i,i));
+    if(variance0 <= 0.0){
+        return 0.5;
+    }
+    return 0.5*getCovarianceOfMean(getOptimalLevel(i),i,i)/variance0;
+}
+
+/**
+* @details The block sums of every level are added, so the covariance of the mean is
+* estimated from the pooled blocks of both series. This is valid for independent series
+* of the same process, e.g. replicas of a simulation. Pending blocks of other are dropped.
+*
+* @param other accumulator with the same number of observables and levels
+*/
+inline void BlockAverageAccumulator::merge(const BlockAverageAccumulator& other)
+{
+    if(other.nObservables != nObservables || other.maxLevels != maxLevels){
+        throw std::runtime_error("BlockAverageAccumulator: cannot merge accumulators of different size");
+    }
+
+    for(uint32_t l=0; l<other.levels.size(); l++){
+        if(l == levels.size()){
+            Level level(other.levels[l]);
+            level.hasPending=false;
+            levels.push_back(level);
+            continue;
+        }
+
+        levels[l].count+=other.levels[l].count;
+        for(uint32_t i=0; i<levels[l].sums.size(); i++){
+            levels[l].sums[i]+=other.levels[l].sums[i];
+        }
+        for(uint32_t i=0; i<levels[l].products.size(); i++){
+            levels[l].products[i]+=other.levels[l].products[i];
+        }
+    }
+}
+
+inline void BlockAverageAccumulator::saveState(CheckpointWriter& checkpoint) const
+{
+    checkpoint.write(nObservables);
+    checkpoint.write(maxLevels);
+    checkpoint.write(uint32_t(levels.size()));
+    for(uint32_t l=0; l<levels.size(); l++){
+        checkpoint.write(levels[l].count);
+        checkpoint.write(uint8_t(levels[l].hasPending ? 1 : 0));
+        checkpoint.writeVector(levels[l].pending);
+        checkpoint.writeVector(levels[l].sums);
+        checkpoint.writeVector(levels[l].products);
+    }
+}
+
+inline void BlockAverageAccumulator::loadState(CheckpointReader& checkpoint)
+{
+    uint32_t savedObservables(0), savedMaxLevels(0), nLevels(0);
+    checkpoint.read(savedObservables);
+    checkpoint.read(savedMaxLevels);
+    checkpoint.read(nLevels);
+    if(savedObservables != nObservables || savedMaxLevels != maxLevels || nLevels > maxLevels){
+        throw std::runtime_error("BlockAverageAccumulator: checkpoint does not match the number of observables or levels");
+    }
+
+    levels.resize(nLevels);
+    for(uint32_t l=0; l<nLevels; l++){
+        uint8_t hasPending(0);
+        checkpoint.read(levels[l].count);
+        checkpoint.read(hasPending);
+        levels[l].hasPending=(hasPending != 0);
+        checkpoint.readVector(levels[l].pending);
+        checkpoint.readVector(levels[l].sums);
+        checkpoint.readVector(levels[l].products);
+        if( levels[l].pending.size() != nObservables || levels[l].sums.size() != nObservables ||
+            levels[l].products.size() != (nObservables*(nObservables+1))/2 ){
+            throw std::runtime_error("BlockAverageAccumulator: corrupt level in checkpoint");
+        }
+    }
+}
+
+#endif //BLOCK_AVERAGE_ACCUMULATOR_H
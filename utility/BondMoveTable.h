@@ -0,0 +1,160 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef BOND_MOVE_TABLE_H
+#define BOND_MOVE_TABLE_H
+/**
+* @file
+*
+* @class BondMoveTable
+*
+* @brief Lookup table answering which local moves keep a bond inside the classic BFM
+* bondset.
+*
+* @details For every bond vector b from a monomer to one of its neighbors the table
+* stores a six bit mask: bit d is set if b-step(d) is still a classic bond after the
+* monomer jumped by step(d). The steps are ordered as in MoveLocalSc and
+* UpdaterSimulatorForceSampling: +x,-x,+y,-y,+z,-z. The moves allowed by all bonds of a
+* monomer are the AND of the masks of its neighbors, one lookup per neighbor.
+*
+* The table covers bond vectors with components in [-4,4] indexed by
+* (x&15)+((y&15)<<4)+((z&15)<<8), larger vectors allow no move.
+**/
+
+#include <stdint.h>
+#include <vector>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+
+class BondMoveTable
+{
+public:
+
+    BondMoveTable();
+
+    //! mask of all six directions
+    static uint8_t allMoves() { return 0x3F; }
+
+    //! index of a unit vector in the order +x,-x,+y,-y,+z,-z
+    static uint32_t getDirectionIndex(const VectorInt3& dir)
+    {
+        return (dir.getX()!=0) ? ((dir.getX()>0) ? 0 : 1) :
+               (dir.getY()!=0) ? ((dir.getY()>0) ? 2 : 3) :
+                                 ((dir.getZ()>0) ? 4 : 5);
+    }
+
+    //! unit vector of direction index d in the order +x,-x,+y,-y,+z,-z
+    static VectorInt3 getDirection(uint32_t d)
+    {
+        const int32_t sign((d & 1) ? -1 : 1);
+        return VectorInt3((d < 2) ? sign : 0, (d == 2 || d == 3) ? sign : 0, (d > 3) ? sign : 0);
+    }
+
+    //! check if a bond vector is part of the classic BFM bondset
+    bool isClassicBond(const VectorInt3& bond) const
+    {
+        return isInRange(bond) && ((moveMasks[encode(bond)] & classicFlag) != 0);
+    }
+
+    //! mask of the directions keeping bond classic if its start monomer jumps
+    uint8_t getMoveMask(const VectorInt3& bond) const
+    {
+        return isInRange(bond) ? (moveMasks[encode(bond)] & allMoves()) : 0;
+    }
+
+    //! mask of the directions keeping all bonds of monomer idx classic
+    template<class MoleculesType>
+    uint8_t getAllowedMoves(const MoleculesType& molecules, uint32_t idx) const;
+
+private:
+
+    //! flag in moveMasks marking the bond vector itself as classic
+    static const uint8_t classicFlag=0x40;
+
+    //! components in [-4,4]
+    static bool isInRange(const VectorInt3& bond)
+    {
+        return uint32_t(bond.getX()+4) <= 8 && uint32_t(bond.getY()+4) <= 8 && uint32_t(bond.getZ()+4) <= 8;
+    }
+
+    static uint32_t encode(const VectorInt3& bond)
+    {
+        return uint32_t(bond.getX() & 15) | (uint32_t(bond.getY() & 15) << 4) | (uint32_t(bond.getZ() & 15) << 8);
+    }
+
+    //! classic bond: squared length 4, 5, 6, 9 or 10 and components in [-3,3]
+    static bool isClassic(int32_t x, int32_t y, int32_t z)
+    {
+        if(x < -3 || x > 3 || y < -3 || y > 3 || z < -3 || z > 3){
+            return false;
+        }
+        const int32_t length2(x*x+y*y+z*z);
+        return length2==4 || length2==5 || length2==6 || length2==9 || length2==10;
+    }
+
+    //! move masks and classicFlag indexed by encode()
+    std::vector<uint8_t> moveMasks;
+};
+
+
+inline BondMoveTable::BondMoveTable():moveMasks(4096,0)
+{
+    const int32_t steps[6][3]={{1,0,0},{-1,0,0},{0,1,0},{0,-1,0},{0,0,1},{0,0,-1}};
+
+    for(int32_t x=-4; x<=4; x++){
+        for(int32_t y=-4; y<=4; y++){
+            for(int32_t z=-4; z<=4; z++){
+                uint8_t mask(isClassic(x,y,z) ? uint8_t(classicFlag) : uint8_t(0));
+                for(uint32_t d=0; d<6; d++){
+                    if(isClassic(x-steps[d][0], y-steps[d][1], z-steps[d][2])){
+                        mask|=uint8_t(1u << d);
+                    }
+                }
+                moveMasks[encode(VectorInt3(x,y,z))]=mask;
+            }
+        }
+    }
+}
+
+/**
+* @param molecules molecules providing positions and links
+* @param idx index of the monomer
+* @return bit d set if the jump step(d) keeps all bonds of idx classic
+*/
+template<class MoleculesType>
+inline uint8_t BondMoveTable::getAllowedMoves(const MoleculesType& molecules, uint32_t idx) const
+{
+    uint8_t allowed(allMoves());
+    const uint32_t nLinks(molecules.getNumLinks(idx));
+    for(uint32_t n=0; n<nLinks; n++){
+        allowed&=getMoveMask(molecules[molecules.getNeighborIdx(idx,n)]-molecules[idx]);
+    }
+    return allowed;
+}
+
+#endif //BOND_MOVE_TABLE_H
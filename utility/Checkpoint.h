@@ -0,0 +1,249 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+/**
+* @file
+*
+* @brief Binary checkpoints of the complete state of a run.
+*
+* @details A checkpoint is a flat byte buffer. Components of a run derive from
+* AbstractCheckpointable and append their state with a CheckpointWriter in saveState().
+* On restart the same components read it back in the same order with a CheckpointReader
+* in loadState(). Values are stored in the native byte order, so a checkpoint is meant
+* to be resumed on the same kind of machine.
+*
+* CheckpointWriter::writeFile() writes to a temporary file which is renamed afterwards,
+* so a job killed while writing leaves the previous checkpoint intact.
+*
+* The signal handler checkpointSignalHandler() only sets the flag returned by
+* checkpointSignalFlag(), which is polled by UpdaterCheckpoint between two tasks.
+**/
+
+#include <stdint.h>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+class CheckpointWriter
+{
+public:
+
+    //! append a value of a trivially copyable type
+    template<class T>
+    void write(const T& value);
+
+    //! append the size and the elements of a vector of a trivially copyable type
+    template<class T>
+    void writeVector(const std::vector<T>& values);
+
+    //! append the size and the characters of a string
+    void writeString(const std::string& value);
+
+    //! write the buffer atomically to filename
+    void writeFile(const std::string& filename) const;
+
+    const std::vector<char>& getBuffer() const { return buffer; }
+
+    //! empty the buffer, keeps the allocated memory
+    void clear(){ buffer.clear(); }
+
+private:
+
+    std::vector<char> buffer;
+};
+
+
+class CheckpointReader
+{
+public:
+
+    CheckpointReader():position(0){}
+    explicit CheckpointReader(const std::vector<char>& buffer_):buffer(buffer_),position(0){}
+
+    //! read a value of a trivially copyable type
+    template<class T>
+    void read(T& value);
+
+    //! read a vector written by CheckpointWriter::writeVector
+    template<class T>
+    void readVector(std::vector<T>& values);
+
+    //! read a string written by CheckpointWriter::writeString
+    void readString(std::string& value);
+
+    //! replace the buffer by the content of filename, returns false if the file cannot be opened
+    bool readFile(const std::string& filename);
+
+    //! true if the complete buffer was read
+    bool isAtEnd() const { return position == buffer.size(); }
+
+private:
+
+    //! helper function: copy the next n bytes to dest
+    void readBytes(void* dest, size_t n);
+
+    std::vector<char> buffer;
+    size_t position;
+};
+
+
+class AbstractCheckpointable
+{
+public:
+    virtual ~AbstractCheckpointable(){}
+
+    //! append the state to the checkpoint
+    virtual void saveState(CheckpointWriter& checkpoint) const=0;
+
+    //! restore the state from the checkpoint
+    virtual void loadState(CheckpointReader& checkpoint)=0;
+};
+
+
+//! flag set by checkpointSignalHandler()
+inline volatile std::sig_atomic_t& checkpointSignalFlag()
+{
+    static volatile std::sig_atomic_t flag=0;
+    return flag;
+}
+
+//! signal handler requesting a checkpoint and the end of the run, e.g. for SIGTERM
+inline void checkpointSignalHandler(int)
+{
+    checkpointSignalFlag()=1;
+}
+
+
+template<class T>
+inline void CheckpointWriter::write(const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "CheckpointWriter: type is not trivially copyable");
+    const char* bytes(reinterpret_cast<const char*>(&value));
+    buffer.insert(buffer.end(), bytes, bytes+sizeof(T));
+}
+
+template<class T>
+inline void CheckpointWriter::writeVector(const std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "CheckpointWriter: type is not trivially copyable");
+    write(uint64_t(values.size()));
+    if(!values.empty()){
+        const char* bytes(reinterpret_cast<const char*>(&values[0]));
+        buffer.insert(buffer.end(), bytes, bytes+sizeof(T)*values.size());
+    }
+}
+
+inline void CheckpointWriter::writeString(const std::string& value)
+{
+    write(uint64_t(value.size()));
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+/**
+* @param filename checkpoint file, the temporary file is filename.tmp
+*/
+inline void CheckpointWriter::writeFile(const std::string& filename) const
+{
+    const std::string tmpFilename(filename+".tmp");
+    {
+        std::ofstream file(tmpFilename.c_str(), std::ios::binary | std::ios::trunc);
+        if(!buffer.empty()){
+            file.write(&buffer[0], buffer.size());
+        }
+        file.flush();
+        if(!file.good()){
+            throw std::runtime_error("CheckpointWriter: cannot write "+tmpFilename);
+        }
+    }
+    if(std::rename(tmpFilename.c_str(), filename.c_str()) != 0){
+        throw std::runtime_error("CheckpointWriter: cannot rename "+tmpFilename+" to "+filename);
+    }
+}
+
+template<class T>
+inline void CheckpointReader::read(T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "CheckpointReader: type is not trivially copyable");
+    readBytes(&value, sizeof(T));
+}
+
+template<class T>
+inline void CheckpointReader::readVector(std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "CheckpointReader: type is not trivially copyable");
+    uint64_t size(0);
+    read(size);
+    if(size > (buffer.size()-position)/sizeof(T)){
+        throw std::runtime_error("CheckpointReader: unexpected end of checkpoint");
+    }
+    values.resize(size);
+    if(size > 0){
+        readBytes(&values[0], sizeof(T)*size);
+    }
+}
+
+inline void CheckpointReader::readString(std::string& value)
+{
+    uint64_t size(0);
+    read(size);
+    if(size > buffer.size()-position){
+        throw std::runtime_error("CheckpointReader: unexpected end of checkpoint");
+    }
+    value.assign(buffer.begin()+position, buffer.begin()+position+size);
+    position+=size;
+}
+
+inline bool CheckpointReader::readFile(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file.is_open()){
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    position=0;
+    return true;
+}
+
+inline void CheckpointReader::readBytes(void* dest, size_t n)
+{
+    if(n > buffer.size()-position){
+        throw std::runtime_error("CheckpointReader: unexpected end of checkpoint");
+    }
+    std::memcpy(dest, &buffer[position], n);
+    position+=n;
+}
+
+#endif //CHECKPOINT_H
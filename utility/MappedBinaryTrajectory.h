@@ -0,0 +1,380 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef MAPPED_BINARY_TRAJECTORY_H
+#define MAPPED_BINARY_TRAJECTORY_H
+/**
+* @file
+*
+* @class MappedBinaryTrajectory
+*
+* @brief Read-only memory map of a binary trajectory for offline analysis.
+*
+* @details The file is mapped once and every frame is a FrameView pointing into the
+* mapping, so iterating over the frames copies and allocates nothing. The positions
+* of a frame are decoded on demand by a BinaryTrajectoryFrameDecoder, which reuses its
+* buffers from frame to frame. Views and decoders are independent of each other, so
+* several threads can work on the frames of one mapping, each with its own decoder.
+*
+* The frame offsets are taken from the index of the file or, if it is missing, from a
+* scan of the frame records, by the BinaryTrajectoryFrameTable shared with
+* BinaryTrajectoryReader. The mapping is advised for sequential access. bfm files are
+* converted to binary trajectories by convertBinaryTrajectory first.
+*
+* POSIX only (mmap).
+**/
+
+#include <stdint.h>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <LeMonADE/utility/Vector3D.h>
+
+#include "BinaryTrajectory.h"
+
+
+class MappedBinaryTrajectoryFrameReader;
+
+class MappedBinaryTrajectory
+{
+public:
+
+    //! reads the positions of frames, one per thread, see ForceTrajectoryEvaluator
+    typedef MappedBinaryTrajectoryFrameReader FrameReader;
+
+    /**
+    * @brief View of one frame inside the mapped file, valid as long as the mapping.
+    **/
+    class FrameView
+    {
+    public:
+        FrameView():index(0),mcs(0),rawSize(0),storedSize(0),data(0){}
+        FrameView(uint64_t index_, uint64_t mcs_, uint32_t rawSize_, uint32_t storedSize_, const char* data_)
+        :index(index_),mcs(mcs_),rawSize(rawSize_),storedSize(storedSize_),data(data_){}
+
+        uint64_t getIndex() const { return index; }
+        uint64_t getMcs() const { return mcs; }
+        uint32_t getRawSize() const { return rawSize; }
+        uint32_t getStoredSize() const { return storedSize; }
+        bool isCompressed() const { return storedSize != rawSize; }
+
+        //! stored bytes of the frame inside the mapping
+        const char* getData() const { return data; }
+
+    private:
+        uint64_t index;
+        uint64_t mcs;
+        uint32_t rawSize;
+        uint32_t storedSize;
+        const char* data;
+    };
+
+    /**
+    * @brief Iterator over the frames, dereferencing gives a FrameView.
+    **/
+    class const_iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef FrameView value_type;
+        typedef int64_t difference_type;
+        typedef void pointer;
+        typedef FrameView reference;
+
+        const_iterator():trajectory(0),n(0){}
+        const_iterator(const MappedBinaryTrajectory* trajectory_, uint64_t n_):trajectory(trajectory_),n(n_){}
+
+        FrameView operator*() const { return trajectory->getFrame(n); }
+        FrameView operator[](int64_t d) const { return trajectory->getFrame(n+d); }
+
+        const_iterator& operator++(){ n++; return *this; }
+        const_iterator operator++(int){ const_iterator old(*this); n++; return old; }
+        const_iterator& operator--(){ n--; return *this; }
+        const_iterator operator--(int){ const_iterator old(*this); n--; return old; }
+        const_iterator& operator+=(int64_t d){ n+=d; return *this; }
+        const_iterator& operator-=(int64_t d){ n-=d; return *this; }
+        const_iterator operator+(int64_t d) const { return const_iterator(trajectory,n+d); }
+        const_iterator operator-(int64_t d) const { return const_iterator(trajectory,n-d); }
+        int64_t operator-(const const_iterator& other) const { return int64_t(n)-int64_t(other.n); }
+
+        bool operator==(const const_iterator& other) const { return n == other.n && trajectory == other.trajectory; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+        bool operator<(const const_iterator& other) const { return n < other.n; }
+
+    private:
+        const MappedBinaryTrajectory* trajectory;
+        uint64_t n;
+    };
+
+    MappedBinaryTrajectory():fileDescriptor(-1),mapping(0),fileSize(0),indexFound(false){}
+    explicit MappedBinaryTrajectory(const std::string& filename_);
+    ~MappedBinaryTrajectory(){ close(); }
+
+    //! map filename, replaces an open mapping
+    void open(const std::string& filename_);
+
+    //! unmap and close the file
+    void close();
+
+    bool isOpen() const { return mapping != 0; }
+
+    const BinaryTrajectoryStructure& getStructure() const { return structure; }
+
+    uint64_t getNumberOfFrames() const { return frames.offsets.size(); }
+
+    //! view of frame n
+    FrameView getFrame(uint64_t n) const;
+
+    //! mcs of frame n
+    uint64_t getMcs(uint64_t n) const { return getFrame(n).getMcs(); }
+
+    const_iterator begin() const { return const_iterator(this,0); }
+    const_iterator end() const { return const_iterator(this,frames.offsets.size()); }
+
+    //! true if the index was read from the file, false if it was rebuilt
+    bool hasIndex() const { return indexFound; }
+
+    uint64_t getFileSize() const { return fileSize; }
+
+private:
+
+    //! no copies of the mapping
+    MappedBinaryTrajectory(const MappedBinaryTrajectory&);
+    MappedBinaryTrajectory& operator=(const MappedBinaryTrajectory&);
+
+    //! helper function: copy a value at offset from the mapping
+    template<class T>
+    T read(uint64_t offset) const
+    {
+        T value;
+        std::memcpy(&value, mapping+offset, sizeof(T));
+        return value;
+    }
+
+    friend class BinaryTrajectoryFrameTable;
+
+    //! helper function: copy n bytes at offset from the mapping
+    void readBytes(uint64_t offset, void* dest, size_t n) const
+    {
+        std::memcpy(dest, mapping+offset, n);
+    }
+
+    std::string filename;
+
+    int fileDescriptor;
+    const char* mapping;
+    uint64_t fileSize;
+
+    BinaryTrajectoryStructure structure;
+
+    bool indexFound;
+    BinaryTrajectoryFrameTable frames;
+};
+
+
+/**
+* @class BinaryTrajectoryFrameDecoder
+*
+* @brief Decode frames of a MappedBinaryTrajectory into positions.
+*
+* @details The buffers grow to the size of the largest frame and are reused, so
+* decoding allocates nothing after the first frame. One decoder per thread.
+**/
+class BinaryTrajectoryFrameDecoder
+{
+public:
+
+    //! positions of a frame with nMonomers monomers
+    const std::vector<VectorInt3>& decode(const MappedBinaryTrajectory::FrameView& frame, uint32_t nMonomers);
+
+    //! set positions and age of molecules to a frame
+    template<class MoleculesType>
+    void apply(const MappedBinaryTrajectory::FrameView& frame, MoleculesType& molecules);
+
+    //! positions of the frame decoded last
+    const std::vector<VectorInt3>& getPositions() const { return positions; }
+
+private:
+
+    BinaryTrajectoryCodec codec;
+    std::vector<char> raw;
+    std::vector<VectorInt3> positions;
+};
+
+
+/**
+* @class MappedBinaryTrajectoryFrameReader
+*
+* @brief Positions of frames of a MappedBinaryTrajectory by frame index.
+*
+* @details Same interface as BfmTrajectory::FrameReader, so ForceTrajectoryEvaluator
+* reads both kinds of trajectories. One reader per thread.
+**/
+class MappedBinaryTrajectoryFrameReader
+{
+public:
+
+    explicit MappedBinaryTrajectoryFrameReader(const MappedBinaryTrajectory& trajectory_):trajectory(trajectory_){}
+
+    //! positions of frame n
+    const std::vector<VectorInt3>& read(uint64_t n)
+    {
+        return decoder.decode(trajectory.getFrame(n), trajectory.getStructure().nMonomers);
+    }
+
+private:
+
+    const MappedBinaryTrajectory& trajectory;
+    BinaryTrajectoryFrameDecoder decoder;
+};
+
+
+/* ------------------------------------------------------------------------------ */
+
+inline MappedBinaryTrajectory::MappedBinaryTrajectory(const std::string& filename_)
+:fileDescriptor(-1)
+,mapping(0)
+,fileSize(0)
+,indexFound(false)
+{
+    open(filename_);
+}
+
+/**
+* @param filename_ binary trajectory written by BinaryTrajectoryWriter
+*/
+inline void MappedBinaryTrajectory::open(const std::string& filename_)
+{
+    close();
+    filename=filename_;
+
+    fileDescriptor=::open(filename.c_str(), O_RDONLY);
+    if(fileDescriptor < 0){
+        throw std::runtime_error("MappedBinaryTrajectory: cannot open "+filename);
+    }
+    struct stat status;
+    if(fstat(fileDescriptor, &status) != 0){
+        close();
+        throw std::runtime_error("MappedBinaryTrajectory: cannot read the size of "+filename);
+    }
+    fileSize=status.st_size;
+
+    const uint64_t headerSize(sizeof(uint64_t)+sizeof(uint32_t)+sizeof(uint64_t));
+    if(fileSize < headerSize){
+        close();
+        throw std::runtime_error("MappedBinaryTrajectory: "+filename+" is not a binary trajectory");
+    }
+
+    void* address(mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0));
+    if(address == MAP_FAILED){
+        close();
+        throw std::runtime_error("MappedBinaryTrajectory: cannot map "+filename);
+    }
+    mapping=static_cast<const char*>(address);
+    madvise(address, fileSize, MADV_SEQUENTIAL);
+
+    const uint64_t structureSize(read<uint64_t>(sizeof(uint64_t)+sizeof(uint32_t)));
+    if(read<uint64_t>(0) != BinaryTrajectoryCodec::fileMagic || read<uint32_t>(sizeof(uint64_t)) != BinaryTrajectoryCodec::version ||
+       structureSize > fileSize-headerSize){
+        close();
+        throw std::runtime_error("MappedBinaryTrajectory: "+filename+" is not a binary trajectory of version 1");
+    }
+
+    CheckpointReader content(std::vector<char>(mapping+headerSize, mapping+headerSize+structureSize));
+    structure.load(content);
+
+    indexFound=frames.load(*this, headerSize+structureSize, fileSize);
+}
+
+inline void MappedBinaryTrajectory::close()
+{
+    if(mapping != 0){
+        munmap(const_cast<char*>(mapping), fileSize);
+        mapping=0;
+    }
+    if(fileDescriptor >= 0){
+        ::close(fileDescriptor);
+        fileDescriptor=-1;
+    }
+    frames=BinaryTrajectoryFrameTable();
+    fileSize=0;
+}
+
+/**
+* @param n index of the frame
+*/
+inline MappedBinaryTrajectory::FrameView MappedBinaryTrajectory::getFrame(uint64_t n) const
+{
+    const uint64_t offset(frames.offsets.at(n));
+    if(read<uint32_t>(offset) != BinaryTrajectoryCodec::recordMagic ||
+       offset+BinaryTrajectoryCodec::recordHeaderSize+read<uint32_t>(offset+16) > fileSize){
+        throw std::runtime_error("MappedBinaryTrajectory: corrupt frame record in "+filename);
+    }
+    return FrameView(n, read<uint64_t>(offset+8), read<uint32_t>(offset+4), read<uint32_t>(offset+16),
+                     mapping+offset+BinaryTrajectoryCodec::recordHeaderSize);
+}
+
+/* ------------------------------------------------------------------------------ */
+
+/**
+* @param frame view of the frame
+* @param nMonomers number of monomers of the structure
+*/
+inline const std::vector<VectorInt3>& BinaryTrajectoryFrameDecoder::decode(const MappedBinaryTrajectory::FrameView& frame, uint32_t nMonomers)
+{
+    if(frame.isCompressed()){
+        codec.uncompress(frame.getData(), frame.getStoredSize(), raw, frame.getRawSize());
+        codec.decode(raw.data(), frame.getRawSize(), nMonomers, positions);
+    }else{
+        codec.decode(frame.getData(), frame.getRawSize(), nMonomers, positions);
+    }
+    return positions;
+}
+
+/**
+* @param frame view of the frame
+* @param molecules molecules of the structure of the trajectory
+*/
+template<class MoleculesType>
+inline void BinaryTrajectoryFrameDecoder::apply(const MappedBinaryTrajectory::FrameView& frame, MoleculesType& molecules)
+{
+    decode(frame, molecules.size());
+    for(uint32_t i=0; i<positions.size(); i++){
+        molecules[i].setAllCoordinates(positions[i].getX(), positions[i].getY(), positions[i].getZ());
+    }
+    molecules.setAge(frame.getMcs());
+}
+
+#endif //MAPPED_BINARY_TRAJECTORY_H
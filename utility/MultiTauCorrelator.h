@@ -0,0 +1,292 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by 
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        | 
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+
+#ifndef MULTI_TAU_CORRELATOR_H
+#define MULTI_TAU_CORRELATOR_H
+/**
+* @file
+*
+* @class MultiTauCorrelator
+*
+* @brief Online autocorrelation function of an observable on logarithmically spaced lags.
+*
+* @details Multiple-tau correlator of Ramirez, Sukumaran, Vorselaars and Likhtman
+* (J. Chem. Phys. 133, 154103 (2010)). Level l holds the last pointsPerLevel block
+* averages over averaging^l consecutive samples in a ring buffer and correlates every
+* new block with the ones before, which gives the lags j*averaging^l. Level 0 covers
+* the lags 0 to pointsPerLevel-1, every further level the lags
+* pointsPerLevel/averaging to pointsPerLevel-1 in its block length. Every averaging
+* blocks of a level are averaged and passed to the next level.
+*
+* So a series of T samples needs memory of order pointsPerLevel*log(T), and the cost
+* per sample is constant on average. Longer lags are correlated from block averages,
+* which smooths the correlation function there.
+*
+* The observable may be a vector of dimension components, the correlation is the scalar
+* product. getCorrelation() returns the autocorrelation of the fluctuations
+* (<x(0).x(t)> - <x>^2)/(<x^2> - <x>^2), with the mean taken over all samples.
+**/
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdexcept>
+#include <vector>
+
+
+class MultiTauCorrelator
+{
+public:
+
+    MultiTauCorrelator(uint32_t dimension_=1, uint32_t pointsPerLevel_=16, uint32_t averaging_=2, uint32_t maxLevels_=40);
+
+    //! add one sample holding dimension values
+    void addSample(const double* values);
+    //! add one sample of a scalar observable
+    void addSample(double value){ addSample(&value); }
+
+    uint32_t getDimension() const { return dimension; }
+    uint32_t getPointsPerLevel() const { return pointsPerLevel; }
+    uint32_t getAveraging() const { return averaging; }
+
+    //! total number of samples
+    uint64_t getNumberOfSamples() const { return nSamples; }
+    //! number of levels holding at least one block
+    uint32_t getNumberOfLevels() const { return levels.size(); }
+    //! mean of component k over all samples
+    double getMean(uint32_t k) const { return (nSamples > 0) ? sums.at(k)/double(nSamples) : 0.0; }
+    //! variance <x^2> - <x>^2 summed over all components
+    double getVariance() const;
+
+    //! lags in units of samples and the normalized autocorrelation of the fluctuations
+    void getCorrelation(std::vector<uint64_t>& lags, std::vector<double>& correlation) const;
+
+    //! integrated autocorrelation time 1/2 + sum C(t) in units of samples, windowed at t >= 5 tau, see getCorrelation()
+    double getIntegratedTime() const;
+
+    //! reset all levels and samples
+    void clear();
+
+private:
+
+    //! ring buffer and correlation sums of one block length
+    struct Level {
+        std::vector<double> shift;
+        std::vector<double> correlation;
+        std::vector<uint64_t> count;
+        std::vector<double> accumulator;
+        uint32_t nAccumulated;
+        uint32_t head;
+        uint32_t nValues;
+    };
+
+    //! number of components of the observable
+    uint32_t dimension;
+
+    //! number of lags per level
+    uint32_t pointsPerLevel;
+
+    //! number of blocks averaged into one block of the next level
+    uint32_t averaging;
+
+    //! maximum number of levels
+    uint32_t maxLevels;
+
+    std::vector<Level> levels;
+
+    uint64_t nSamples;
+
+    //! sum of every component and of the squared norm over all samples
+    std::vector<double> sums;
+    double sumSquares;
+
+    //! buffer for the block average passed to the next level
+    std::vector<double> blockBuffer;
+};
+
+
+/**
+* @param dimension_ number of components of the observable
+* @param pointsPerLevel_ number of lags per level, a multiple of averaging_
+* @param averaging_ number of blocks averaged into one block of the next level
+* @param maxLevels_ maximum number of levels, i.e. maximum lag pointsPerLevel_*averaging_^(maxLevels_-1)
+*/
+inline MultiTauCorrelator::MultiTauCorrelator(uint32_t dimension_, uint32_t pointsPerLevel_, uint32_t averaging_, uint32_t maxLevels_)
+:dimension(dimension_),pointsPerLevel(pointsPerLevel_),averaging(averaging_),maxLevels(maxLevels_),
+ nSamples(0),sums(dimension_,0.0),sumSquares(0.0),blockBuffer(dimension_,0.0)
+{
+    if(dimension==0 || maxLevels==0){
+        throw std::runtime_error("MultiTauCorrelator: dimension and number of levels must be positive");
+    }
+    if(averaging < 2 || pointsPerLevel < averaging || (pointsPerLevel % averaging) != 0){
+        throw std::runtime_error("MultiTauCorrelator: points per level must be a multiple of the averaging of at least 2");
+    }
+}
+
+/**
+* @param values array of dimension values of this sample
+*/
+inline void MultiTauCorrelator::addSample(const double* values)
+{
+    nSamples++;
+    for(uint32_t k=0; k<dimension; k++){
+        sums[k]+=values[k];
+        sumSquares+=values[k]*values[k];
+    }
+
+    const double* block(values);
+    for(uint32_t l=0; l<maxLevels; l++){
+        // new levels are only added on demand, so every level holds at least one block
+        if(l == levels.size()){
+            Level level;
+            level.shift.assign(pointsPerLevel*dimension,0.0);
+            level.correlation.assign(pointsPerLevel,0.0);
+            level.count.assign(pointsPerLevel,0);
+            level.accumulator.assign(dimension,0.0);
+            level.nAccumulated=0;
+            level.head=0;
+            level.nValues=0;
+            levels.push_back(level);
+        }
+        Level& level(levels[l]);
+
+        // insert the block as newest entry of the ring buffer
+        double* const newest(&level.shift[level.head*dimension]);
+        for(uint32_t k=0; k<dimension; k++){
+            newest[k]=block[k];
+            level.accumulator[k]+=block[k];
+        }
+        if(level.nValues < pointsPerLevel){
+            level.nValues++;
+        }
+
+        // correlate with the older entries, lags below pointsPerLevel/averaging are covered by the level below
+        for(uint32_t j=((l == 0) ? 0 : pointsPerLevel/averaging); j<level.nValues; j++){
+            const double* const older(&level.shift[((level.head+pointsPerLevel-j) % pointsPerLevel)*dimension]);
+            double product(0.0);
+            for(uint32_t k=0; k<dimension; k++){
+                product+=newest[k]*older[k];
+            }
+            level.correlation[j]+=product;
+            level.count[j]++;
+        }
+        level.head=(level.head+1) % pointsPerLevel;
+
+        // pass the average of the last averaging blocks to the next level
+        level.nAccumulated++;
+        if(level.nAccumulated < averaging){
+            return;
+        }
+        for(uint32_t k=0; k<dimension; k++){
+            blockBuffer[k]=level.accumulator[k]/double(averaging);
+            level.accumulator[k]=0.0;
+        }
+        level.nAccumulated=0;
+        block=blockBuffer.data();
+    }
+}
+
+inline double MultiTauCorrelator::getVariance() const
+{
+    if(nSamples == 0){
+        return 0.0;
+    }
+    double meanSquared(0.0);
+    for(uint32_t k=0; k<dimension; k++){
+        meanSquared+=getMean(k)*getMean(k);
+    }
+    return sumSquares/double(nSamples)-meanSquared;
+}
+
+/**
+* @details The lags are increasing, lags without any product are left out. For a
+* constant observable the variance vanishes and the correlation is 0 for all lags.
+*
+* @param lags lags in units of samples
+* @param correlation normalized autocorrelation for every lag, 1 at lag 0
+*/
+inline void MultiTauCorrelator::getCorrelation(std::vector<uint64_t>& lags, std::vector<double>& correlation) const
+{
+    lags.clear();
+    correlation.clear();
+
+    double meanSquared(0.0);
+    for(uint32_t k=0; k<dimension; k++){
+        meanSquared+=getMean(k)*getMean(k);
+    }
+    const double variance(getVariance());
+
+    uint64_t blockLength(1);
+    for(uint32_t l=0; l<levels.size(); l++, blockLength*=averaging){
+        for(uint32_t j=((l == 0) ? 0 : pointsPerLevel/averaging); j<pointsPerLevel; j++){
+            if(levels[l].count[j] == 0){
+                continue;
+            }
+            lags.push_back(j*blockLength);
+            correlation.push_back( (variance > 0.0) ? (levels[l].correlation[j]/double(levels[l].count[j])-meanSquared)/variance : 0.0 );
+        }
+    }
+}
+
+/**
+* @details tau = 1/2 + sum of the normalized autocorrelation C(t) over the lags t>=1, so
+* uncorrelated samples give 1/2 and the error of the mean is sqrt(2 tau var/N). Lags
+* beyond the first level stand for the lags between them and the previous point. The
+* sum is cut off at the first lag t >= 5 tau, which bounds the noise of the tail
+* without the bias of stopping at the first negative C(t). Anticorrelated series can
+* give less than 1/2 and are clamped at 0, as are series without fluctuations.
+*/
+inline double MultiTauCorrelator::getIntegratedTime() const
+{
+    std::vector<uint64_t> lags;
+    std::vector<double> correlation;
+    getCorrelation(lags, correlation);
+
+    if(lags.size() < 2 || getVariance() <= 0.0){
+        return 0.0;
+    }
+
+    const double window(5.0);
+    double time(0.5);
+    for(uint32_t n=1; n<lags.size(); n++){
+        time+=correlation[n]*double(lags[n]-lags[n-1]);
+        if(double(lags[n]) >= window*time){
+            break;
+        }
+    }
+    return std::max(time,0.0);
+}
+
+inline void MultiTauCorrelator::clear()
+{
+    levels.clear();
+    nSamples=0;
+    sums.assign(dimension,0.0);
+    sumSquares=0.0;
+}
+
+#endif //MULTI_TAU_CORRELATOR_H
@@ -0,0 +1,171 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef PHILOX_4X32_H
+#define PHILOX_4X32_H
+/**
+* @file
+*
+* @class Philox4x32
+*
+* @brief Counter-based random number generator Philox4x32-10.
+*
+* @details Philox (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC11)
+* encrypts a 128 bit counter with a 64 bit key in ten rounds and returns four 32 bit
+* numbers per counter value. The key is the master seed. The upper 64 bit of the counter
+* hold two stream ids, e.g. replica and thread, and the lower 64 bit count the blocks of
+* a stream. Every combination of seed and stream ids is an independent sequence of 2^66
+* numbers, so parallel runs are reproducible without sharing state between threads.
+*
+* The class fulfills the requirements of a UniformRandomBitGenerator. For the hot path
+* fill() writes a batch of numbers at once. The complete state is trivially copyable and
+* can be stored in a checkpoint with getState() and setState().
+**/
+
+#include <stdint.h>
+#include <cstddef>
+
+
+class Philox4x32
+{
+public:
+
+    typedef uint32_t result_type;
+
+    //! complete state of the generator
+    struct State {
+        uint32_t key[2];
+        uint32_t counter[4];
+        uint32_t buffer[4];
+        uint32_t bufferPosition;
+    };
+
+    explicit Philox4x32(uint64_t seed=0, uint32_t stream0=0, uint32_t stream1=0){ setSeed(seed,stream0,stream1); }
+
+    //! restart with master seed and stream ids
+    void setSeed(uint64_t seed, uint32_t stream0=0, uint32_t stream1=0);
+
+    //! next random number
+    uint32_t operator()();
+
+    //! write n random numbers to out
+    void fill(uint32_t* out, size_t n);
+
+    //! random number in [0,range) from a 32 bit random number, without division
+    static uint32_t scale(uint32_t random, uint32_t range){ return uint32_t((uint64_t(random)*range)>>32); }
+
+    //! encrypt counter with key in place, the bijection all numbers are derived from
+    static void block(uint32_t counter[4], const uint32_t key[2]);
+
+    const State& getState() const { return state; }
+    void setState(const State& state_){ state=state_; }
+
+    static constexpr uint32_t min(){ return 0; }
+    static constexpr uint32_t max(){ return 0xFFFFFFFFu; }
+
+private:
+
+    State state;
+
+    //! helper function: fill the buffer from the current counter and increment the counter
+    void nextBlock(uint32_t out[4]);
+};
+
+
+inline void Philox4x32::setSeed(uint64_t seed, uint32_t stream0, uint32_t stream1)
+{
+    state.key[0]=uint32_t(seed);
+    state.key[1]=uint32_t(seed>>32);
+    state.counter[0]=0;
+    state.counter[1]=0;
+    state.counter[2]=stream0;
+    state.counter[3]=stream1;
+    state.buffer[0]=state.buffer[1]=state.buffer[2]=state.buffer[3]=0;
+    state.bufferPosition=4;
+}
+
+/**
+* @details Ten rounds of the Philox S-box with the multipliers and Weyl constants of
+* Random123.
+*/
+inline void Philox4x32::block(uint32_t counter[4], const uint32_t key[2])
+{
+    uint32_t k0(key[0]), k1(key[1]);
+    for(uint32_t round=0; round<10; round++){
+        const uint64_t product0(uint64_t(0xD2511F53u)*counter[0]);
+        const uint64_t product1(uint64_t(0xCD9E8D57u)*counter[2]);
+        const uint32_t c1(counter[1]), c3(counter[3]);
+        counter[0]=uint32_t(product1>>32)^c1^k0;
+        counter[1]=uint32_t(product1);
+        counter[2]=uint32_t(product0>>32)^c3^k1;
+        counter[3]=uint32_t(product0);
+        k0+=0x9E3779B9u;
+        k1+=0xBB67AE85u;
+    }
+}
+
+inline void Philox4x32::nextBlock(uint32_t out[4])
+{
+    for(uint32_t i=0; i<4; i++){
+        out[i]=state.counter[i];
+    }
+    block(out,state.key);
+
+    // the lower 64 bit count the blocks, the stream ids are never touched
+    if(++state.counter[0] == 0){
+        ++state.counter[1];
+    }
+}
+
+inline uint32_t Philox4x32::operator()()
+{
+    if(state.bufferPosition >= 4){
+        nextBlock(state.buffer);
+        state.bufferPosition=0;
+    }
+    return state.buffer[state.bufferPosition++];
+}
+
+/**
+* @details Numbers left in the buffer are used first, so fill() and operator() can be
+* mixed and give the same sequence.
+*/
+inline void Philox4x32::fill(uint32_t* out, size_t n)
+{
+    size_t i(0);
+    while(i < n && state.bufferPosition < 4){
+        out[i++]=state.buffer[state.bufferPosition++];
+    }
+    for(; i+4 <= n; i+=4){
+        nextBlock(out+i);
+    }
+    while(i < n){
+        out[i++]=(*this)();
+    }
+}
+
+#endif //PHILOX_4X32_H
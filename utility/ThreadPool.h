@@ -0,0 +1,127 @@
+/*--------------------------------------------------------------------------------
+    ooo      L   attice-based  |
+  o\.|./o    e   xtensible     | LeMonADE: An Open Source Implementation of the
+ o\.\|/./o   Mon te-Carlo      |           Bond-Fluctuation-Model for Polymers
+oo---0---oo  A   lgorithm and  |
+ o/./|\.\o   D   evelopment    | Copyright (C) 2013-2015 by
+  o/.|.\o    E   nvironment    | LeMonADE Principal Developers
+    ooo                        |
+----------------------------------------------------------------------------------
+
+This file is part of LeMonADE.
+
+LeMonADE is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+LeMonADE is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LeMonADE.  If not, see <http://www.gnu.org/licenses/>.
+
+--------------------------------------------------------------------------------*/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+/**
+* @file
+*
+* @class ThreadPool
+*
+* @brief Run a number of independent tasks on a fixed number of threads.
+*
+* @details The threads take the next task from a shared atomic counter until all tasks
+* are done, so tasks of different length are balanced without a queue. An exception
+* thrown by a task stops the remaining tasks and is rethrown by run() in the calling
+* thread.
+**/
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool
+{
+public:
+
+    //! nThreads_ threads, 0 uses the number of cores
+    explicit ThreadPool(uint32_t nThreads_=0);
+
+    //! run task(i) for i in [0,nTasks), returns when all tasks are done
+    void run(uint32_t nTasks, const std::function<void(uint32_t)>& task);
+
+    uint32_t getNumberOfThreads() const { return nThreads; }
+
+private:
+
+    //! number of threads
+    uint32_t nThreads;
+};
+
+
+/**
+* @param nThreads_ number of threads, 0 uses std::thread::hardware_concurrency()
+*/
+inline ThreadPool::ThreadPool(uint32_t nThreads_):nThreads(nThreads_)
+{
+    if(nThreads == 0){
+        nThreads=std::thread::hardware_concurrency();
+    }
+    if(nThreads == 0){
+        nThreads=1;
+    }
+}
+
+/**
+* @details The calling thread works on the tasks as well, so at most nThreads-1
+* threads are started.
+*
+* @param nTasks number of tasks
+* @param task function called with the index of the task
+*/
+inline void ThreadPool::run(uint32_t nTasks, const std::function<void(uint32_t)>& task)
+{
+    std::atomic<uint32_t> nextTask(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker=[&](){
+        for(uint32_t i=nextTask++; i<nTasks; i=nextTask++){
+            try{
+                task(i);
+            }catch(...){
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error){
+                    error=std::current_exception();
+                }
+                nextTask=nTasks;
+            }
+        }
+    };
+
+    const uint32_t nWorkers(std::min(nThreads,nTasks));
+    std::vector<std::thread> threads;
+    for(uint32_t t=1; t<nWorkers; t++){
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for(uint32_t t=0; t<threads.size(); t++){
+        threads[t].join();
+    }
+
+    if(error){
+        std::rethrow_exception(error);
+    }
+}
+
+#endif //THREAD_POOL_H